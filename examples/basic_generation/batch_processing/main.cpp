@@ -50,19 +50,37 @@ void generate_forest_example() {
     // Measure generation time
     const auto start_time = std::chrono::high_resolution_clock::now();
     
-    // Generate all trees
-    auto results = generator.generate_batch(tree_params);
+    // Generate all trees straight into atlas pages, cropped to their bounds
+    const AtlasLayout layout{512, 512, 1};
+    auto [atlas, results] = generator.generate_atlas(tree_params, layout);
     
     const auto end_time = std::chrono::high_resolution_clock::now();
     const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
         end_time - start_time);
     
+    // UV table for the engine, one row per tree
+    std::ofstream uv_file("forest_atlas.csv");
+    atlas.write_uv_table(uv_file);
+    
+    // Encode the pages on background threads while the statistics are gathered
+    ImageExporter<uint32_t> exporter;
+    std::vector<std::future<void>> page_writes;
+    for (size_t page = 0; page < atlas.pages.size(); ++page) {
+        page_writes.push_back(exporter.submit("forest_atlas_" + std::to_string(page) + ".qoi",
+                                              std::move(atlas.pages[page]), ImageFormat::Qoi));
+    }
+    
     // Calculate statistics
     size_t total_branches = 0;
     size_t total_leaves = 0;
     float total_gen_time = 0.0f;
+    size_t sprite_pixels = 0;
     
-    for (const auto& [buffer, metadata] : results) {
+    for (const auto& entry : atlas.entries) {
+        sprite_pixels += static_cast<size_t>(entry.rect.width()) * static_cast<size_t>(entry.rect.height());
+    }
+    
+    for (const auto& metadata : results) {
         total_branches += metadata.branch_count;
         total_leaves += metadata.leaf_count;
         total_gen_time += metadata.generation_time_ms;
@@ -75,6 +93,14 @@ void generate_forest_example() {
     std::cout << "Total generation time: " << duration.count() << "ms\n";
     std::cout << "Average per tree: " << (duration.count() / float(forest_size)) << "ms\n";
     std::cout << "Trees per second: " << (forest_size * 1000.0f / duration.count()) << "\n";
+    std::cout << "Atlas pages: " << atlas.pages.size() << " x " << layout.page_width << "x" << layout.page_height
+              << " (" << (100.0f * sprite_pixels / (atlas.pages.size() * layout.page_width * layout.page_height))
+              << "% filled), UVs in forest_atlas.csv\n";
+    
+    for (auto& write : page_writes) {
+        write.get();
+    }
+    std::cout << "Atlas pages written to forest_atlas_*.qoi\n";
 }
 
 // Demonstrate async generation
@@ -147,7 +173,7 @@ int main() {
     std::cout << "PixelTree Advanced Examples\n";
     std::cout << "=============================\n";
     std::cout << "Library version: " << pixeltree::version_string() << "\n";
-    std::cout << "SIMD support: " << (pixeltree::has_simd_support() ? "Yes" : "No") << "\n";
+    std::cout << "SIMD support: " << pixeltree::simd::to_string(pixeltree::simd_level()) << "\n";
     std::cout << "OpenMP support: " << (pixeltree::has_openmp_support() ? "Yes" : "No") << "\n\n";
     
     try {
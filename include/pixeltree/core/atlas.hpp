@@ -0,0 +1,236 @@
+#pragma once
+#include "pixel_buffer.hpp"
+#include "pixel_format.hpp"
+#include "rasterizer.hpp"
+#include "tree_renderer.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace pixeltree {
+
+// Page size and spacing of a sprite atlas
+struct AtlasLayout {
+    int page_width = 1024;
+    int page_height = 1024;
+    int padding = 1;            // Transparent pixels kept between neighbouring sprites
+};
+
+// Shelf packer for sprite rectangles
+//
+// Sprites are placed tallest first onto horizontal shelves. Each goes on the
+// first shelf it fits on, a new shelf is opened below the last one of a page
+// when none fits, and a new page is started when no page has room.
+// Placements depend only on the sizes, in input order.
+class ShelfPacker {
+public:
+    struct Placement {
+        size_t page = 0;
+        Point2Di position;      // Top-left pixel inside the page
+    };
+    
+    explicit ShelfPacker(const AtlasLayout& layout) : layout_(layout) {
+        if (layout.page_width <= 0 || layout.page_height <= 0 || layout.padding < 0) {
+            throw std::invalid_argument("Invalid atlas layout");
+        }
+    }
+    
+    // Place sprites of the given sizes (x = width, y = height) and return
+    // their placements in input order. Empty sizes reserve nothing; a sprite
+    // larger than a page throws std::invalid_argument.
+    std::vector<Placement> pack(const std::vector<Point2Di>& sizes) {
+        std::vector<size_t> order(sizes.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) {
+            return sizes[a].y > sizes[b].y;
+        });
+        
+        std::vector<Placement> placements(sizes.size());
+        for (size_t index : order) {
+            const Point2Di size = sizes[index];
+            if (size.x <= 0 || size.y <= 0) {
+                continue;
+            }
+            if (size.x > layout_.page_width || size.y > layout_.page_height) {
+                throw std::invalid_argument("Sprite larger than an atlas page");
+            }
+            placements[index] = place(size);
+        }
+        return placements;
+    }
+    
+    size_t page_count() const noexcept { return pages_.size(); }
+
+private:
+    struct Shelf {
+        int y;
+        int height;             // Height of its first (tallest) sprite
+        int cursor;             // Next free x
+    };
+    
+    struct Page {
+        std::vector<Shelf> shelves;
+        int next_y = 0;         // Top of the next shelf
+    };
+    
+    Placement place(Point2Di size) {
+        for (size_t index = 0; index < pages_.size(); ++index) {
+            Page& page = pages_[index];
+            for (Shelf& shelf : page.shelves) {
+                if (size.y <= shelf.height && shelf.cursor + size.x <= layout_.page_width) {
+                    const Placement placement{index, {shelf.cursor, shelf.y}};
+                    shelf.cursor += size.x + layout_.padding;
+                    return placement;
+                }
+            }
+            if (page.next_y + size.y <= layout_.page_height) {
+                return open_shelf(index, size);
+            }
+        }
+        
+        pages_.emplace_back();
+        return open_shelf(pages_.size() - 1, size);
+    }
+    
+    Placement open_shelf(size_t index, Point2Di size) {
+        Page& page = pages_[index];
+        page.shelves.push_back(Shelf{page.next_y, size.y, size.x + layout_.padding});
+        const Placement placement{index, {0, page.next_y}};
+        page.next_y += size.y + layout_.padding;
+        return placement;
+    }
+    
+    AtlasLayout layout_;
+    std::vector<Page> pages_;
+};
+
+// Where one sprite of a SpriteAtlas lives
+struct AtlasEntry {
+    static constexpr size_t no_page = std::numeric_limits<size_t>::max();
+    
+    size_t page = no_page;      // no_page when the sprite has no pixels
+    Rect2Di rect;               // Pixels inside the page (max exclusive)
+    Point2Di canvas_origin;     // Canvas position of rect.min, as CroppedSprite::origin
+    float u0 = 0.0f, v0 = 0.0f;     // rect in normalized page coordinates
+    float u1 = 0.0f, v1 = 0.0f;
+};
+
+// Cropped sprites packed into large pages, plus their UV table
+template<typename PixelType = uint32_t>
+struct SpriteAtlas {
+    std::vector<PixelBuffer<PixelType>> pages;
+    std::vector<AtlasEntry> entries;    // One per sprite, in input order
+    
+    // Pack canvas rectangles (e.g. TreeRenderer::crop_rect of each tree) and
+    // allocate transparent pages; nothing is drawn yet, see target()
+    static SpriteAtlas reserve(const std::vector<Rect2Di>& canvas_rects, const AtlasLayout& layout = {}) {
+        std::vector<Point2Di> sizes;
+        sizes.reserve(canvas_rects.size());
+        for (const Rect2Di& rect : canvas_rects) {
+            sizes.push_back({rect.width(), rect.height()});
+        }
+        
+        ShelfPacker packer(layout);
+        const auto placements = packer.pack(sizes);
+        
+        SpriteAtlas atlas;
+        atlas.pages.reserve(packer.page_count());
+        for (size_t page = 0; page < packer.page_count(); ++page) {
+            atlas.pages.emplace_back(static_cast<size_t>(layout.page_width), static_cast<size_t>(layout.page_height));
+            atlas.pages.back().clear(PixelTraits<PixelType>::from_rgba(0x00000000));
+        }
+        
+        const float inv_width = 1.0f / static_cast<float>(layout.page_width);
+        const float inv_height = 1.0f / static_cast<float>(layout.page_height);
+        atlas.entries.resize(canvas_rects.size());
+        for (size_t index = 0; index < canvas_rects.size(); ++index) {
+            AtlasEntry& entry = atlas.entries[index];
+            entry.canvas_origin = canvas_rects[index].min;
+            if (sizes[index].x <= 0 || sizes[index].y <= 0) {
+                continue;
+            }
+            
+            const Point2Di position = placements[index].position;
+            entry.page = placements[index].page;
+            entry.rect = Rect2Di{position, {position.x + sizes[index].x, position.y + sizes[index].y}};
+            entry.u0 = static_cast<float>(entry.rect.min.x) * inv_width;
+            entry.v0 = static_cast<float>(entry.rect.min.y) * inv_height;
+            entry.u1 = static_cast<float>(entry.rect.max.x) * inv_width;
+            entry.v1 = static_cast<float>(entry.rect.max.y) * inv_height;
+        }
+        return atlas;
+    }
+    
+    // Pack the sprites of generate_batch output, each cropped to its
+    // metadata bounding box as by generate_cropped
+    template<typename Metadata>
+    static SpriteAtlas pack(const std::vector<std::pair<PixelBuffer<PixelType>, Metadata>>& sprites,
+                            const AtlasLayout& layout = {}) {
+        std::vector<Rect2Di> rects;
+        rects.reserve(sprites.size());
+        for (const auto& [pixels, metadata] : sprites) {
+            rects.push_back(TreeRenderer::crop_rect(metadata.bounding_box, static_cast<int>(pixels.width()),
+                                                    static_cast<int>(pixels.height())));
+        }
+        
+        SpriteAtlas atlas = reserve(rects, layout);
+        for (size_t index = 0; index < sprites.size(); ++index) {
+            const AtlasEntry& entry = atlas.entries[index];
+            if (entry.page == AtlasEntry::no_page) {
+                continue;
+            }
+            
+            const PixelBuffer<PixelType>& source = sprites[index].first;
+            const RasterTarget<PixelType> destination = atlas.target(index);
+            for (int y = rects[index].min.y; y < rects[index].max.y; ++y) {
+                std::copy_n(&source(static_cast<size_t>(rects[index].min.x), static_cast<size_t>(y)),
+                            static_cast<size_t>(rects[index].width()),
+                            destination.row(y) + (rects[index].min.x - destination.origin.x));
+            }
+        }
+        return atlas;
+    }
+    
+    // Page window reserved for entry `index`, addressed in that sprite's
+    // canvas coordinates, so a renderer can draw the tree straight into it.
+    // Entries without a page give an empty target.
+    RasterTarget<PixelType> target(size_t index) {
+        const AtlasEntry& entry = entries[index];
+        RasterTarget<PixelType> result;
+        if (entry.page == AtlasEntry::no_page) {
+            return result;
+        }
+        
+        PixelBuffer<PixelType>& page = pages[entry.page];
+        result.stride = page.width();
+        result.pixels = page.data() + static_cast<size_t>(entry.rect.min.y) * result.stride
+                      + static_cast<size_t>(entry.rect.min.x);
+        result.origin = entry.canvas_origin;
+        result.clip = Rect2Di{entry.canvas_origin, {entry.canvas_origin.x + entry.rect.width(),
+                                                    entry.canvas_origin.y + entry.rect.height()}};
+        return result;
+    }
+    
+    // UV table as CSV, one row per entry in input order; entries without
+    // pixels have page -1
+    void write_uv_table(std::ostream& out) const {
+        out << "index,page,x,y,width,height,u0,v0,u1,v1,origin_x,origin_y\n";
+        for (size_t index = 0; index < entries.size(); ++index) {
+            const AtlasEntry& entry = entries[index];
+            out << index << ','
+                << (entry.page == AtlasEntry::no_page ? -1 : static_cast<long long>(entry.page)) << ','
+                << entry.rect.min.x << ',' << entry.rect.min.y << ','
+                << entry.rect.width() << ',' << entry.rect.height() << ','
+                << entry.u0 << ',' << entry.v0 << ',' << entry.u1 << ',' << entry.v1 << ','
+                << entry.canvas_origin.x << ',' << entry.canvas_origin.y << '\n';
+        }
+    }
+};
+
+using SpriteAtlas32 = SpriteAtlas<uint32_t>;
+
+} // namespace pixeltree
@@ -0,0 +1,148 @@
+#pragma once
+#include "math_types.hpp"
+#include "random.hpp"
+#include <cmath>
+#include <cstdint>
+
+namespace pixeltree {
+
+class SpanRasterizer;
+class FixedRasterizer;
+
+// Geometry policies for TreeGenerator and the renderers
+//
+// FloatGeometry is the float pipeline, reproducible wherever float rounding
+// is: IEEE binary32 without FMA contraction (the build passes
+// -ffp-contract=off, but code that includes the headers with other flags may
+// not). FixedGeometry grows the skeleton, places and colors the leaves and
+// rasterizes the hard-edged Pixel style in integers only, so its pixels are
+// the same for every compiler, flag set and CPU. Its trees still store float
+// coordinates, all on the 1/256 pixel grid and therefore exact.
+struct FloatGeometry {
+    static constexpr bool fixed_point = false;
+    using Rasterizer = SpanRasterizer;
+};
+
+struct FixedGeometry {
+    static constexpr bool fixed_point = true;
+    using Rasterizer = FixedRasterizer;
+};
+
+struct FixedSinCos {
+    int32_t sin, cos;               // 2.30
+};
+
+// Integer arithmetic of the FixedGeometry path
+//
+// Canvas coordinates and sizes are 24.8 (`fraction_bits`), unit vectors,
+// sines and cosines 2.30, angles (in degrees) and factors 16.16. Products
+// are formed in 64 bits and rounded to nearest. Floats are converted only
+// where values enter or leave the fixed path, never per pixel.
+class FixedPoint {
+public:
+    static constexpr int fraction_bits = 8;
+    static constexpr int32_t one = 1 << fraction_bits;
+    static constexpr int unit_bits = 30;
+    static constexpr int scale_bits = 16;
+    
+    // Nearest multiple of 2^-bits, as an integer (exact for every float)
+    static int64_t from_float(float value, int bits = fraction_bits) noexcept {
+        return std::llround(std::ldexp(static_cast<double>(value), bits));
+    }
+    
+    static float to_float(int64_t value, int bits = fraction_bits) noexcept {
+        return std::ldexp(static_cast<float>(value), -bits);
+    }
+    
+    // Point moved to the nearest 24.8 grid position
+    static Point2Df snap(Point2Df point) noexcept {
+        return Point2Df{to_float(from_float(point.x)), to_float(from_float(point.y))};
+    }
+    
+    // a * b / 2^shift, rounded to nearest
+    static constexpr int64_t mul(int64_t a, int64_t b, int shift) noexcept {
+        return (a * b + (int64_t{1} << (shift - 1))) >> shift;
+    }
+    
+    // a / 2^shift, rounded to nearest
+    static constexpr int64_t shift_round(int64_t a, int shift) noexcept {
+        return (a + (int64_t{1} << (shift - 1))) >> shift;
+    }
+    
+    static constexpr int64_t floor_div(int64_t a, int64_t b) noexcept {
+        const int64_t quotient = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? quotient - 1 : quotient;
+    }
+    
+    static constexpr int64_t ceil_div(int64_t a, int64_t b) noexcept {
+        return -floor_div(-a, b);
+    }
+    
+    // floor(sqrt(value))
+    static constexpr uint64_t isqrt(uint64_t value) noexcept {
+        uint64_t result = 0;
+        uint64_t bit = uint64_t{1} << 62;
+        while (bit > value) {
+            bit >>= 2;
+        }
+        while (bit != 0) {
+            if (value >= result + bit) {
+                value -= result + bit;
+                result = (result >> 1) + bit;
+            } else {
+                result >>= 1;
+            }
+            bit >>= 2;
+        }
+        return result;
+    }
+    
+    // Value in [lo, hi) from one raw draw; consumes the RNG like
+    // Random::next_float(lo, hi) and lands within 2^-24 of the range of it
+    static int64_t draw(const Random& rng, int64_t lo, int64_t hi) noexcept {
+        return lo + (((hi - lo) * static_cast<int64_t>(rng.next_uint() >> 8)) >> 24);
+    }
+    
+    // Sine and cosine of an angle in 16.16 degrees: exact quarter-turn
+    // reduction, then Taylor polynomials to x^9 / x^10 (error below 2^-28)
+    static constexpr FixedSinCos sincos_degrees(int64_t degrees) noexcept {
+        constexpr int64_t quarter = int64_t{90} << scale_bits;
+        constexpr int64_t eighth = int64_t{45} << scale_bits;
+        constexpr int64_t radians_per_degree = 1228166276394;     // pi / 180 in 18.46
+        constexpr int64_t unit = int64_t{1} << unit_bits;
+        
+        const int64_t quadrant = floor_div(degrees + eighth, quarter);
+        const int64_t x = mul(degrees - quadrant * quarter, radians_per_degree, 46 - unit_bits + scale_bits);
+        const int64_t z = mul(x, x, unit_bits);
+        
+        int64_t s = unit - z / 72;
+        s = unit - mul(z, s, unit_bits) / 42;
+        s = unit - mul(z, s, unit_bits) / 20;
+        s = unit - mul(z, s, unit_bits) / 6;
+        const auto sine = static_cast<int32_t>(mul(x, s, unit_bits));
+        
+        int64_t c = unit - z / 90;
+        c = unit - mul(z, c, unit_bits) / 56;
+        c = unit - mul(z, c, unit_bits) / 30;
+        c = unit - mul(z, c, unit_bits) / 12;
+        c = unit - mul(z, c, unit_bits) / 2;
+        const auto cosine = static_cast<int32_t>(c);
+        
+        switch (quadrant & 3) {
+            case 0:  return {sine, cosine};
+            case 1:  return {cosine, -sine};
+            case 2:  return {-sine, -cosine};
+            default: return {-cosine, sine};
+        }
+    }
+    
+    // 2.30 vector rotated by a 16.16 angle in degrees
+    static constexpr void rotate(int64_t& x, int64_t& y, int64_t degrees) noexcept {
+        const FixedSinCos rotation = sincos_degrees(degrees);
+        const int64_t rotated_x = shift_round(x * rotation.cos - y * rotation.sin, unit_bits);
+        y = shift_round(x * rotation.sin + y * rotation.cos, unit_bits);
+        x = rotated_x;
+    }
+};
+
+} // namespace pixeltree
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace pixeltree {
+
+// Vector-like container with inline, fixed-capacity storage
+//
+// Elements live inside the object itself, so a FixedVector on the stack (or
+// embedded in a stack object) never touches the heap. Supports the subset of
+// the std::vector interface the tree structures use; exceeding the capacity
+// throws std::length_error.
+template<typename T, size_t Capacity>
+class FixedVector {
+    static_assert(Capacity > 0, "FixedVector needs a non-zero capacity");
+    
+    alignas(T) unsigned char storage_[Capacity * sizeof(T)];
+    size_t size_ = 0;
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+    
+    FixedVector() noexcept = default;
+    
+    FixedVector(const FixedVector& other) {
+        for (const auto& value : other) {
+            push_back(value);
+        }
+    }
+    
+    FixedVector(FixedVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        for (auto& value : other) {
+            emplace_back(std::move(value));
+        }
+        other.clear();
+    }
+    
+    FixedVector& operator=(const FixedVector& other) {
+        if (this != &other) {
+            clear();
+            for (const auto& value : other) {
+                push_back(value);
+            }
+        }
+        return *this;
+    }
+    
+    FixedVector& operator=(FixedVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (this != &other) {
+            clear();
+            for (auto& value : other) {
+                emplace_back(std::move(value));
+            }
+            other.clear();
+        }
+        return *this;
+    }
+    
+    ~FixedVector() { clear(); }
+    
+    // Capacity
+    static constexpr size_t capacity() noexcept { return Capacity; }
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    
+    void reserve(size_t count) const {
+        if (count > Capacity) {
+            throw std::length_error("FixedVector capacity exceeded");
+        }
+    }
+    
+    // Modifiers
+    template<typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == Capacity) {
+            throw std::length_error("FixedVector capacity exceeded");
+        }
+        T* slot = ::new (static_cast<void*>(storage_ + size_ * sizeof(T))) T(std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+    }
+    
+    template<typename Iterator>
+    void assign(Iterator first, Iterator last) {
+        clear();
+        for (; first != last; ++first) {
+            emplace_back(*first);
+        }
+    }
+    
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+    
+    void pop_back() noexcept {
+        --size_;
+        data()[size_].~T();
+    }
+    
+    void clear() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = 0; i < size_; ++i) {
+                data()[i].~T();
+            }
+        }
+        size_ = 0;
+    }
+    
+    // Element access
+    T* data() noexcept { return std::launder(reinterpret_cast<T*>(storage_)); }
+    const T* data() const noexcept { return std::launder(reinterpret_cast<const T*>(storage_)); }
+    
+    T& operator[](size_t index) noexcept { return data()[index]; }
+    const T& operator[](size_t index) const noexcept { return data()[index]; }
+    
+    T& front() noexcept { return data()[0]; }
+    const T& front() const noexcept { return data()[0]; }
+    T& back() noexcept { return data()[size_ - 1]; }
+    const T& back() const noexcept { return data()[size_ - 1]; }
+    
+    // Iterator support
+    T* begin() noexcept { return data(); }
+    T* end() noexcept { return data() + size_; }
+    const T* begin() const noexcept { return data(); }
+    const T* end() const noexcept { return data() + size_; }
+};
+
+} // namespace pixeltree
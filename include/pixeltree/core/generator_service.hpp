@@ -0,0 +1,344 @@
+#pragma once
+#include "tree_generator.hpp"
+#include "pixel_buffer.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace pixeltree {
+
+enum class RequestStatus {
+    Completed,
+    Cancelled,      // Cancelled before it finished, or dropped at shutdown
+    Failed          // Generation threw; see GenerationOutcome::error
+};
+
+// Result handed to a request's completion callback
+template<typename PixelType = uint32_t>
+struct GenerationOutcome {
+    uint64_t request_id = 0;
+    RequestStatus status = RequestStatus::Cancelled;
+    PixelBuffer<PixelType> pixels;      // Empty unless Completed
+    TreeMetadata metadata{};
+    std::exception_ptr error;
+};
+
+// Caller's side of a submitted request
+class RequestHandle {
+public:
+    struct State {
+        uint64_t id = 0;
+        std::atomic<bool> cancelled{false};
+        std::atomic<bool> finished{false};
+    };
+    
+    RequestHandle() = default;
+    explicit RequestHandle(std::shared_ptr<State> state) noexcept : state_(std::move(state)) {}
+    
+    uint64_t id() const noexcept { return state_ ? state_->id : 0; }
+    
+    // Ask for the request to be dropped: a queued request is skipped, a
+    // running one still finishes but reports RequestStatus::Cancelled
+    void cancel() noexcept {
+        if (state_) {
+            state_->cancelled = true;
+        }
+    }
+    
+    bool cancelled() const noexcept { return state_ && state_->cancelled; }
+    
+    // The callback has been invoked (or is running)
+    bool finished() const noexcept { return state_ && state_->finished; }
+
+private:
+    std::shared_ptr<State> state_;
+};
+
+// Tree generation service for sustained request streams
+//
+// A fixed pool of workers, each with its own copy of the prototype generator,
+// serves a bounded queue ordered by priority (higher first, then submission
+// order). submit() blocks while the queue is full, try_submit() refuses
+// instead. Results arrive through a callback on the worker thread that
+// produced them, or by co_await on generate(); requests cancelled while still
+// queued are reported on the thread that drops them. Seeds for random_seed == 0
+// are drawn from the prototype at submission, so a request's tree depends
+// only on its parameters and submission order, never on which worker runs it.
+//
+// Callbacks must not block on this service (use try_submit to chain work);
+// exceptions thrown by a callback are discarded. Completed buffers come from
+// an internal pool, and recycle() hands them back for reuse.
+template<typename PixelType = uint32_t, size_t MaxBranches = 64, typename Geometry = FloatGeometry>
+class GeneratorService {
+public:
+    using Generator = TreeGenerator<PixelType, MaxBranches, Geometry>;
+    using Outcome = GenerationOutcome<PixelType>;
+    using Callback = std::function<void(Outcome&&)>;
+    
+    // thread_count 0 = one per core
+    explicit GeneratorService(const Generator& prototype = Generator{}, size_t thread_count = 0,
+                              size_t queue_capacity = 256)
+        : seeder_(prototype), capacity_(std::max<size_t>(1, queue_capacity)) {
+        const size_t threads = thread_count == 0 ? default_thread_count() : thread_count;
+        contexts_.assign(threads, prototype);
+        for (auto& context : contexts_) {
+            context.set_render_threads(1);      // The pool is the parallelism
+        }
+        workers_.reserve(threads);
+        for (size_t worker = 0; worker < threads; ++worker) {
+            workers_.emplace_back([this, worker] { work(worker); });
+        }
+    }
+    
+    ~GeneratorService() { shutdown(); }
+    
+    GeneratorService(const GeneratorService&) = delete;
+    GeneratorService& operator=(const GeneratorService&) = delete;
+    
+    // Queue a request, waiting for space while the queue is full
+    RequestHandle submit(const TreeParameters& params, Callback callback, int priority = 0) {
+        std::vector<Request> dropped;
+        std::optional<RequestHandle> handle;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stopping_ && queue_.size() >= capacity_) {
+                if (!purge_cancelled(dropped)) {
+                    space_ready_.wait(lock);
+                }
+            }
+            if (!stopping_) {
+                handle = enqueue(params, std::move(callback), priority);
+            }
+        }
+        cancel_all(dropped);
+        if (!handle) {
+            throw std::runtime_error("GeneratorService is shut down");
+        }
+        work_ready_.notify_one();
+        return *handle;
+    }
+    
+    // Queue a request unless the queue is full (nothing is queued then)
+    std::optional<RequestHandle> try_submit(const TreeParameters& params, Callback callback, int priority = 0) {
+        std::vector<Request> dropped;
+        std::optional<RequestHandle> handle;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                throw std::runtime_error("GeneratorService is shut down");
+            }
+            if (queue_.size() < capacity_ || purge_cancelled(dropped)) {
+                handle = enqueue(params, std::move(callback), priority);
+            }
+        }
+        if (handle) {
+            work_ready_.notify_one();
+        }
+        cancel_all(dropped);
+        return handle;
+    }
+    
+    // Awaitable request: `Outcome outcome = co_await service.generate(params);`
+    // The coroutine resumes on the worker thread that finished the tree; a
+    // request cancelled while queued resumes it on the thread that drops it
+    // (a later submit() or try_submit(), or shutdown() and so the destructor).
+    class Awaiter {
+        GeneratorService& service_;
+        TreeParameters params_;
+        int priority_;
+        Outcome outcome_;
+    
+    public:
+        Awaiter(GeneratorService& service, const TreeParameters& params, int priority)
+            : service_(service), params_(params), priority_(priority) {}
+        
+        bool await_ready() const noexcept { return false; }
+        
+        void await_suspend(std::coroutine_handle<> coroutine) {
+            service_.submit(params_, [this, coroutine](Outcome&& outcome) {
+                outcome_ = std::move(outcome);
+                coroutine.resume();
+            }, priority_);
+        }
+        
+        Outcome await_resume() { return std::move(outcome_); }
+    };
+    
+    Awaiter generate(const TreeParameters& params, int priority = 0) {
+        return Awaiter(*this, params, priority);
+    }
+    
+    // Return a finished buffer's storage for later requests
+    void recycle(PixelBuffer<PixelType>&& pixels) { pool_.release(std::move(pixels)); }
+    
+    // Block until no request is queued or running
+    void wait_idle() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return queue_.empty() && active_ == 0; });
+    }
+    
+    // Stop accepting requests, report every queued one as Cancelled, let the
+    // running ones finish and join the workers; later submits throw
+    void shutdown() {
+        std::vector<Request> dropped;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return;
+            }
+            stopping_ = true;
+            dropped.swap(queue_);
+        }
+        work_ready_.notify_all();
+        space_ready_.notify_all();
+        cancel_all(dropped);
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        idle_.notify_all();
+    }
+    
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+    
+    size_t thread_count() const noexcept { return workers_.size(); }
+    size_t queue_capacity() const noexcept { return capacity_; }
+
+private:
+    struct Request {
+        int priority;
+        uint64_t sequence;
+        TreeParameters params;
+        Callback callback;
+        std::shared_ptr<RequestHandle::State> state;
+    };
+    
+    // Heap order: the request served next compares greatest
+    static bool served_later(const Request& a, const Request& b) noexcept {
+        return a.priority != b.priority ? a.priority < b.priority : a.sequence > b.sequence;
+    }
+    
+    Generator seeder_;                          // Resolves seeds in submission order
+    size_t capacity_;
+    PixelBufferPool<PixelType> pool_;
+    
+    mutable std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable space_ready_;
+    std::condition_variable idle_;
+    std::vector<Request> queue_;                // Binary heap by served_later
+    uint64_t next_sequence_ = 0;
+    size_t active_ = 0;
+    bool stopping_ = false;
+    
+    std::vector<Generator> contexts_;           // One per worker
+    std::vector<std::thread> workers_;
+    
+    // Requires mutex_
+    RequestHandle enqueue(const TreeParameters& params, Callback&& callback, int priority) {
+        auto state = std::make_shared<RequestHandle::State>();
+        state->id = ++next_sequence_;
+        
+        Request request{priority, next_sequence_, params, std::move(callback), state};
+        request.params.random_seed = seeder_.resolve_seed(params);
+        queue_.push_back(std::move(request));
+        std::push_heap(queue_.begin(), queue_.end(), served_later);
+        return RequestHandle(std::move(state));
+    }
+    
+    // Move cancelled requests out of the queue (requires mutex_); true if any
+    bool purge_cancelled(std::vector<Request>& dropped) {
+        const auto first = std::stable_partition(queue_.begin(), queue_.end(),
+                                                 [](const Request& request) { return !request.state->cancelled; });
+        if (first == queue_.end()) {
+            return false;
+        }
+        std::move(first, queue_.end(), std::back_inserter(dropped));
+        queue_.erase(first, queue_.end());
+        std::make_heap(queue_.begin(), queue_.end(), served_later);
+        return true;
+    }
+    
+    void cancel_all(std::vector<Request>& requests) {
+        for (Request& request : requests) {
+            Outcome outcome;
+            outcome.request_id = request.state->id;
+            complete(request, std::move(outcome));
+        }
+    }
+    
+    static void complete(Request& request, Outcome&& outcome) {
+        request.state->finished = true;
+        if (request.callback) {
+            try {
+                request.callback(std::move(outcome));
+            } catch (...) {
+                // Nothing to report to; the worker must survive
+            }
+        }
+    }
+    
+    void work(size_t worker) {
+        Generator& generator = contexts_[worker];
+        for (;;) {
+            std::optional<Request> request;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                std::pop_heap(queue_.begin(), queue_.end(), served_later);
+                request.emplace(std::move(queue_.back()));
+                queue_.pop_back();
+                ++active_;
+            }
+            space_ready_.notify_one();
+            
+            Outcome outcome;
+            outcome.request_id = request->state->id;
+            if (!request->state->cancelled) {
+                try {
+                    const TreeParameters& params = request->params;
+                    outcome.pixels = pool_.acquire_uninitialized(static_cast<size_t>(params.canvas_width.get()),
+                                                                 static_cast<size_t>(params.canvas_height.get()));
+                    outcome.metadata = generator.generate_into(params, outcome.pixels);
+                    outcome.status = RequestStatus::Completed;
+                } catch (...) {
+                    outcome.status = RequestStatus::Failed;
+                    outcome.error = std::current_exception();
+                }
+                if (request->state->cancelled && outcome.status == RequestStatus::Completed) {
+                    outcome.status = RequestStatus::Cancelled;
+                    pool_.release(std::move(outcome.pixels));
+                    outcome.pixels = PixelBuffer<PixelType>();
+                }
+            }
+            complete(*request, std::move(outcome));
+            
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --active_;
+            }
+            idle_.notify_all();
+        }
+    }
+};
+
+using GeneratorService32 = GeneratorService<uint32_t, 64>;
+
+} // namespace pixeltree
@@ -0,0 +1,551 @@
+#pragma once
+#include "pixel_buffer.hpp"
+#include "tree_generator.hpp"
+#include "parallel.hpp"
+#include <array>
+#include <bit>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef PIXELTREE_HAS_PNG
+    #include <png.h>
+#endif
+
+namespace pixeltree {
+
+enum class ImageFormat {
+    Png,        // Compressed, for final output (needs libpng)
+    Qoi,        // "Quite OK Image" format: lossless, fast, modest compression
+    Raw         // Uncompressed PixelBuffer dump for intermediate pipeline stages
+};
+
+struct PngOptions {
+    int compression_level = 1;      // zlib level 0-9; low levels trade size for speed
+    bool adaptive_filters = true;   // Pick the best row filter per row (else no filtering)
+};
+
+// Image file writers and readers
+//
+// RGBA buffers (uint32_t) are written as 8-bit RGBA, gray buffers (uint8_t)
+// as 8-bit gray and RGB565 buffers (uint16_t) as 8-bit RGB. All functions
+// throw std::runtime_error when the file cannot be written or read.
+class ImageWriter {
+public:
+    template<typename PixelType>
+    static void write(const std::string& path, const PixelBuffer<PixelType>& pixels, ImageFormat format,
+                      const PngOptions& png_options = {}) {
+        switch (format) {
+            case ImageFormat::Png:
+                write_png(path, pixels, png_options);
+                break;
+            case ImageFormat::Qoi:
+                if constexpr (std::is_same_v<PixelType, uint32_t>) {
+                    write_qoi(path, pixels);
+                } else {
+                    throw std::invalid_argument("QOI export needs RGBA pixels");
+                }
+                break;
+            case ImageFormat::Raw:
+                write_raw(path, pixels);
+                break;
+        }
+    }
+    
+    // PNG through libpng; without PIXELTREE_HAS_PNG this throws
+    template<typename PixelType>
+    static void write_png(const std::string& path, const PixelBuffer<PixelType>& pixels,
+                          const PngOptions& options = {}) {
+        static_assert(std::is_same_v<PixelType, uint32_t> || std::is_same_v<PixelType, uint8_t> ||
+                      std::is_same_v<PixelType, uint16_t>, "No PNG layout for this pixel type");
+#ifdef PIXELTREE_HAS_PNG
+        // Rows are handed to libpng in place where the memory layout allows;
+        // RGB565 is expanded to 8-bit RGB first
+        std::vector<uint8_t> expanded;
+        std::vector<const uint8_t*> rows(pixels.height());
+        int color_type = PNG_COLOR_TYPE_RGBA;
+        if constexpr (std::is_same_v<PixelType, uint16_t>) {
+            color_type = PNG_COLOR_TYPE_RGB;
+            expanded.resize(pixels.size() * 3);
+            for (size_t i = 0; i < pixels.size(); ++i) {
+                const uint16_t pixel = pixels.data()[i];
+                expanded[i * 3 + 0] = static_cast<uint8_t>(((pixel >> 11) & 0x1F) * 255 / 31);
+                expanded[i * 3 + 1] = static_cast<uint8_t>(((pixel >> 5) & 0x3F) * 255 / 63);
+                expanded[i * 3 + 2] = static_cast<uint8_t>((pixel & 0x1F) * 255 / 31);
+            }
+            for (size_t y = 0; y < rows.size(); ++y) {
+                rows[y] = expanded.data() + y * pixels.width() * 3;
+            }
+        } else {
+            color_type = std::is_same_v<PixelType, uint8_t> ? PNG_COLOR_TYPE_GRAY : PNG_COLOR_TYPE_RGBA;
+            for (size_t y = 0; y < rows.size(); ++y) {
+                rows[y] = reinterpret_cast<const uint8_t*>(&pixels(0, y));
+            }
+        }
+        
+        // Little-endian 0xRRGGBBAA words are A, B, G, R in memory
+        const bool reversed = std::is_same_v<PixelType, uint32_t> && std::endian::native == std::endian::little;
+        
+        const File file = open(path, "wb");
+        if (!encode_png(file.get(), pixels.width(), pixels.height(), color_type, rows.data(), reversed, options)) {
+            throw std::runtime_error("PNG encoding failed: " + path);
+        }
+#else
+        (void)pixels;
+        (void)options;
+        throw std::runtime_error("PNG export needs libpng (PIXELTREE_HAS_PNG): " + path);
+#endif
+    }
+    
+    // Any PNG decoded to an RGBA buffer; without PIXELTREE_HAS_PNG this throws
+    static PixelBuffer<uint32_t> read_png(const std::string& path) {
+#ifdef PIXELTREE_HAS_PNG
+        png_image image{};
+        image.version = PNG_IMAGE_VERSION;
+        if (!png_image_begin_read_from_file(&image, path.c_str())) {
+            throw std::runtime_error("Not a PNG image: " + path);
+        }
+        image.format = PNG_FORMAT_RGBA;
+        std::vector<uint8_t> bytes(PNG_IMAGE_SIZE(image));
+        if (!png_image_finish_read(&image, nullptr, bytes.data(), 0, nullptr)) {
+            png_image_free(&image);
+            throw std::runtime_error("PNG decoding failed: " + path);
+        }
+        
+        PixelBuffer<uint32_t> pixels(image.width, image.height);
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            const uint8_t* rgba = bytes.data() + i * 4;
+            pixels.data()[i] = make_pixel(rgba[0], rgba[1], rgba[2], rgba[3]);
+        }
+        return pixels;
+#else
+        throw std::runtime_error("PNG import needs libpng (PIXELTREE_HAS_PNG): " + path);
+#endif
+    }
+    
+    // QOI encoding of an RGBA buffer (https://qoiformat.org)
+    static std::vector<uint8_t> encode_qoi(const PixelBuffer<uint32_t>& pixels) {
+        std::vector<uint8_t> out;
+        out.reserve(qoi_header_size + pixels.size() * 2 + sizeof(qoi_end_marker));
+        out.insert(out.end(), {'q', 'o', 'i', 'f'});
+        put_u32_be(out, static_cast<uint32_t>(pixels.width()));
+        put_u32_be(out, static_cast<uint32_t>(pixels.height()));
+        out.push_back(4);           // RGBA
+        out.push_back(0);           // sRGB with linear alpha
+        
+        std::array<uint32_t, 64> index{};
+        uint32_t previous = 0x000000FF;
+        int run = 0;
+        const size_t count = pixels.size();
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t pixel = pixels.data()[i];
+            if (pixel == previous) {
+                if (++run == 62 || i + 1 == count) {
+                    out.push_back(static_cast<uint8_t>(qoi_op_run | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                out.push_back(static_cast<uint8_t>(qoi_op_run | (run - 1)));
+                run = 0;
+            }
+            
+            const uint8_t slot = qoi_hash(pixel);
+            if (index[slot] == pixel) {
+                out.push_back(static_cast<uint8_t>(qoi_op_index | slot));
+            } else {
+                index[slot] = pixel;
+                if ((pixel & 0xFF) == (previous & 0xFF)) {
+                    const int8_t dr = static_cast<int8_t>(channel(pixel, 0) - channel(previous, 0));
+                    const int8_t dg = static_cast<int8_t>(channel(pixel, 1) - channel(previous, 1));
+                    const int8_t db = static_cast<int8_t>(channel(pixel, 2) - channel(previous, 2));
+                    const int8_t dr_dg = static_cast<int8_t>(dr - dg);
+                    const int8_t db_dg = static_cast<int8_t>(db - dg);
+                    
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                        out.push_back(static_cast<uint8_t>(qoi_op_diff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                    } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                        out.push_back(static_cast<uint8_t>(qoi_op_luma | (dg + 32)));
+                        out.push_back(static_cast<uint8_t>((dr_dg + 8) << 4 | (db_dg + 8)));
+                    } else {
+                        out.insert(out.end(), {qoi_op_rgb, channel(pixel, 0), channel(pixel, 1), channel(pixel, 2)});
+                    }
+                } else {
+                    out.insert(out.end(), {qoi_op_rgba, channel(pixel, 0), channel(pixel, 1),
+                                           channel(pixel, 2), channel(pixel, 3)});
+                }
+            }
+            previous = pixel;
+        }
+        
+        out.insert(out.end(), std::begin(qoi_end_marker), std::end(qoi_end_marker));
+        return out;
+    }
+    
+    static PixelBuffer<uint32_t> decode_qoi(const uint8_t* data, size_t size) {
+        if (size < qoi_header_size + sizeof(qoi_end_marker) || std::memcmp(data, "qoif", 4) != 0) {
+            throw std::runtime_error("Not a QOI image");
+        }
+        const uint32_t width = get_u32_be(data + 4);
+        const uint32_t height = get_u32_be(data + 8);
+        if (data[12] < 3 || data[12] > 4 || (width != 0 && height > (size_t{1} << 32) / width)) {
+            throw std::runtime_error("Unsupported QOI image");
+        }
+        
+        PixelBuffer<uint32_t> pixels(width, height);
+        std::array<uint32_t, 64> index{};
+        uint32_t pixel = 0x000000FF;
+        int run = 0;
+        size_t position = qoi_header_size;
+        const size_t chunks_end = size - sizeof(qoi_end_marker);
+        for (uint32_t& out : pixels) {
+            if (run > 0) {
+                --run;
+            } else if (position < chunks_end) {
+                const uint8_t op = data[position++];
+                if (op == qoi_op_rgb || op == qoi_op_rgba) {
+                    const size_t length = op == qoi_op_rgb ? 3 : 4;
+                    if (position + length > chunks_end) {
+                        throw std::runtime_error("Truncated QOI image");
+                    }
+                    const uint32_t alpha = op == qoi_op_rgb ? (pixel & 0xFF) : data[position + 3];
+                    pixel = make_pixel(data[position], data[position + 1], data[position + 2], alpha);
+                    position += length;
+                } else if ((op & 0xC0) == qoi_op_index) {
+                    pixel = index[op];
+                } else if ((op & 0xC0) == qoi_op_diff) {
+                    pixel = make_pixel(static_cast<uint32_t>(channel(pixel, 0) + ((op >> 4) & 0x03) - 2),
+                                       static_cast<uint32_t>(channel(pixel, 1) + ((op >> 2) & 0x03) - 2),
+                                       static_cast<uint32_t>(channel(pixel, 2) + (op & 0x03) - 2), pixel & 0xFF);
+                } else if ((op & 0xC0) == qoi_op_luma) {
+                    const uint8_t next = data[position++];
+                    const int dg = (op & 0x3F) - 32;
+                    pixel = make_pixel(static_cast<uint32_t>(channel(pixel, 0) + dg - 8 + ((next >> 4) & 0x0F)),
+                                       static_cast<uint32_t>(channel(pixel, 1) + dg),
+                                       static_cast<uint32_t>(channel(pixel, 2) + dg - 8 + (next & 0x0F)), pixel & 0xFF);
+                } else {
+                    run = op & 0x3F;
+                }
+                index[qoi_hash(pixel)] = pixel;
+            }
+            out = pixel;
+        }
+        return pixels;
+    }
+    
+    static void write_qoi(const std::string& path, const PixelBuffer<uint32_t>& pixels) {
+        const std::vector<uint8_t> encoded = encode_qoi(pixels);
+        write_bytes(path, encoded.data(), encoded.size());
+    }
+    
+    static PixelBuffer<uint32_t> read_qoi(const std::string& path) {
+        const std::vector<uint8_t> bytes = read_bytes(path);
+        return decode_qoi(bytes.data(), bytes.size());
+    }
+    
+    // Uncompressed dump: "PTRW", then width, height and bytes per pixel as
+    // little-endian 32-bit values, then the pixels in memory order
+    template<typename PixelType>
+    static void write_raw(const std::string& path, const PixelBuffer<PixelType>& pixels) {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        uint8_t header[raw_header_size] = {'P', 'T', 'R', 'W'};
+        put_u32_le(header + 4, static_cast<uint32_t>(pixels.width()));
+        put_u32_le(header + 8, static_cast<uint32_t>(pixels.height()));
+        put_u32_le(header + 12, static_cast<uint32_t>(sizeof(PixelType)));
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(pixels.data()),
+                   static_cast<std::streamsize>(pixels.size() * sizeof(PixelType)));
+        if (!file) {
+            throw std::runtime_error("Write failed: " + path);
+        }
+    }
+    
+    template<typename PixelType>
+    static PixelBuffer<PixelType> read_raw(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        uint8_t header[raw_header_size] = {};
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || std::memcmp(header, "PTRW", 4) != 0) {
+            throw std::runtime_error("Not a raw PixelTree image: " + path);
+        }
+        if (get_u32_le(header + 12) != sizeof(PixelType)) {
+            throw std::runtime_error("Raw image has a different pixel type: " + path);
+        }
+        
+        PixelBuffer<PixelType> pixels;
+        pixels.reset(get_u32_le(header + 4), get_u32_le(header + 8));
+        if (!file.read(reinterpret_cast<char*>(pixels.data()),
+                       static_cast<std::streamsize>(pixels.size() * sizeof(PixelType)))) {
+            throw std::runtime_error("Truncated raw image: " + path);
+        }
+        return pixels;
+    }
+
+private:
+    static constexpr size_t qoi_header_size = 14;
+    static constexpr size_t raw_header_size = 16;
+    static constexpr uint8_t qoi_end_marker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    static constexpr uint8_t qoi_op_index = 0x00;
+    static constexpr uint8_t qoi_op_diff = 0x40;
+    static constexpr uint8_t qoi_op_luma = 0x80;
+    static constexpr uint8_t qoi_op_run = 0xC0;
+    static constexpr uint8_t qoi_op_rgb = 0xFE;
+    static constexpr uint8_t qoi_op_rgba = 0xFF;
+    
+    struct FileClose {
+        void operator()(std::FILE* file) const noexcept { std::fclose(file); }
+    };
+    using File = std::unique_ptr<std::FILE, FileClose>;
+    
+    static File open(const std::string& path, const char* mode) {
+        File file(std::fopen(path.c_str(), mode));
+        if (!file) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        return file;
+    }
+    
+    // Channel 0 = R ... 3 = A of a 0xRRGGBBAA pixel
+    static uint8_t channel(uint32_t pixel, int index) noexcept {
+        return static_cast<uint8_t>(pixel >> (24 - 8 * index));
+    }
+    
+    static uint32_t make_pixel(uint32_t r, uint32_t g, uint32_t b, uint32_t a) noexcept {
+        return (r & 0xFF) << 24 | (g & 0xFF) << 16 | (b & 0xFF) << 8 | (a & 0xFF);
+    }
+    
+    static uint8_t qoi_hash(uint32_t pixel) noexcept {
+        return static_cast<uint8_t>((channel(pixel, 0) * 3 + channel(pixel, 1) * 5 +
+                                     channel(pixel, 2) * 7 + channel(pixel, 3) * 11) % 64);
+    }
+    
+    static void put_u32_be(std::vector<uint8_t>& out, uint32_t value) {
+        out.insert(out.end(), {static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+                               static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)});
+    }
+    
+    static uint32_t get_u32_be(const uint8_t* bytes) noexcept {
+        return uint32_t{bytes[0]} << 24 | uint32_t{bytes[1]} << 16 | uint32_t{bytes[2]} << 8 | bytes[3];
+    }
+    
+    static void put_u32_le(uint8_t* bytes, uint32_t value) noexcept {
+        for (int i = 0; i < 4; ++i) {
+            bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+    
+    static uint32_t get_u32_le(const uint8_t* bytes) noexcept {
+        return uint32_t{bytes[0]} | uint32_t{bytes[1]} << 8 | uint32_t{bytes[2]} << 16 | uint32_t{bytes[3]} << 24;
+    }
+    
+    static void write_bytes(const std::string& path, const uint8_t* data, size_t size) {
+        const File file = open(path, "wb");
+        if (std::fwrite(data, 1, size, file.get()) != size) {
+            throw std::runtime_error("Write failed: " + path);
+        }
+    }
+    
+    static std::vector<uint8_t> read_bytes(const std::string& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return bytes;
+    }
+
+#ifdef PIXELTREE_HAS_PNG
+    // Only trivially destructible locals past setjmp: libpng reports errors by longjmp
+    static bool encode_png(std::FILE* file, size_t width, size_t height, int color_type,
+                           const uint8_t* const* rows, bool reversed, const PngOptions& options) {
+        png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+        if (!png) {
+            return false;
+        }
+        png_infop info = png_create_info_struct(png);
+        if (!info) {
+            png_destroy_write_struct(&png, nullptr);
+            return false;
+        }
+        if (setjmp(png_jmpbuf(png))) {
+            png_destroy_write_struct(&png, &info);
+            return false;
+        }
+        
+        png_init_io(png, file);
+        png_set_compression_level(png, std::clamp(options.compression_level, 0, 9));
+        png_set_filter(png, PNG_FILTER_TYPE_BASE, options.adaptive_filters ? PNG_ALL_FILTERS : PNG_FILTER_NONE);
+        png_set_IHDR(png, info, static_cast<png_uint_32>(width), static_cast<png_uint_32>(height), 8, color_type,
+                     PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+        png_write_info(png, info);
+        if (reversed) {
+            png_set_bgr(png);
+            png_set_swap_alpha(png);
+        }
+        png_write_image(png, const_cast<png_bytepp>(rows));
+        png_write_end(png, nullptr);
+        png_destroy_write_struct(&png, &info);
+        return true;
+    }
+#endif
+};
+
+// Background image export
+//
+// Worker threads encode and write submitted buffers while the caller keeps
+// generating. At most max_pending images wait in the queue; submit() blocks
+// beyond that, which bounds memory when encoding is the slower side. Written
+// buffers are returned to pool() so later renders reuse their storage.
+template<typename PixelType = uint32_t>
+class ImageExporter {
+    struct Job {
+        std::string path;
+        PixelBuffer<PixelType> pixels;
+        ImageFormat format;
+        std::promise<void> done;
+    };
+    
+    PngOptions png_options_;
+    size_t max_pending_;
+    PixelBufferPool<PixelType> pool_;
+    
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable space_ready_;
+    std::condition_variable idle_;
+    std::deque<Job> queue_;
+    size_t active_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+public:
+    // thread_count 0 = one per core; max_pending 0 = two per worker
+    explicit ImageExporter(size_t thread_count = 0, size_t max_pending = 0, PngOptions png_options = {})
+        : png_options_(png_options) {
+        const size_t threads = thread_count == 0 ? default_thread_count() : thread_count;
+        max_pending_ = max_pending == 0 ? threads * 2 : max_pending;
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { work(); });
+        }
+    }
+    
+    // Finishes every queued image before returning
+    ~ImageExporter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_ready_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+    
+    ImageExporter(const ImageExporter&) = delete;
+    ImageExporter& operator=(const ImageExporter&) = delete;
+    
+    // Queue pixels for writing to path; the future reports write errors
+    std::future<void> submit(std::string path, PixelBuffer<PixelType>&& pixels,
+                             ImageFormat format = ImageFormat::Png) {
+        Job job{std::move(path), std::move(pixels), format, {}};
+        std::future<void> result = job.done.get_future();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            space_ready_.wait(lock, [this] { return queue_.size() < max_pending_; });
+            queue_.push_back(std::move(job));
+        }
+        work_ready_.notify_one();
+        return result;
+    }
+    
+    // Block until every submitted image has been written
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return queue_.empty() && active_ == 0; });
+    }
+    
+    PixelBufferPool<PixelType>& pool() noexcept { return pool_; }
+    
+    // Generate every tree on the calling thread and export each one while the
+    // next is generated; path_for(index, metadata) names the files. Rethrows
+    // the first write error once all trees are done.
+    template<size_t MaxBranches, typename Geometry, typename PathFn>
+    std::vector<TreeMetadata> generate_and_export(TreeGenerator<PixelType, MaxBranches, Geometry>& generator,
+                                                  const std::vector<TreeParameters>& params_list,
+                                                  PathFn&& path_for, ImageFormat format = ImageFormat::Png) {
+        std::vector<TreeMetadata> metadata;
+        std::vector<std::future<void>> writes;
+        metadata.reserve(params_list.size());
+        writes.reserve(params_list.size());
+        
+        for (size_t index = 0; index < params_list.size(); ++index) {
+            const TreeParameters& params = params_list[index];
+            PixelBuffer<PixelType> pixels = pool_.acquire_uninitialized(
+                static_cast<size_t>(params.canvas_width.get()), static_cast<size_t>(params.canvas_height.get()));
+            metadata.push_back(generator.generate_into(params, pixels));
+            writes.push_back(submit(path_for(index, metadata.back()), std::move(pixels), format));
+        }
+        
+        for (auto& write : writes) {
+            write.get();
+        }
+        return metadata;
+    }
+
+private:
+    void work() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                job = std::move(queue_.front());
+                queue_.pop_front();
+                ++active_;
+            }
+            space_ready_.notify_one();
+            
+            std::exception_ptr error;
+            try {
+                ImageWriter::write(job.path, job.pixels, job.format, png_options_);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            
+            // Recycle first, so whoever the future wakes already finds the buffer in pool()
+            pool_.release(std::move(job.pixels));
+            if (error) {
+                job.done.set_exception(error);
+            } else {
+                job.done.set_value();
+            }
+            
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --active_;
+            }
+            idle_.notify_all();
+        }
+    }
+};
+
+} // namespace pixeltree
@@ -0,0 +1,188 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <tuple>
+
+namespace pixeltree {
+
+// Per-stage timing and counters are compiled in only with
+// PIXELTREE_ENABLE_INSTRUMENTATION (the CMake option of the same name). In
+// other builds the probes below are empty and every GenerationStats is zero.
+#ifdef PIXELTREE_ENABLE_INSTRUMENTATION
+inline constexpr bool instrumentation_enabled = true;
+#else
+inline constexpr bool instrumentation_enabled = false;
+#endif
+
+// Pipeline stages, in the order generate() runs them
+enum class GenerationStage : uint32_t {
+    Expansion,      // Drawing the L-System branching decisions
+    TreeBuild,      // Turtle interpretation (or copying a cached skeleton)
+    Leaves,         // Placement, colors, leaf clusters and bounds
+    Raster,         // Clearing and drawing the pixels
+    Count
+};
+
+// Counters for one generation, or a sum of several
+struct GenerationStats {
+    static constexpr size_t stage_count = static_cast<size_t>(GenerationStage::Count);
+    
+    std::array<uint64_t, stage_count> stage_ns{};   // Wall time per stage
+    uint64_t trees = 0;                 // Generations summed into these stats
+    uint64_t lstring_length = 0;        // Symbols expanded (none on a cache hit)
+    uint64_t cache_hits = 0;            // Skeletons taken from the StructureCache
+    uint64_t pixels_written = 0;        // Span pixels written, overdraw included
+    uint64_t pixels_covered = 0;        // Pixels that differ from the background
+    uint64_t allocations = 0;           // Growths of the pipeline's own buffers
+    uint64_t rng_draws = 0;             // 32-bit values drawn, structure and leaves
+    
+    uint64_t stage_time_ns(GenerationStage stage) const noexcept {
+        return stage_ns[static_cast<size_t>(stage)];
+    }
+    
+    double stage_time_ms(GenerationStage stage) const noexcept {
+        return static_cast<double>(stage_time_ns(stage)) / 1.0e6;
+    }
+    
+    uint64_t total_time_ns() const noexcept {
+        uint64_t total = 0;
+        for (uint64_t ns : stage_ns) {
+            total += ns;
+        }
+        return total;
+    }
+    
+    // Writes that landed on an already drawn pixel
+    uint64_t pixels_overdrawn() const noexcept {
+        return pixels_written - std::min(pixels_written, pixels_covered);
+    }
+    
+    GenerationStats& operator+=(const GenerationStats& other) noexcept {
+        for (size_t i = 0; i < stage_count; ++i) {
+            stage_ns[i] += other.stage_ns[i];
+        }
+        trees += other.trees;
+        lstring_length += other.lstring_length;
+        cache_hits += other.cache_hits;
+        pixels_written += other.pixels_written;
+        pixels_covered += other.pixels_covered;
+        allocations += other.allocations;
+        rng_draws += other.rng_draws;
+        return *this;
+    }
+};
+
+inline const char* stage_name(GenerationStage stage) noexcept {
+    switch (stage) {
+        case GenerationStage::Expansion: return "expansion";
+        case GenerationStage::TreeBuild: return "tree_build";
+        case GenerationStage::Leaves:    return "leaves";
+        case GenerationStage::Raster:    return "raster";
+        default:                         return "unknown";
+    }
+}
+
+// Receives the stats of every generation of the generators it is attached to
+//
+// Generators copied for generate_batch and generate_async share their sink,
+// so record() may be called from several threads at once.
+class StatsSink {
+public:
+    virtual ~StatsSink() = default;
+    virtual void record(const GenerationStats& stats) = 0;
+};
+
+// Thread-safe sink that sums everything it receives, e.g. over batch runs
+class StatsAccumulator : public StatsSink {
+    mutable std::mutex mutex_;
+    GenerationStats total_;
+    uint64_t max_time_ns_ = 0;          // Slowest single generation
+
+public:
+    void record(const GenerationStats& stats) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        total_ += stats;
+        max_time_ns_ = std::max(max_time_ns_, stats.total_time_ns());
+    }
+    
+    GenerationStats total() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return total_;
+    }
+    
+    uint64_t max_time_ns() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return max_time_ns_;
+    }
+    
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        total_ = GenerationStats{};
+        max_time_ns_ = 0;
+    }
+};
+
+#ifdef PIXELTREE_ENABLE_INSTRUMENTATION
+
+// Adds the lifetime of the scope to one stage
+class StageTimer {
+    GenerationStats& stats_;
+    GenerationStage stage_;
+    std::chrono::steady_clock::time_point start_;
+
+public:
+    StageTimer(GenerationStats& stats, GenerationStage stage) noexcept
+        : stats_(stats), stage_(stage), start_(std::chrono::steady_clock::now()) {}
+    
+    ~StageTimer() {
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        stats_.stage_ns[static_cast<size_t>(stage_)] += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+    
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+};
+
+// Counts the containers whose capacity grew during the scope as allocations
+template<typename... Containers>
+class GrowthProbe {
+    GenerationStats& stats_;
+    std::tuple<const Containers&...> containers_;
+    std::array<size_t, sizeof...(Containers)> capacities_;
+
+public:
+    explicit GrowthProbe(GenerationStats& stats, const Containers&... containers) noexcept
+        : stats_(stats), containers_(containers...), capacities_{containers.capacity()...} {}
+    
+    ~GrowthProbe() {
+        std::apply([this](const Containers&... containers) {
+            size_t index = 0;
+            ((stats_.allocations += containers.capacity() > capacities_[index++] ? 1 : 0), ...);
+        }, containers_);
+    }
+    
+    GrowthProbe(const GrowthProbe&) = delete;
+    GrowthProbe& operator=(const GrowthProbe&) = delete;
+};
+
+#else
+
+class StageTimer {
+public:
+    StageTimer(GenerationStats&, GenerationStage) noexcept {}
+};
+
+template<typename... Containers>
+class GrowthProbe {
+public:
+    explicit GrowthProbe(GenerationStats&, const Containers&...) noexcept {}
+};
+
+#endif
+
+} // namespace pixeltree
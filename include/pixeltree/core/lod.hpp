@@ -0,0 +1,142 @@
+#pragma once
+#include "tree_structure.hpp"
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace pixeltree {
+
+// Detail reduction for the levels of a LOD chain (see TreeGenerator::generate_lods)
+struct LodOptions {
+    size_t levels = 4;                  // Levels including the full-size one, each half the previous
+    float min_branch_thickness = 0.25f; // Branches thinner than this on the level canvas are pruned
+    float merge_cluster_size = 1.5f;    // Leaf clusters smaller than this on the level canvas are merged
+};
+
+// Builds the simplified trees of a LOD chain from one full-detail structure
+//
+// Level n is the tree scaled by 1 / 2^n onto a canvas of the same fraction.
+// Instead of rasterizing full detail and downsampling, each level drops what
+// would be lost anyway: branches thinner than min_branch_thickness go
+// together with their subtrees (the root always stays), and small leaf
+// clusters that fall into the same cell of a merge_cluster_size * 2 grid
+// become a single round cluster covering the same area.
+class LodBuilder {
+public:
+    // Level canvas, or nothing below the 16-pixel minimum of TreeParameters
+    static std::optional<Point2Di> level_canvas(const TreeParameters& params, size_t level) noexcept {
+        if (level >= 16) {
+            return std::nullopt;
+        }
+        const int width = params.canvas_width.get() >> level;
+        const int height = params.canvas_height.get() >> level;
+        if (width < 16 || height < 16) {
+            return std::nullopt;
+        }
+        return Point2Di{width, height};
+    }
+    
+    // Write the simplified tree for `level` into `lod`, reusing its storage;
+    // the level must have a canvas (see level_canvas)
+    template<size_t SourceCapacity, size_t Capacity>
+    static void simplify(const BasicTreeStructure<SourceCapacity>& tree, size_t level, const LodOptions& options,
+                         BasicTreeStructure<Capacity>& lod) {
+        const float scale = std::ldexp(1.0f, -static_cast<int>(level));
+        const Point2Di canvas = level_canvas(tree.parameters, level).value_or(Point2Di{16, 16});
+        
+        TreeParameters params = tree.parameters;
+        params.canvas_width = canvas.x;
+        params.canvas_height = canvas.y;
+        lod.reset(params);
+        lod.generation_id = tree.generation_id;
+        
+        // Parents precede children, so one pass resolves every kept parent
+        std::vector<uint32_t> remap(tree.branches.size(), Branch::npos);
+        for (uint32_t index = 0; index < tree.branches.size(); ++index) {
+            const Branch& branch = tree.branches[index];
+            const bool parent_kept = branch.parent == Branch::npos || remap[branch.parent] != Branch::npos;
+            if (!parent_kept || (index != 0 && branch.thickness * scale < options.min_branch_thickness)) {
+                continue;
+            }
+            
+            Branch scaled = branch;
+            scaled.start_point = branch.start_point * scale;
+            scaled.end_point = branch.end_point * scale;
+            scaled.thickness = branch.thickness * scale;
+            remap[index] = lod.add_branch(scaled, branch.parent == Branch::npos ? Branch::npos : remap[branch.parent]);
+        }
+        
+        merge_clusters(tree, scale, options, lod);
+        lod.calculate_bounding_box();
+    }
+
+private:
+    // Per merged cluster: area-weighted sums of position and color
+    struct MergedCluster {
+        size_t index;           // Into lod.leaf_clusters
+        float area = 0.0f;
+        float x = 0.0f, y = 0.0f;
+        float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+    };
+    
+    template<size_t SourceCapacity, size_t Capacity>
+    static void merge_clusters(const BasicTreeStructure<SourceCapacity>& tree, float scale, const LodOptions& options,
+                               BasicTreeStructure<Capacity>& lod) {
+        const float cell_size = std::max(1.0f, options.merge_cluster_size * 2.0f);
+        std::unordered_map<int64_t, MergedCluster> cells;
+        
+        // Clusters stay in source order; a merged one takes its first member's place
+        for (const LeafCluster& cluster : tree.leaf_clusters) {
+            const Point2Df position = cluster.position * scale;
+            const float size = cluster.size * scale;
+            if (size >= options.merge_cluster_size) {
+                LeafCluster& scaled = lod.leaf_clusters.emplace_back(position, size, cluster.color);
+                scaled.shape = cluster.shape;
+                scaled.leaf_positions.reserve(cluster.leaf_positions.size());
+                for (const Point2Df& leaf : cluster.leaf_positions) {
+                    scaled.leaf_positions.push_back(leaf * scale);
+                }
+                continue;
+            }
+            
+            const int64_t cell_x = static_cast<int64_t>(std::floor(position.x / cell_size));
+            const int64_t cell_y = static_cast<int64_t>(std::floor(position.y / cell_size));
+            auto [it, inserted] = cells.try_emplace(cell_x * 0x100000000LL + cell_y,
+                                                    MergedCluster{lod.leaf_clusters.size()});
+            if (inserted) {
+                lod.leaf_clusters.emplace_back(position, size, cluster.color);
+            }
+            
+            MergedCluster& merged = it->second;
+            const float area = size * size;
+            merged.area += area;
+            merged.x += position.x * area;
+            merged.y += position.y * area;
+            merged.r += cluster.color.r * area;
+            merged.g += cluster.color.g * area;
+            merged.b += cluster.color.b * area;
+            merged.a += cluster.color.a * area;
+        }
+        
+        for (const auto& [cell, merged] : cells) {
+            if (merged.area <= 0.0f) {
+                continue;
+            }
+            LeafCluster& cluster = lod.leaf_clusters[merged.index];
+            const float inv_area = 1.0f / merged.area;
+            cluster.position = Point2Df{merged.x * inv_area, merged.y * inv_area};
+            cluster.size = std::sqrt(merged.area);
+            cluster.color = Color{channel(merged.r * inv_area), channel(merged.g * inv_area),
+                                  channel(merged.b * inv_area), channel(merged.a * inv_area)};
+            cluster.shape = LeafCluster::Shape::Circle;
+        }
+    }
+    
+    static uint8_t channel(float value) noexcept {
+        return static_cast<uint8_t>(std::clamp(std::round(value), 0.0f, 255.0f));
+    }
+};
+
+} // namespace pixeltree
@@ -2,97 +2,446 @@
 
 #include "tree_structure.hpp"
 #include "random.hpp"
-#include <unordered_map>
+#include "trig.hpp"
+#include "fixed_point.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <stdexcept>
 #include <string>
-#include <variant>
-#include <functional>
+#include <string_view>
 
 namespace pixeltree {
 
 // L-System rule types
 struct GrowthRule {
-    float length_factor = 1.0f;
-    float thickness_factor = 1.0f;
-    float angle_change = 0.0f;
+    float length_factor = 1.0f;     // Segment length relative to the base length
+    float thickness_factor = 1.0f;  // Taper applied after each segment
+    float angle_change = 0.0f;      // Random bend per segment, +/- degrees
 };
 
 struct SplitRule {
-    int branch_count = 2;
-    float angle_spread = 45.0f;
-    float thickness_split = 0.7f;
+    int branch_count = 2;           // Children per split
+    float angle_spread = 45.0f;     // Outermost children turn this far, in degrees
+    float thickness_split = 0.7f;   // Child thickness relative to the parent
 };
 
 struct TerminateRule {
-    float probability = 1.0f;
+    float probability = 1.0f;       // Chance a new child never grows further
 };
 
-using LSystemRule = std::variant<GrowthRule, SplitRule, TerminateRule>;
+// Everything that shapes one tree type's expansion
+struct RuleSet {
+    GrowthRule growth;
+    SplitRule split;
+    TerminateRule terminate{0.0f};
+};
+
+// Compiled replacement for a rewritable segment 'F'
+//
+// Symbols: 'F' segment that keeps growing, 'G' segment that never rewrites,
+// '+' / '-' turn by turn_angle, '[' / ']' push / pop the turtle. The first 'F'
+// continues the parent; every later 'F' is a child that may terminate.
+struct Production {
+    static constexpr size_t max_symbols = 128;
+    static constexpr size_t max_children = 64;
+    static constexpr int max_split = 8;
+    
+    std::array<char, max_symbols> symbols{};
+    size_t size = 0;
+    size_t segments = 0;        // 'F' and 'G' symbols
+    size_t rewritable = 0;      // 'F' symbols
+    size_t children = 0;        // 'F' symbols after the first
+    float turn_angle = 0.0f;    // Degrees per '+' / '-'
+    
+    // "F" followed by branch_count children fanned evenly across +/- angle_spread
+    static constexpr Production split(const SplitRule& rule) noexcept {
+        Production production;
+        const int count = std::clamp(rule.branch_count, 1, max_split);
+        production.turn_angle = count > 1 ? rule.angle_spread / static_cast<float>(count - 1)
+                                          : rule.angle_spread;
+        production.push('F');
+        for (int child = 0; child < count; ++child) {
+            const int turns = count - 1 - 2 * child;
+            production.push('[');
+            for (int i = 0; i < (turns < 0 ? -turns : turns); ++i) {
+                production.push(turns > 0 ? '+' : '-');
+            }
+            production.push('F');
+            production.push(']');
+        }
+        return production;
+    }
+    
+    // Validate and compile a user production; throws std::invalid_argument
+    static Production parse(std::string_view text, float turn_angle) {
+        if (text.size() > max_symbols) {
+            throw std::invalid_argument("L-System production too long");
+        }
+        
+        Production production;
+        production.turn_angle = turn_angle;
+        int open_brackets = 0;
+        for (char c : text) {
+            switch (c) {
+                case '[':
+                    ++open_brackets;
+                    break;
+                case ']':
+                    if (--open_brackets < 0) {
+                        throw std::invalid_argument("L-System production has unbalanced brackets");
+                    }
+                    break;
+                case 'F': case 'G': case '+': case '-':
+                    break;
+                default:
+                    throw std::invalid_argument("L-System production has an unknown symbol");
+            }
+            production.push(c);
+        }
+        
+        if (open_brackets != 0) {
+            throw std::invalid_argument("L-System production has unbalanced brackets");
+        }
+        if (production.rewritable == 0) {
+            throw std::invalid_argument("L-System production needs an 'F'");
+        }
+        if (production.children > max_children) {
+            throw std::invalid_argument("L-System production has too many children");
+        }
+        return production;
+    }
+    
+    constexpr void push(char c) noexcept {
+        if (c == 'F') {
+            children += rewritable > 0 ? 1 : 0;
+            ++rewritable;
+        }
+        if (c == 'F' || c == 'G') {
+            ++segments;
+        }
+        symbols[size++] = c;
+    }
+};
+
+// Rule set fixed at compile time; expansion code instantiated for it sees
+// every rule as a constant
+template<RuleSet Rules>
+struct StaticGrammar {
+    static constexpr RuleSet rules = Rules;
+    static constexpr Production production = Production::split(Rules.split);
+};
+
+// Built-in rule sets per tree type
+template<TreeType Type>
+struct TreeRules : StaticGrammar<RuleSet{{1.0f, 0.9f, 0.0f}, {2, 30.0f, 0.7f}, {0.1f}}> {};
+
+template<>
+struct TreeRules<TreeType::Oak> : StaticGrammar<RuleSet{{1.0f, 0.9f, 0.0f}, {2, 35.0f, 0.7f}, {0.1f}}> {};
+
+template<>
+struct TreeRules<TreeType::Pine> : StaticGrammar<RuleSet{{1.2f, 0.8f, 0.0f}, {3, 25.0f, 0.6f}, {0.2f}}> {};
+
+template<>
+struct TreeRules<TreeType::Palm> : StaticGrammar<RuleSet{{1.5f, 0.9f, 10.0f}, {5, 60.0f, 0.8f}, {0.8f}}> {};
+
+template<>
+struct TreeRules<TreeType::Birch> : StaticGrammar<RuleSet{{1.1f, 0.85f, 5.0f}, {2, 25.0f, 0.65f}, {0.15f}}> {};
+
+template<>
+struct TreeRules<TreeType::Willow> : StaticGrammar<RuleSet{{1.0f, 0.92f, 8.0f}, {3, 45.0f, 0.7f}, {0.05f}}> {};
+
+template<>
+struct TreeRules<TreeType::Dead> : StaticGrammar<RuleSet{{0.9f, 0.8f, 15.0f}, {2, 40.0f, 0.6f}, {0.3f}}> {};
+
+// Grammar for TreeType::Custom, compiled at runtime
+struct CustomGrammar {
+    RuleSet rules;
+    Production production;
+    
+    CustomGrammar() : CustomGrammar(TreeRules<TreeType::Oak>::rules) {}
+    
+    // Built-in split shape with custom rule values
+    explicit CustomGrammar(const RuleSet& rule_set)
+        : rules(rule_set), production(Production::split(rule_set.split)) {}
+    
+    // Explicit production for 'F', e.g. "F[+F]F[-F]"; '+' / '-' turn by
+    // split.angle_spread and split.branch_count is ignored
+    CustomGrammar(const RuleSet& rule_set, std::string_view production_text)
+        : rules(rule_set), production(Production::parse(production_text, rule_set.split.angle_spread)) {}
+};
 
 // L-System state for tree generation
 struct LSystemState {
     Point2Df position;
     Point2Df direction;
     float thickness;
-    int depth;
+    int depth;                      // Bracket nesting level
     Color color;
+    uint32_t branch;                // Last branch drawn; parent of the next one
     
-    LSystemState(Point2Df pos, Point2Df dir, float thick, int d, Color col)
-        : position(pos), direction(dir), thickness(thick), depth(d), color(col) {}
+    LSystemState(Point2Df pos, Point2Df dir, float thick, int d, Color col,
+                 uint32_t last_branch = Branch::npos)
+        : position(pos), direction(dir), thickness(thick), depth(d), color(col), branch(last_branch) {}
+};
+
+// LSystemState of the FixedGeometry turtle: position and thickness in
+// 48.16, direction in 2.30 (see FixedPoint)
+struct FixedLSystemState {
+    int64_t x, y;
+    int64_t direction_x, direction_y;
+    int64_t thickness;
+    int depth;
+    Color color;
+    uint32_t branch;
 };
 
 // L-System based tree generator
+//
+// Expansion code is instantiated once per built-in rule set and selected with
+// a single switch per call; TreeType::Custom runs the same code over the
+// runtime-compiled CustomGrammar.
 class LSystemGenerator {
-    std::unordered_map<char, LSystemRule> rules_;
-    
+    TreeType type_ = TreeType::Oak;
+    CustomGrammar custom_;
+
 public:
-    // Set up default rules based on tree type
-    void setup_rules(TreeType type) {
-        rules_.clear();
-        
-        switch (type) {
-            case TreeType::Oak:
-                rules_['F'] = GrowthRule{1.0f, 0.9f, 0.0f};
-                rules_['['] = SplitRule{2, 35.0f, 0.7f};
-                rules_[']'] = TerminateRule{0.1f};
-                break;
-                
-            case TreeType::Pine:
-                rules_['F'] = GrowthRule{1.2f, 0.8f, 0.0f};
-                rules_['['] = SplitRule{3, 25.0f, 0.6f};
-                rules_[']'] = TerminateRule{0.2f};
-                break;
-                
-            case TreeType::Palm:
-                rules_['F'] = GrowthRule{1.5f, 0.9f, 10.0f};
-                rules_['['] = SplitRule{5, 60.0f, 0.8f};
-                rules_[']'] = TerminateRule{0.8f};
-                break;
-                
-            default:
-                // Default oak-like rules
-                rules_['F'] = GrowthRule{1.0f, 0.9f, 0.0f};
-                rules_['['] = SplitRule{2, 30.0f, 0.7f};
-                rules_[']'] = TerminateRule{0.1f};
-                break;
+    // Select the rule set used by later calls
+    void setup_rules(TreeType type) noexcept {
+        type_ = type;
+    }
+    
+    // Grammar used for TreeType::Custom
+    void set_custom_grammar(const CustomGrammar& grammar) {
+        custom_ = grammar;
+    }
+    
+    const CustomGrammar& custom_grammar() const noexcept { return custom_; }
+    
+    // Call fn with the grammar of the selected tree type: an empty TreeRules
+    // policy for built-in types, the CustomGrammar for TreeType::Custom
+    template<typename Fn>
+    decltype(auto) with_grammar(Fn&& fn) const {
+        switch (type_) {
+            case TreeType::Oak:    return fn(TreeRules<TreeType::Oak>{});
+            case TreeType::Pine:   return fn(TreeRules<TreeType::Pine>{});
+            case TreeType::Palm:   return fn(TreeRules<TreeType::Palm>{});
+            case TreeType::Birch:  return fn(TreeRules<TreeType::Birch>{});
+            case TreeType::Willow: return fn(TreeRules<TreeType::Willow>{});
+            case TreeType::Dead:   return fn(TreeRules<TreeType::Dead>{});
+            case TreeType::Custom: break;
         }
+        return fn(custom_);
+    }
+    
+    // Rules of the selected tree type
+    RuleSet rules() const noexcept {
+        return with_grammar([](const auto& grammar) { return RuleSet(grammar.rules); });
+    }
+    
+    // Number of segments ('F' and 'G' symbols) an expansion may produce
+    static size_t segment_budget(const TreeParameters& params,
+                                 size_t max_segments = std::numeric_limits<size_t>::max()) noexcept {
+        return std::min(static_cast<size_t>(params.branches.max_branches.get()), max_segments);
     }
     
     // Generate L-System string
-    std::string generate_string(const TreeParameters& params, Random& rng) const {
+    //
+    // Each iteration rewrites every 'F' with the production with probability
+    // branch_probability (the axiom always splits, so every tree branches);
+    // each new child then terminates (becomes 'G') with the terminate
+    // probability. A split is skipped once it would exceed the
+    // segment budget. Its decisions are still drawn, so the RNG sequence does
+    // not depend on the budget.
+    std::string generate_string(const TreeParameters& params, Random& rng,
+                                size_t max_segments = std::numeric_limits<size_t>::max()) const {
+        return with_grammar([&](const auto& grammar) {
+            return generate_string(grammar, params, rng, max_segments);
+        });
+    }
+    
+    // Branching decisions for one expansion, level-major.
+    //
+    // Each 'F' of a level contributes one split bit and, if it splits, one
+    // terminate bit per child. plan_expansion draws them in the same
+    // breadth-first order generate_string consumes the RNG, so streaming and
+    // string-based expansion see identical random sequences. A few bits per
+    // segment replace the full L-string.
+    struct ExpansionPlan {
+        static constexpr size_t max_levels =
+            static_cast<size_t>(decltype(BranchParameters::max_depth)::max_value());
+        
+        std::vector<bool> decisions;                     // Level-major: level 0, then level 1, ...
+        std::array<size_t, max_levels> level_offsets{};  // First decision of each level
+        std::vector<LSystemState> state_stack;           // Turtle stack storage
+        std::vector<FixedLSystemState> fixed_state_stack;
+        int depth = 0;
+        
+        void clear() noexcept {
+            decisions.clear();
+            state_stack.clear();
+            fixed_state_stack.clear();
+            depth = 0;
+        }
+    };
+    
+    // Draw all branching decisions without building the L-string
+    void plan_expansion(const TreeParameters& params, Random& rng, ExpansionPlan& plan,
+                        size_t max_segments = std::numeric_limits<size_t>::max()) const {
+        with_grammar([&](const auto& grammar) {
+            plan_expansion(grammar, params, rng, plan, max_segments);
+        });
+    }
+    
+    // Emit the fully expanded L-string for a plan one symbol at a time, depth first.
+    // Produces exactly the sequence generate_string would return for the same RNG.
+    template<typename Sink>
+    void stream_expansion(const ExpansionPlan& plan, Sink&& sink) const {
+        with_grammar([&](const auto& grammar) {
+            std::array<size_t, ExpansionPlan::max_levels> cursors = plan.level_offsets;
+            emit_segment(grammar, plan, cursors, 0, sink);
+        });
+    }
+    
+    // Canvas position of the trunk base
+    static Point2Df trunk_base(const TreeParameters& params) noexcept {
+        return Point2Df{params.canvas_width.get() * 0.5f, params.canvas_height.get() * 0.9f};
+    }
+    
+    // Trunk base of a Geometry's trees; on the 24.8 grid for FixedGeometry,
+    // so placing a skeleton stays exact
+    template<typename Geometry = FloatGeometry>
+    static Point2Df trunk_base(const TreeParameters& params) noexcept {
+        if constexpr (Geometry::fixed_point) {
+            return FixedPoint::snap(trunk_base(params));
+        }
+        return trunk_base(params);
+    }
+    
+    // Expand and interpret in one pass, never materializing the L-string.
+    // The plan's storage is reused, so repeated builds stop allocating once warm.
+    // Geometry selects the turtle arithmetic (see FixedGeometry).
+    template<typename Geometry = FloatGeometry, size_t Capacity>
+    void build_tree(const TreeParameters& params, Random& rng,
+                    BasicTreeStructure<Capacity>& tree, ExpansionPlan& plan,
+                    size_t max_segments = std::numeric_limits<size_t>::max()) const {
+        build_skeleton<Geometry>(params, rng, tree, plan, max_segments);
+        tree.translate(trunk_base<Geometry>(params));
+    }
+    
+    // build_tree with the trunk base at the origin. Apart from that offset the
+    // branches do not depend on the canvas size, so they can be cached and
+    // placed on any canvas.
+    template<typename Geometry = FloatGeometry, size_t Capacity>
+    void build_skeleton(const TreeParameters& params, Random& rng,
+                        BasicTreeStructure<Capacity>& tree, ExpansionPlan& plan,
+                        size_t max_segments = std::numeric_limits<size_t>::max()) const {
+        plan_expansion(params, rng, plan, max_segments);
+        build_from_plan<Geometry>(params, rng, tree, plan);
+    }
+    
+    // Second half of build_skeleton: interpret a plan drawn from the same rng
+    // and return the number of L-string symbols consumed
+    template<typename Geometry = FloatGeometry, size_t Capacity>
+    size_t build_from_plan(const TreeParameters& params, Random& rng,
+                           BasicTreeStructure<Capacity>& tree, ExpansionPlan& plan) const {
+        return with_grammar([&](const auto& grammar) {
+            using Tree = BasicTreeStructure<Capacity>;
+            if constexpr (Geometry::fixed_point) {
+                FixedTurtle<Tree> turtle(params, grammar.rules, grammar.production.turn_angle,
+                                         rng, tree, plan.fixed_state_stack);
+                return interpret(grammar, plan, turtle);
+            } else {
+                Turtle<Tree> turtle(params, grammar.rules, grammar.production.turn_angle,
+                                    rng, tree, plan.state_stack);
+                return interpret(grammar, plan, turtle);
+            }
+        });
+    }
+    
+    // Convert L-System string to tree structure
+    std::unique_ptr<TreeStructure> string_to_tree(const std::string& lstring,
+                                                  const TreeParameters& params,
+                                                  Random& rng) const {
+        auto tree = std::make_unique<TreeStructure>(params);
+        string_to_tree(lstring, params, rng, *tree);
+        return tree;
+    }
+    
+    // Convert L-System string into an existing structure, reusing its storage
+    template<size_t Capacity>
+    void string_to_tree(const std::string& lstring,
+                        const TreeParameters& params,
+                        Random& rng,
+                        BasicTreeStructure<Capacity>& tree) const {
+        std::vector<LSystemState> state_stack;
+        with_grammar([&](const auto& grammar) {
+            Turtle<BasicTreeStructure<Capacity>> turtle(params, grammar.rules, grammar.production.turn_angle,
+                                                        rng, tree, state_stack);
+            for (char c : lstring) {
+                turtle.consume(c);
+            }
+        });
+        tree.translate(trunk_base(params));
+    }
+
+private:
+    // Terminate bits for the children of one split, bit i for child i
+    template<typename Grammar>
+    static uint64_t draw_terminations(const Grammar& grammar, Random& rng) {
+        uint64_t terminated = 0;
+        if (grammar.rules.terminate.probability > 0.0f) {
+            for (size_t child = 0; child < grammar.production.children; ++child) {
+                if (rng.next_float() < grammar.rules.terminate.probability) {
+                    terminated |= uint64_t{1} << child;
+                }
+            }
+        }
+        return terminated;
+    }
+    
+    // Append one application of the production, with terminated children as 'G'
+    template<typename Grammar, typename Sink>
+    static void apply_production(const Grammar& grammar, uint64_t terminated, Sink&& sink) {
+        bool continuation = true;
+        size_t child = 0;
+        for (size_t i = 0; i < grammar.production.size; ++i) {
+            const char c = grammar.production.symbols[i];
+            if (c != 'F' || continuation) {
+                continuation = continuation && c != 'F';
+                sink(c);
+            } else {
+                sink(((terminated >> child++) & 1u) ? 'G' : 'F');
+            }
+        }
+    }
+    
+    template<typename Grammar>
+    std::string generate_string(const Grammar& grammar, const TreeParameters& params, Random& rng,
+                                size_t max_segments) const {
+        const size_t budget = segment_budget(params, max_segments);
+        const size_t added_segments = grammar.production.segments - 1;
         std::string result = "F";
+        size_t segment_count = 1;
         
         for (int iteration = 0; iteration < params.branches.max_depth.get(); ++iteration) {
             std::string next_result;
             
             for (char c : result) {
-                if (c == 'F') {
-                    // Growth with potential branching
-                    next_result += 'F';
-                    if (rng.next_float() < params.branches.branch_probability.get()) {
-                        next_result += "[+F][-F]";
-                    }
-                } else {
+                if (c != 'F') {
                     next_result += c;
+                    continue;
+                }
+                
+                // Growth with potential branching
+                const bool split = rng.next_float() < params.branches.branch_probability.get() || iteration == 0;
+                const uint64_t terminated = split ? draw_terminations(grammar, rng) : 0;
+                if (split && segment_count + added_segments <= budget) {
+                    apply_production(grammar, terminated, [&next_result](char symbol) { next_result += symbol; });
+                    segment_count += added_segments;
+                } else {
+                    next_result += 'F';
                 }
             }
             
@@ -102,104 +451,291 @@ public:
         return result;
     }
     
-    // Convert L-System string to tree structure
-    std::unique_ptr<TreeStructure> string_to_tree(const std::string& lstring,
-                                                  const TreeParameters& params,
-                                                  Random& rng) const {
-        auto tree = std::make_unique<TreeStructure>(params);
-        
-        // Starting state
-        const Point2Df start_pos{params.canvas_width.get() * 0.5f, 
-                                params.canvas_height.get() * 0.9f};
-        const Point2Df start_dir{0.0f, -1.0f};
+    template<typename Grammar>
+    void plan_expansion(const Grammar& grammar, const TreeParameters& params, Random& rng,
+                        ExpansionPlan& plan, size_t max_segments) const {
+        const size_t budget = segment_budget(params, max_segments);
+        const size_t added_segments = grammar.production.segments - 1;
+        plan.clear();
+        plan.depth = params.branches.max_depth.get();
         
-        std::vector<LSystemState> state_stack;
-        LSystemState current_state{start_pos, start_dir, 
-                                  params.branches.base_thickness.get(), 
-                                  0, params.trunk.base_color};
-        
-        std::shared_ptr<Branch> current_branch = nullptr;
+        size_t segment_count = 1; // Axiom "F"
+        size_t level_nodes = 1;   // Rewritable 'F' symbols of the current level
+        for (int iteration = 0; iteration < plan.depth; ++iteration) {
+            plan.level_offsets[static_cast<size_t>(iteration)] = plan.decisions.size();
+            
+            size_t next_nodes = 0;
+            for (size_t i = 0; i < level_nodes; ++i) {
+                const bool split = rng.next_float() < params.branches.branch_probability.get() || iteration == 0;
+                const uint64_t terminated = split ? draw_terminations(grammar, rng) : 0;
+                const bool branch = split && segment_count + added_segments <= budget;
+                plan.decisions.push_back(branch);
+                ++next_nodes;
+                
+                if (branch) {
+                    for (size_t child = 0; child < grammar.production.children; ++child) {
+                        const bool stop = (terminated >> child) & 1u;
+                        plan.decisions.push_back(stop);
+                        next_nodes += stop ? 0 : 1;
+                    }
+                    segment_count += added_segments;
+                }
+            }
+            level_nodes = next_nodes;
+        }
+    }
+    
+    // Turtle interpreter that turns L-System symbols into branches
+    template<typename Tree>
+    class Turtle {
+        const TreeParameters& params_;
+        RuleSet rules_;
+        float turn_angle_;
+        Random& rng_;
+        Tree& tree_;
+        std::vector<LSystemState>& state_stack_;
+        LSystemState current_state_;
+    
+    public:
+        Turtle(const TreeParameters& params, const RuleSet& rules, float turn_angle, Random& rng,
+               Tree& tree, std::vector<LSystemState>& state_stack)
+            : params_(params), rules_(rules), turn_angle_(turn_angle), rng_(rng), tree_(tree),
+              state_stack_(state_stack),
+              current_state_{Point2Df{0.0f, 0.0f},
+                             Point2Df{0.0f, -1.0f},
+                             params.branches.base_thickness.get(),
+                             0, params.trunk.base_color} {
+            tree_.reset(params);
+            state_stack_.clear();
+        }
         
-        for (char c : lstring) {
+        void consume(char c) {
             switch (c) {
-                case 'F': {
-                    // Forward movement - create branch
-                    const float branch_length = 15.0f * params.overall_scale.get();
-                    const Point2Df end_pos = current_state.position + 
-                                           current_state.direction * branch_length;
-                    
-                    auto branch = std::make_shared<Branch>(current_state.position, 
-                                                         end_pos, 
-                                                         current_state.thickness,
-                                                         current_state.depth);
-                    branch->color = current_state.color;
-                    
-                    if (!tree->root) {
-                        tree->root = branch;
-                    } else if (current_branch) {
-                        current_branch->children.push_back(branch);
-                        branch->parent = current_branch;
+                case 'F':
+                case 'G': {
+                    // Forward movement - create branch, bending by the growth rule
+                    if (rules_.growth.angle_change > 0.0f) {
+                        const float bend = rng_.next_float(-rules_.growth.angle_change, rules_.growth.angle_change);
+                        current_state_.direction = rotate_vector(current_state_.direction, bend);
                     }
                     
-                    tree->all_branches.push_back(branch);
-                    current_branch = branch;
-                    current_state.position = end_pos;
+                    const float branch_length = 15.0f * params_.overall_scale.get() * rules_.growth.length_factor;
+                    const Point2Df end_pos = current_state_.position +
+                                           current_state_.direction * branch_length;
+                    
+                    Branch branch(current_state_.position,
+                                  end_pos,
+                                  current_state_.thickness,
+                                  current_state_.depth);
+                    branch.color = current_state_.color;
                     
+                    current_state_.branch = tree_.add_branch(branch, current_state_.branch);
+                    current_state_.position = end_pos;
+                    current_state_.thickness *= rules_.growth.thickness_factor;
                     break;
                 }
                 
                 case '[': {
-                    // Push state and start branching
-                    state_stack.push_back(current_state);
+                    // Push state and start a child one nesting level down
+                    state_stack_.push_back(current_state_);
+                    current_state_.depth++;
+                    current_state_.thickness *= rules_.split.thickness_split *
+                                                params_.branches.thickness_decay.get();
                     break;
                 }
                 
                 case ']': {
                     // Pop state
-                    if (!state_stack.empty()) {
-                        current_state = state_stack.back();
-                        state_stack.pop_back();
+                    if (!state_stack_.empty()) {
+                        current_state_ = state_stack_.back();
+                        state_stack_.pop_back();
                     }
                     break;
                 }
                 
                 case '+': {
                     // Turn right
-                    const float angle = rng.next_float(-45.0f, 45.0f) * 
-                                      params.branches.branch_angle_variation.get();
-                    current_state.direction = rotate_vector(current_state.direction, angle);
+                    current_state_.direction = rotate_vector(current_state_.direction, next_turn());
                     break;
                 }
                 
                 case '-': {
                     // Turn left
-                    const float angle = rng.next_float(-45.0f, 45.0f) * 
-                                      params.branches.branch_angle_variation.get();
-                    current_state.direction = rotate_vector(current_state.direction, -angle);
+                    current_state_.direction = rotate_vector(current_state_.direction, -next_turn());
                     break;
                 }
             }
-            
-            // Apply thickness decay
-            current_state.thickness *= params.branches.thickness_decay.get();
-            current_state.depth++;
+        }
+    
+    private:
+        // Rule turn plus random variation
+        float next_turn() {
+            return turn_angle_ + rng_.next_float(-45.0f, 45.0f) *
+                                 params_.branches.branch_angle_variation.get();
+        }
+    };
+    
+    // Turtle on FixedPoint integers: the symbols, RNG draws and branch layout
+    // of Turtle, with every branch emitted on the 24.8 grid
+    template<typename Tree>
+    class FixedTurtle {
+        Random& rng_;
+        Tree& tree_;
+        std::vector<FixedLSystemState>& state_stack_;
+        FixedLSystemState current_state_;
+        bool bends_;
+        int64_t angle_change_;          // 16.16 degrees
+        int64_t turn_angle_;            // 16.16 degrees
+        int64_t angle_variation_;       // 16.16
+        int64_t branch_length_;         // 48.16 pixels
+        int64_t thickness_factor_;      // 16.16
+        int64_t split_factor_;          // 16.16
+    
+    public:
+        FixedTurtle(const TreeParameters& params, const RuleSet& rules, float turn_angle, Random& rng,
+                    Tree& tree, std::vector<FixedLSystemState>& state_stack)
+            : rng_(rng), tree_(tree), state_stack_(state_stack),
+              current_state_{0, 0, 0, -(int64_t{1} << FixedPoint::unit_bits),
+                             scaled(params.branches.base_thickness.get()),
+                             0, params.trunk.base_color, Branch::npos},
+              bends_(rules.growth.angle_change > 0.0f),
+              angle_change_(scaled(rules.growth.angle_change)),
+              turn_angle_(scaled(turn_angle)),
+              angle_variation_(scaled(params.branches.branch_angle_variation.get())),
+              branch_length_(FixedPoint::mul(15 * scaled(params.overall_scale.get()),
+                                             scaled(rules.growth.length_factor), FixedPoint::scale_bits)),
+              thickness_factor_(scaled(rules.growth.thickness_factor)),
+              split_factor_(FixedPoint::mul(scaled(rules.split.thickness_split),
+                                            scaled(params.branches.thickness_decay.get()), FixedPoint::scale_bits)) {
+            tree_.reset(params);
+            state_stack_.clear();
         }
         
-        return tree;
+        void consume(char c) {
+            FixedLSystemState& state = current_state_;
+            switch (c) {
+                case 'F':
+                case 'G': {
+                    if (bends_) {
+                        FixedPoint::rotate(state.direction_x, state.direction_y,
+                                           FixedPoint::draw(rng_, -angle_change_, angle_change_));
+                    }
+                    
+                    const int64_t end_x = state.x + FixedPoint::mul(state.direction_x, branch_length_,
+                                                                    FixedPoint::unit_bits);
+                    const int64_t end_y = state.y + FixedPoint::mul(state.direction_y, branch_length_,
+                                                                    FixedPoint::unit_bits);
+                    Branch branch(emit(state.x, state.y), emit(end_x, end_y), emit(state.thickness), state.depth);
+                    branch.color = state.color;
+                    
+                    state.branch = tree_.add_branch(branch, state.branch);
+                    state.x = end_x;
+                    state.y = end_y;
+                    state.thickness = FixedPoint::mul(state.thickness, thickness_factor_, FixedPoint::scale_bits);
+                    break;
+                }
+                
+                case '[': {
+                    state_stack_.push_back(state);
+                    state.depth++;
+                    state.thickness = FixedPoint::mul(state.thickness, split_factor_, FixedPoint::scale_bits);
+                    break;
+                }
+                
+                case ']': {
+                    if (!state_stack_.empty()) {
+                        state = state_stack_.back();
+                        state_stack_.pop_back();
+                    }
+                    break;
+                }
+                
+                case '+': {
+                    FixedPoint::rotate(state.direction_x, state.direction_y, next_turn());
+                    break;
+                }
+                
+                case '-': {
+                    FixedPoint::rotate(state.direction_x, state.direction_y, -next_turn());
+                    break;
+                }
+            }
+        }
+    
+    private:
+        static int64_t scaled(float value) noexcept {
+            return FixedPoint::from_float(value, FixedPoint::scale_bits);
+        }
+        
+        // 48.16 to the float value of the nearest 24.8 step (exact)
+        static float emit(int64_t value) noexcept {
+            constexpr int shift = FixedPoint::scale_bits - FixedPoint::fraction_bits;
+            return FixedPoint::to_float(FixedPoint::shift_round(value, shift));
+        }
+        
+        static Point2Df emit(int64_t x, int64_t y) noexcept {
+            return Point2Df{emit(x), emit(y)};
+        }
+        
+        int64_t next_turn() {
+            constexpr int64_t spread = int64_t{45} << FixedPoint::scale_bits;
+            return turn_angle_ + FixedPoint::mul(FixedPoint::draw(rng_, -spread, spread), angle_variation_,
+                                                 FixedPoint::scale_bits);
+        }
+    };
+    
+    // Feed the plan's L-string to a turtle; returns the symbols consumed
+    template<typename Grammar, typename Interpreter>
+    static size_t interpret(const Grammar& grammar, const ExpansionPlan& plan, Interpreter& turtle) {
+        std::array<size_t, ExpansionPlan::max_levels> cursors = plan.level_offsets;
+        size_t symbols = 0;
+        auto consume = [&turtle, &symbols](char c) {
+            turtle.consume(c);
+            ++symbols;
+        };
+        emit_segment(grammar, plan, cursors, 0, consume);
+        return symbols;
     }
-
-private:
-    // Rotate a 2D vector by angle in degrees
-    Point2Df rotate_vector(const Point2Df& vec, float angle_degrees) const {
-        const float angle_rad = angle_degrees * M_PI / 180.0f;
-        const float cos_a = std::cos(angle_rad);
-        const float sin_a = std::sin(angle_rad);
+    
+    // Emit one 'F' of the given expansion level and everything it grows into
+    template<typename Grammar, typename Sink>
+    static void emit_segment(const Grammar& grammar, const ExpansionPlan& plan,
+                             std::array<size_t, ExpansionPlan::max_levels>& cursors,
+                             int level, Sink& sink) {
+        if (level == plan.depth) {
+            sink('F');
+            return;
+        }
+        
+        size_t& cursor = cursors[static_cast<size_t>(level)];
+        if (!plan.decisions[cursor++]) {
+            emit_segment(grammar, plan, cursors, level + 1, sink);
+            return;
+        }
+        
+        uint64_t terminated = 0;
+        for (size_t child = 0; child < grammar.production.children; ++child) {
+            terminated |= uint64_t{plan.decisions[cursor++]} << child;
+        }
+        
+        apply_production(grammar, terminated, [&](char c) {
+            if (c == 'F') {
+                emit_segment(grammar, plan, cursors, level + 1, sink);
+            } else {
+                sink(c);
+            }
+        });
+    }
+    
+    // Rotate a 2D vector by angle in degrees (deterministic polynomial sincos)
+    static Point2Df rotate_vector(const Point2Df& vec, float angle_degrees) {
+        const SinCos rotation = Trig::sincos_degrees(angle_degrees);
         
         return Point2Df{
-            vec.x * cos_a - vec.y * sin_a,
-            vec.x * sin_a + vec.y * cos_a
+            vec.x * rotation.cos - vec.y * rotation.sin,
+            vec.x * rotation.sin + vec.y * rotation.cos
         };
     }
 };
 
-} // namespace pixeltree
\ No newline at end of file
+} // namespace pixeltree
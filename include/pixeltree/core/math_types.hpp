@@ -4,6 +4,7 @@
 #include <cmath>
 #include <array>
 #include <type_traits>
+#include <algorithm>
 
 namespace pixeltree {
 
@@ -118,6 +119,9 @@ public:
         return *this;
     }
     
+    // False only for values that bypassed the clamp, e.g. raw bytes read from a file
+    constexpr bool in_bounds() const noexcept { return value_ >= Min && value_ <= Max; }
+    
     static constexpr T min_value() noexcept { return Min; }
     static constexpr T max_value() noexcept { return Max; }
 };
@@ -0,0 +1,97 @@
+#pragma once
+#include "config.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef PIXELTREE_HAS_OPENMP
+    #include <omp.h>
+#endif
+
+namespace pixeltree {
+
+// Number of workers used when the caller does not ask for a specific count
+inline size_t default_thread_count() noexcept {
+    const unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware == 0 ? 1 : hardware;
+}
+
+// Clamp a requested worker count (0 = one per core) to the amount of work available
+inline size_t resolve_thread_count(size_t work_items, size_t requested) noexcept {
+    const size_t threads = requested == 0 ? default_thread_count() : requested;
+    return std::max<size_t>(1, std::min(threads, work_items));
+}
+
+// Run fn(index, worker) for every index in [0, count).
+//
+// Indices are handed out dynamically, so uneven work items balance across workers.
+// `worker` is in [0, resolve_thread_count(count, thread_count)) and identifies the
+// calling worker for the whole call, which lets callers keep one context per worker
+// without locking. The first exception thrown by fn is rethrown on the calling thread.
+template<typename Fn>
+void parallel_for(size_t count, size_t thread_count, Fn&& fn) {
+    if (count == 0) {
+        return;
+    }
+    
+    const size_t workers = resolve_thread_count(count, thread_count);
+    if (workers == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i, size_t{0});
+        }
+        return;
+    }
+    
+    std::exception_ptr first_error;
+    std::mutex error_mutex;
+    auto record_error = [&]() {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!first_error) {
+            first_error = std::current_exception();
+        }
+    };
+
+#ifdef PIXELTREE_HAS_OPENMP
+    const auto signed_count = static_cast<std::ptrdiff_t>(count);
+    #pragma omp parallel for schedule(dynamic) num_threads(static_cast<int>(workers))
+    for (std::ptrdiff_t i = 0; i < signed_count; ++i) {
+        try {
+            fn(static_cast<size_t>(i), static_cast<size_t>(omp_get_thread_num()));
+        } catch (...) {
+            record_error();
+        }
+    }
+#else
+    std::atomic<size_t> next_index{0};
+    auto worker_loop = [&](size_t worker) {
+        for (size_t i = next_index.fetch_add(1); i < count; i = next_index.fetch_add(1)) {
+            try {
+                fn(i, worker);
+            } catch (...) {
+                record_error();
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t worker = 1; worker < workers; ++worker) {
+        threads.emplace_back(worker_loop, worker);
+    }
+    worker_loop(0);
+    
+    for (auto& thread : threads) {
+        thread.join();
+    }
+#endif
+    
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+}
+
+} // namespace pixeltree
@@ -1,32 +1,55 @@
 #pragma once
 #include "math_types.hpp"
+#include "simd_utils.hpp"
 #include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
 #include <vector>
 #include <algorithm>
 
 namespace pixeltree {
 
 // Generic pixel buffer with RAII management
+//
+// Storage is uninitialized, 64-byte aligned memory that is cleared once on
+// construction. Rows are contiguous, so each row also starts on a 64-byte
+// boundary whenever the row size is a multiple of 64 bytes (16 RGBA pixels).
+// reset() reuses the existing allocation when it is large enough, which lets
+// callers and PixelBufferPool render many sprites without allocator churn.
 template<typename PixelType>
 class PixelBuffer {
-    std::unique_ptr<PixelType[]> data_;
+    static_assert(std::is_trivially_copyable_v<PixelType>, "PixelBuffer stores raw pixel values");
+    
+public:
+    static constexpr size_t alignment = 64;
+    
+private:
+    struct AlignedDelete {
+        void operator()(PixelType* pixels) const noexcept {
+            ::operator delete[](pixels, std::align_val_t{alignment});
+        }
+    };
+    
+    std::unique_ptr<PixelType[], AlignedDelete> data_;
     size_t width_, height_;
+    size_t capacity_;           // Allocated pixels, >= width_ * height_
     
 public:
     // Constructors
-    PixelBuffer() : width_(0), height_(0) {}
+    PixelBuffer() : width_(0), height_(0), capacity_(0) {}
     
     PixelBuffer(size_t width, size_t height) 
-        : data_(std::make_unique<PixelType[]>(width * height))
-        , width_(width), height_(height) {
+        : data_(allocate(width * height))
+        , width_(width), height_(height), capacity_(width * height) {
         clear();
     }
     
     // Move semantics
     PixelBuffer(PixelBuffer&& other) noexcept 
         : data_(std::move(other.data_))
-        , width_(other.width_), height_(other.height_) {
-        other.width_ = other.height_ = 0;
+        , width_(other.width_), height_(other.height_), capacity_(other.capacity_) {
+        other.width_ = other.height_ = other.capacity_ = 0;
     }
     
     PixelBuffer& operator=(PixelBuffer&& other) noexcept {
@@ -34,7 +57,8 @@ public:
             data_ = std::move(other.data_);
             width_ = other.width_;
             height_ = other.height_;
-            other.width_ = other.height_ = 0;
+            capacity_ = other.capacity_;
+            other.width_ = other.height_ = other.capacity_ = 0;
         }
         return *this;
     }
@@ -45,7 +69,8 @@ public:
     
     // Deep copy method
     PixelBuffer clone() const {
-        PixelBuffer result(width_, height_);
+        PixelBuffer result;
+        result.reset(width_, height_);
         std::copy(begin(), end(), result.begin());
         return result;
     }
@@ -54,6 +79,7 @@ public:
     size_t width() const noexcept { return width_; }
     size_t height() const noexcept { return height_; }
     size_t size() const noexcept { return width_ * height_; }
+    size_t capacity() const noexcept { return capacity_; }
     bool empty() const noexcept { return size() == 0; }
     
     // Data access
@@ -92,18 +118,33 @@ public:
     
     // Utility methods
     void clear(PixelType value = PixelType{}) {
-        std::fill(begin(), end(), value);
+        if constexpr (std::is_same_v<PixelType, uint32_t>) {
+            simd::PixelOperations::clear_buffer(data(), size(), value);
+        } else {
+            std::fill(begin(), end(), value);
+        }
     }
     
+    // Change dimensions and clear
     void resize(size_t new_width, size_t new_height) {
         if (new_width != width_ || new_height != height_) {
-            data_ = std::make_unique<PixelType[]>(new_width * new_height);
-            width_ = new_width;
-            height_ = new_height;
+            reset(new_width, new_height);
             clear();
         }
     }
     
+    // Change dimensions without clearing; the allocation is only replaced when
+    // it is too small, and pixel contents are unspecified afterwards
+    void reset(size_t new_width, size_t new_height) {
+        const size_t required = new_width * new_height;
+        if (required > capacity_) {
+            data_.reset(allocate(required));
+            capacity_ = required;
+        }
+        width_ = new_width;
+        height_ = new_height;
+    }
+    
     // Check if coordinates are within bounds
     bool contains(int x, int y) const noexcept {
         return x >= 0 && x < static_cast<int>(width_) && 
@@ -112,64 +153,127 @@ public:
     
     // Blitting operations
     void blit(const PixelBuffer& source, Point2Di position) {
-        const int src_width = static_cast<int>(source.width());
-        const int src_height = static_cast<int>(source.height());
+        const BlitRegion region = clip_blit(source, position);
         
-        for (int y = 0; y < src_height; ++y) {
-            for (int x = 0; x < src_width; ++x) {
-                const int dest_x = position.x + x;
-                const int dest_y = position.y + y;
-                
-                if (contains(dest_x, dest_y)) {
-                    (*this)(dest_x, dest_y) = source(x, y);
-                }
-            }
+        for (int y = region.y_begin; y < region.y_end; ++y) {
+            const PixelType* src_row = &source(static_cast<size_t>(region.x_begin - position.x),
+                                               static_cast<size_t>(y - position.y));
+            std::copy_n(src_row, region.width(),
+                        &(*this)(static_cast<size_t>(region.x_begin), static_cast<size_t>(y)));
         }
     }
     
     // Alpha blending for RGBA pixels
     void blit_with_alpha(const PixelBuffer& source, Point2Di position) 
         requires (std::is_same_v<PixelType, uint32_t>) {
-        const int src_width = static_cast<int>(source.width());
-        const int src_height = static_cast<int>(source.height());
+        const BlitRegion region = clip_blit(source, position);
         
-        for (int y = 0; y < src_height; ++y) {
-            for (int x = 0; x < src_width; ++x) {
-                const int dest_x = position.x + x;
-                const int dest_y = position.y + y;
-                
-                if (contains(dest_x, dest_y)) {
-                    const uint32_t src_pixel = source(x, y);
-                    const uint32_t dest_pixel = (*this)(dest_x, dest_y);
-                    (*this)(dest_x, dest_y) = blend_pixels(dest_pixel, src_pixel);
-                }
-            }
+        for (int y = region.y_begin; y < region.y_end; ++y) {
+            const uint32_t* src_row = &source(static_cast<size_t>(region.x_begin - position.x),
+                                              static_cast<size_t>(y - position.y));
+            simd::PixelOperations::alpha_blend(&(*this)(static_cast<size_t>(region.x_begin), static_cast<size_t>(y)),
+                                               src_row, region.width());
         }
     }
 
 private:
-    // Alpha blending for RGBA pixels (format: RGBA)
-    uint32_t blend_pixels(uint32_t background, uint32_t foreground) const {
-        const uint8_t alpha = foreground & 0xFF;
-        if (alpha == 0) return background;
-        if (alpha == 255) return foreground;
-        
-        const float a = alpha / 255.0f;
-        const float inv_a = 1.0f - a;
-        
-        const uint8_t bg_r = (background >> 24) & 0xFF;
-        const uint8_t bg_g = (background >> 16) & 0xFF;
-        const uint8_t bg_b = (background >> 8) & 0xFF;
-        
-        const uint8_t fg_r = (foreground >> 24) & 0xFF;
-        const uint8_t fg_g = (foreground >> 16) & 0xFF;
-        const uint8_t fg_b = (foreground >> 8) & 0xFF;
-        
-        const uint8_t result_r = static_cast<uint8_t>(bg_r * inv_a + fg_r * a);
-        const uint8_t result_g = static_cast<uint8_t>(bg_g * inv_a + fg_g * a);
-        const uint8_t result_b = static_cast<uint8_t>(bg_b * inv_a + fg_b * a);
+    static PixelType* allocate(size_t count) {
+        if (count == 0) {
+            return nullptr;
+        }
+        return static_cast<PixelType*>(::operator new[](count * sizeof(PixelType), std::align_val_t{alignment}));
+    }
+    
+    // Destination rectangle covered by a blit, max exclusive (empty when y_begin >= y_end)
+    struct BlitRegion {
+        int x_begin, x_end;
+        int y_begin, y_end;
         
-        return (result_r << 24) | (result_g << 16) | (result_b << 8) | 255;
+        size_t width() const noexcept { return static_cast<size_t>(x_end - x_begin); }
+    };
+    
+    BlitRegion clip_blit(const PixelBuffer& source, Point2Di position) const noexcept {
+        BlitRegion region{
+            std::max(0, position.x),
+            std::min(static_cast<int>(width_), position.x + static_cast<int>(source.width())),
+            std::max(0, position.y),
+            std::min(static_cast<int>(height_), position.y + static_cast<int>(source.height()))
+        };
+        if (region.x_begin >= region.x_end) {
+            region.y_end = region.y_begin;  // Nothing visible on any row
+        }
+        return region;
+    }
+};
+
+// Free list of pixel buffers for rendering many sprites
+//
+// acquire() hands out a cleared buffer of the requested size, reusing the
+// storage of a released buffer when one is large enough; release() returns a
+// buffer once the caller is done with it. Safe to share between threads.
+template<typename PixelType>
+class PixelBufferPool {
+    mutable std::mutex mutex_;
+    std::vector<PixelBuffer<PixelType>> free_;
+    size_t max_pooled_;
+    
+public:
+    explicit PixelBufferPool(size_t max_pooled = 64) : max_pooled_(max_pooled) {}
+    
+    // Buffer of the given size, cleared to `value`
+    PixelBuffer<PixelType> acquire(size_t width, size_t height, PixelType value = PixelType{}) {
+        PixelBuffer<PixelType> buffer = take(width * height);
+        buffer.reset(width, height);
+        buffer.clear(value);
+        return buffer;
+    }
+    
+    // Buffer of the given size with unspecified contents, for callers that
+    // overwrite every pixel (e.g. TreeGenerator::generate_into)
+    PixelBuffer<PixelType> acquire_uninitialized(size_t width, size_t height) {
+        PixelBuffer<PixelType> buffer = take(width * height);
+        buffer.reset(width, height);
+        return buffer;
+    }
+    
+    // Return a buffer's storage to the pool (dropped when the pool is full)
+    void release(PixelBuffer<PixelType>&& buffer) {
+        if (buffer.capacity() == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < max_pooled_) {
+            free_.push_back(std::move(buffer));
+        }
+    }
+    
+    size_t pooled() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_.size();
+    }
+    
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.clear();
+    }
+    
+private:
+    // Smallest pooled buffer that fits, or an empty one to allocate into
+    PixelBuffer<PixelType> take(size_t pixels) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto best = free_.end();
+        for (auto it = free_.begin(); it != free_.end(); ++it) {
+            if (it->capacity() >= pixels && (best == free_.end() || it->capacity() < best->capacity())) {
+                best = it;
+            }
+        }
+        if (best == free_.end()) {
+            return {};
+        }
+        PixelBuffer<PixelType> buffer = std::move(*best);
+        *best = std::move(free_.back());
+        free_.pop_back();
+        return buffer;
     }
 };
 
@@ -0,0 +1,120 @@
+#pragma once
+#include "pixel_buffer.hpp"
+#include "simd_utils.hpp"
+#include <cstdint>
+#include <algorithm>
+
+namespace pixeltree {
+
+// round(lerp(from, to, coverage / 255)) of one channel
+constexpr uint32_t mix_channel(uint32_t from, uint32_t to, uint32_t coverage) noexcept {
+    return (from * (255 - coverage) + to * coverage + 127) / 255;
+}
+
+// How packed RGBA maps onto a buffer's PixelType
+//
+// Hard-edged rendering only fills whole pixels with one color per shape, so
+// converting each shape color once and filling in the target type gives the
+// same image as rendering RGBA and converting every pixel afterwards. The
+// anti-aliased fringes of RenderStyle::Smooth are mixed in the target format
+// instead (blend); formats without alpha mix them with whatever is already
+// drawn where RGBA would fade alpha.
+template<typename PixelType>
+struct PixelTraits {
+    static PixelType from_rgba(uint32_t rgba) noexcept {
+        return static_cast<PixelType>(rgba);
+    }
+    
+    // Mix an RGBA color into a pixel by 8-bit coverage; formats without
+    // channels to mix take whichever side covers more
+    static PixelType blend(PixelType dest, uint32_t rgba, uint8_t coverage) noexcept {
+        return coverage >= 128 ? from_rgba(rgba) : dest;
+    }
+    
+    static void convert(PixelType* dest, const uint32_t* src, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            dest[i] = from_rgba(src[i]);
+        }
+    }
+};
+
+// Packed RGBA, stored as-is
+template<>
+struct PixelTraits<uint32_t> {
+    static uint32_t from_rgba(uint32_t rgba) noexcept { return rgba; }
+    
+    static uint32_t blend(uint32_t dest, uint32_t rgba, uint8_t coverage) noexcept {
+        return simd::PixelOperations::coverage_pixel(dest, rgba, coverage);
+    }
+    
+    static void convert(uint32_t* dest, const uint32_t* src, size_t count) {
+        std::copy_n(src, count, dest);
+    }
+};
+
+// 8-bit luma
+template<>
+struct PixelTraits<uint8_t> {
+    static uint8_t from_rgba(uint32_t rgba) noexcept {
+        return simd::PixelOperations::gray_pixel(rgba);
+    }
+    
+    static uint8_t blend(uint8_t dest, uint32_t rgba, uint8_t coverage) noexcept {
+        return static_cast<uint8_t>(mix_channel(dest, from_rgba(rgba), coverage));
+    }
+    
+    static void convert(uint8_t* dest, const uint32_t* src, size_t count) {
+        simd::PixelOperations::rgba_to_gray(dest, src, count);
+    }
+};
+
+// RGB565, alpha dropped
+template<>
+struct PixelTraits<uint16_t> {
+    static uint16_t from_rgba(uint32_t rgba) noexcept {
+        return simd::PixelOperations::rgb565_pixel(rgba);
+    }
+    
+    static uint16_t blend(uint16_t dest, uint32_t rgba, uint8_t coverage) noexcept {
+        const uint16_t color = from_rgba(rgba);
+        return static_cast<uint16_t>((mix_channel(dest >> 11, color >> 11, coverage) << 11) |
+                                     (mix_channel((dest >> 5) & 0x3F, (color >> 5) & 0x3F, coverage) << 5) |
+                                     mix_channel(dest & 0x1F, color & 0x1F, coverage));
+    }
+    
+    static void convert(uint16_t* dest, const uint32_t* src, size_t count) {
+        simd::PixelOperations::rgba_to_rgb565(dest, src, count);
+    }
+};
+
+// Whole-buffer conversions of rendered RGBA output
+class PixelConverter {
+public:
+    // RGBA into any PixelType with PixelTraits
+    template<typename PixelType>
+    static PixelBuffer<PixelType> convert(const PixelBuffer32& source) {
+        PixelBuffer<PixelType> result(source.width(), source.height());
+        PixelTraits<PixelType>::convert(result.data(), source.data(), source.size());
+        return result;
+    }
+    
+    static PixelBuffer8 to_gray(const PixelBuffer32& source) {
+        return convert<uint8_t>(source);
+    }
+    
+    static PixelBuffer<uint16_t> to_rgb565(const PixelBuffer32& source) {
+        return convert<uint16_t>(source);
+    }
+    
+    // Premultiplied alpha, in place
+    static void premultiply(PixelBuffer32& buffer) {
+        simd::PixelOperations::premultiply(buffer.data(), buffer.data(), buffer.size());
+    }
+    
+    // B, G, R, A byte order for GPU upload, in place
+    static void swizzle_bgra(PixelBuffer32& buffer) {
+        simd::PixelOperations::swizzle_bgra(buffer.data(), buffer.data(), buffer.size());
+    }
+};
+
+} // namespace pixeltree
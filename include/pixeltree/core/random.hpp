@@ -1,45 +1,160 @@
 #pragma once
 #include <random>
 #include <type_traits>
+#include <cstddef>
+#include <cstdint>
 #include "math_types.hpp"
+#include "trig.hpp"
 
 namespace pixeltree {
 
-// Thread-safe random number generator
+// Small, fast PCG32 random number generator (O'Neill, XSH-RR output)
+//
+// 24 bytes of state, so copying or re-seeding per tree is free. Each
+// (seed, stream) pair yields an independent sequence; stream() and split()
+// derive further sequences for subtrees or workers without sharing state.
+// Not synchronized: use one instance per thread.
 class Random {
-    mutable std::mt19937 generator_;
+    static constexpr uint64_t multiplier = 6364136223846793005ULL;
     
+    mutable uint64_t state_ = 0;
+    uint64_t increment_ = 1;    // Odd; selects the stream
+    uint64_t seed_ = 0;
+
 public:
-    explicit Random(uint32_t seed = std::random_device{}()) 
-        : generator_(seed) {}
+    explicit Random(uint64_t seed = std::random_device{}(), uint64_t stream = 0) noexcept
+        : increment_((stream << 1) | 1u), seed_(seed) {
+        step();
+        state_ += seed;
+        step();
+    }
+    
+    uint64_t seed() const noexcept { return seed_; }
+    uint64_t stream_id() const noexcept { return increment_ >> 1; }
+    
+    // Independent generator for the same seed on another stream
+    Random stream(uint64_t stream) const noexcept {
+        return Random(seed_, stream);
+    }
+    
+    // Independent generator seeded from this one (advances this stream)
+    Random split() const noexcept {
+        const uint64_t seed = next_uint64();
+        const uint64_t stream = next_uint64();
+        return Random(seed, stream);
+    }
+    
+    // Skip delta values in O(log delta)
+    void advance(uint64_t delta) const noexcept {
+        uint64_t acc_mult = 1, acc_plus = 0;
+        uint64_t cur_mult = multiplier, cur_plus = increment_;
+        while (delta > 0) {
+            if (delta & 1u) {
+                acc_mult *= cur_mult;
+                acc_plus = acc_plus * cur_mult + cur_plus;
+            }
+            cur_plus = (cur_mult + 1) * cur_plus;
+            cur_mult *= cur_mult;
+            delta >>= 1;
+        }
+        state_ = acc_mult * state_ + acc_plus;
+    }
     
-    // Generate random float in range [0, 1)
-    float next_float() const {
-        static thread_local std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-        return dist(generator_);
+    // Number of 32-bit values drawn since `earlier`, a copy of this generator
+    // on the same stream; the inverse of advance(), in O(64)
+    uint64_t draws_since(const Random& earlier) const noexcept {
+        uint64_t current = earlier.state_;
+        uint64_t cur_mult = multiplier, cur_plus = increment_;
+        uint64_t distance = 0;
+        for (uint64_t bit = 1; current != state_ && bit != 0; bit <<= 1) {
+            if ((current & bit) != (state_ & bit)) {
+                current = current * cur_mult + cur_plus;
+                distance |= bit;
+            }
+            cur_plus = (cur_mult + 1) * cur_plus;
+            cur_mult *= cur_mult;
+        }
+        return distance;
+    }
+    
+    // Generate raw 32-bit value
+    uint32_t next_uint() const noexcept {
+        const uint64_t old_state = state_;
+        step();
+        const uint32_t xorshifted = static_cast<uint32_t>(((old_state >> 18u) ^ old_state) >> 27u);
+        const uint32_t rotation = static_cast<uint32_t>(old_state >> 59u);
+        return (xorshifted >> rotation) | (xorshifted << ((32u - rotation) & 31u));
+    }
+    
+    uint64_t next_uint64() const noexcept {
+        const uint64_t high = next_uint();
+        return (high << 32) | next_uint();
+    }
+    
+    // Generate random float in range [0, 1), 24 bits of precision
+    float next_float() const noexcept {
+        return to_unit_float(next_uint());
     }
     
     // Generate random float in range [min, max)
-    float next_float(float min, float max) const {
+    float next_float(float min, float max) const noexcept {
         return min + next_float() * (max - min);
     }
     
-    // Generate random int in range [min, max]
-    int next_int(int min, int max) const {
-        std::uniform_int_distribution<int> dist(min, max);
-        return dist(generator_);
+    // Generate random int in range [min, max] without modulo bias (Lemire)
+    int next_int(int min, int max) const noexcept {
+        const uint32_t range = static_cast<uint32_t>(max) - static_cast<uint32_t>(min) + 1u;
+        if (range == 0) {
+            return static_cast<int>(next_uint());   // Full 32-bit range
+        }
+        return static_cast<int>(static_cast<uint32_t>(min) + next_bounded(range));
+    }
+    
+    // Uniform value in [0, bound)
+    uint32_t next_bounded(uint32_t bound) const noexcept {
+        uint64_t product = static_cast<uint64_t>(next_uint()) * bound;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < bound) {
+            const uint32_t threshold = (0u - bound) % bound;
+            while (low < threshold) {
+                product = static_cast<uint64_t>(next_uint()) * bound;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<uint32_t>(product >> 32);
+    }
+    
+    // Fill dest with count floats in [min, max); the same values as count
+    // next_float(min, max) calls. Raw values are drawn a block at a time so the
+    // conversion loop vectorizes.
+    void fill_floats(float* dest, size_t count, float min = 0.0f, float max = 1.0f) const noexcept {
+        constexpr size_t block = 64;
+        uint32_t raw[block];
+        const float scale = max - min;
+        
+        while (count > 0) {
+            const size_t n = count < block ? count : block;
+            for (size_t i = 0; i < n; ++i) {
+                raw[i] = next_uint();
+            }
+            for (size_t i = 0; i < n; ++i) {
+                dest[i] = min + to_unit_float(raw[i]) * scale;
+            }
+            dest += n;
+            count -= n;
+        }
     }
     
     // Generate random boolean with given probability
-    bool next_bool(float probability = 0.5f) const {
+    bool next_bool(float probability = 0.5f) const noexcept {
         return next_float() < probability;
     }
     
     // Generate random point in circle
     Point2Df next_point_in_circle(float radius = 1.0f) const {
-        const float angle = next_float(0.0f, 2.0f * M_PI);
+        const SinCos angle = Trig::sincos(next_float(0.0f, 2.0f * Trig::pi));
         const float r = std::sqrt(next_float()) * radius;
-        return {r * std::cos(angle), r * std::sin(angle)};
+        return {r * angle.cos, r * angle.sin};
     }
     
     // Generate random point in rectangle
@@ -49,6 +164,15 @@ public:
             next_float(rect.min.y, rect.max.y)
         };
     }
+
+private:
+    void step() const noexcept {
+        state_ = state_ * multiplier + increment_;
+    }
+    
+    static float to_unit_float(uint32_t value) noexcept {
+        return static_cast<float>(value >> 8) * (1.0f / 16777216.0f);
+    }
 };
 
-} // namespace pixeltree
\ No newline at end of file
+} // namespace pixeltree
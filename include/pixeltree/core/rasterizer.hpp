@@ -0,0 +1,648 @@
+#pragma once
+#include "math_types.hpp"
+#include "pixel_buffer.hpp"
+#include "pixel_format.hpp"
+#include "simd_utils.hpp"
+#include "instrumentation.hpp"
+#include "fixed_point.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace pixeltree {
+
+// One color for a whole shape drawn by the SpanRasterizer blend_* functions;
+// a paint with uniform == false is asked for every pixel instead (see
+// TreeRenderer's bark)
+struct FlatPaint {
+    static constexpr bool uniform = true;
+    uint32_t rgba;
+    
+    uint32_t operator()(int, int, float, float) const noexcept { return rgba; }
+};
+
+// Writable window into a pixel surface, addressed in canvas coordinates
+//
+// `pixels` holds the pixel at canvas position `origin`, rows are `stride`
+// pixels apart, and only canvas pixels inside `clip` (max exclusive) are ever
+// written. The same rasterizer code can therefore draw into a full canvas, a
+// cropped sprite, a tile or one row band of a shared buffer.
+template<typename PixelType>
+struct RasterTarget {
+    PixelType* pixels = nullptr;
+    size_t stride = 0;
+    Point2Di origin;
+    Rect2Di clip;
+    uint64_t* pixels_written = nullptr;     // Span pixels, counted in instrumented builds
+    
+    // Whole buffer, with its top-left pixel at canvas position `origin`
+    static RasterTarget from(PixelBuffer<PixelType>& buffer, Point2Di origin = {}) {
+        RasterTarget target;
+        target.pixels = buffer.data();
+        target.stride = buffer.width();
+        target.origin = origin;
+        target.clip = Rect2Di{origin, {origin.x + static_cast<int>(buffer.width()),
+                                       origin.y + static_cast<int>(buffer.height())}};
+        return target;
+    }
+    
+    // Same surface with the clip narrowed to `area`
+    RasterTarget clipped(const Rect2Di& area) const {
+        RasterTarget result = *this;
+        result.clip.min.x = std::max(clip.min.x, area.min.x);
+        result.clip.min.y = std::max(clip.min.y, area.min.y);
+        result.clip.max.x = std::min(clip.max.x, area.max.x);
+        result.clip.max.y = std::min(clip.max.y, area.max.y);
+        return result;
+    }
+    
+    bool empty() const noexcept {
+        return clip.min.x >= clip.max.x || clip.min.y >= clip.max.y;
+    }
+    
+    // First pixel of canvas row y (must be inside the clip)
+    PixelType* row(int y) const noexcept {
+        return pixels + static_cast<size_t>(y - origin.y) * stride;
+    }
+};
+
+// Scanline rasterizer that fills shapes as clipped horizontal runs
+//
+// Pixel centers sit on integer canvas coordinates. Each shape computes the
+// covered [x0, x1] interval of a row analytically, clips it once and writes
+// it as one contiguous run, so no pixel is bounds-checked individually.
+class SpanRasterizer {
+public:
+    // Fill canvas pixels x0..x1 (inclusive) of row y
+    template<typename PixelType>
+    static void fill_span(const RasterTarget<PixelType>& target, int y, int x0, int x1, PixelType color) {
+        if (y < target.clip.min.y || y >= target.clip.max.y) {
+            return;
+        }
+        x0 = std::max(x0, target.clip.min.x);
+        x1 = std::min(x1, target.clip.max.x - 1);
+        if (x0 > x1) {
+            return;
+        }
+        
+        PixelType* run = target.row(y) + (x0 - target.origin.x);
+        const auto count = static_cast<size_t>(x1 - x0 + 1);
+        if constexpr (instrumentation_enabled) {
+            if (target.pixels_written) {
+                *target.pixels_written += count;
+            }
+        }
+        if constexpr (std::is_same_v<PixelType, uint32_t>) {
+            simd::PixelOperations::fill_span(run, count, color);
+        } else {
+            std::fill_n(run, count, color);
+        }
+    }
+    
+    // Fill every pixel within `radius` of the segment a-b (a capsule)
+    template<typename PixelType>
+    static void fill_capsule(const RasterTarget<PixelType>& target,
+                             Point2Df a, Point2Df b, float radius, PixelType color) {
+        int y_begin = 0, y_end = 0;
+        if (!row_range(target, std::min(a.y, b.y) - radius, std::max(a.y, b.y) + radius,
+                       y_begin, y_end)) {
+            return;
+        }
+        
+        const Segment segment(a, b);
+        for (int y = y_begin; y < y_end; ++y) {
+            fill_interval(target, y, segment.capsule_row(radius, static_cast<float>(y)), color);
+        }
+    }
+    
+    // Fill every pixel within `radius` of `center` (a disc)
+    template<typename PixelType>
+    static void fill_disc(const RasterTarget<PixelType>& target,
+                          Point2Df center, float radius, PixelType color) {
+        int y_begin = 0, y_end = 0;
+        if (!row_range(target, center.y - radius, center.y + radius, y_begin, y_end)) {
+            return;
+        }
+        
+        const float radius_sq = radius * radius;
+        for (int y = y_begin; y < y_end; ++y) {
+            fill_interval(target, y, circle_row(center, radius_sq, static_cast<float>(y)), color);
+        }
+    }
+    
+    // Fill the axis-aligned ellipse with the given half-axes
+    template<typename PixelType>
+    static void fill_ellipse(const RasterTarget<PixelType>& target,
+                             Point2Df center, float radius_x, float radius_y, PixelType color) {
+        if (radius_x <= 0.0f || radius_y <= 0.0f) {
+            return;
+        }
+        
+        int y_begin = 0, y_end = 0;
+        if (!row_range(target, center.y - radius_y, center.y + radius_y, y_begin, y_end)) {
+            return;
+        }
+        
+        for (int y = y_begin; y < y_end; ++y) {
+            fill_interval(target, y, ellipse_row(center, radius_x, radius_y, static_cast<float>(y)), color);
+        }
+    }
+    
+    // Anti-aliased fills
+    //
+    // A pixel's coverage is its center's distance to the shape outline put
+    // through a one pixel wide ramp, the box-filtered footprint of the exact
+    // shape that supersampling converges to. Pixels of the shape shrunk by
+    // half a pixel are fully covered and written like the hard-edged fills;
+    // only the fringe around them is mixed in (PixelTraits::blend). Coverage
+    // depends on the pixel and the shape alone, so clipped draws (tiles, row
+    // bands) match a full one.
+    
+    // Capsule around a-b; the paint gets each pixel's canvas position, its
+    // offset across the capsule in [-1, 1] and its distance along it from a
+    template<typename PixelType, typename Paint>
+    static void blend_capsule(const RasterTarget<PixelType>& target,
+                              Point2Df a, Point2Df b, float radius, const Paint& paint) {
+        int y_begin = 0, y_end = 0;
+        if (radius <= 0.0f || !row_range(target, std::min(a.y, b.y) - radius - 0.5f,
+                                         std::max(a.y, b.y) + radius + 0.5f, y_begin, y_end)) {
+            return;
+        }
+        
+        const Segment segment(a, b);
+        const float inv_length = segment.length > 0.0f ? 1.0f / segment.length : 0.0f;
+        const float inv_length_sq = inv_length * inv_length;
+        const float inv_radius = 1.0f / radius;
+        auto sample = [&](float px, float py) {
+            const Point2Df offset{px - a.x, py - a.y};
+            const float t = std::clamp(offset.dot(segment.d) * inv_length_sq, 0.0f, 1.0f);
+            const Point2Df nearest{offset.x - segment.d.x * t, offset.y - segment.d.y * t};
+            const float across = segment.length_sq > 0.0f
+                ? (offset.x * segment.d.y - offset.y * segment.d.x) * inv_length : offset.x;
+            return Sample{std::sqrt(nearest.dot(nearest)) - radius,
+                          std::clamp(across * inv_radius, -1.0f, 1.0f), t * segment.length};
+        };
+        
+        for (int y = y_begin; y < y_end; ++y) {
+            const auto py = static_cast<float>(y);
+            const Interval core = radius > 0.5f ? segment.capsule_row(radius - 0.5f, py) : Interval{};
+            blend_row(target, y, segment.capsule_row(radius + 0.5f, py), core, sample, paint);
+        }
+    }
+    
+    template<typename PixelType>
+    static void blend_disc(const RasterTarget<PixelType>& target,
+                           Point2Df center, float radius, uint32_t rgba) {
+        int y_begin = 0, y_end = 0;
+        if (radius <= 0.0f || !row_range(target, center.y - radius - 0.5f, center.y + radius + 0.5f,
+                                         y_begin, y_end)) {
+            return;
+        }
+        
+        const float outer_sq = (radius + 0.5f) * (radius + 0.5f);
+        const float inner_sq = radius > 0.5f ? (radius - 0.5f) * (radius - 0.5f) : -1.0f;
+        auto sample = [&](float px, float py) {
+            const Point2Df offset{px - center.x, py - center.y};
+            return Sample{std::sqrt(offset.dot(offset)) - radius, 0.0f, 0.0f};
+        };
+        
+        for (int y = y_begin; y < y_end; ++y) {
+            const auto py = static_cast<float>(y);
+            blend_row(target, y, circle_row(center, outer_sq, py), circle_row(center, inner_sq, py),
+                      sample, FlatPaint{rgba});
+        }
+    }
+    
+    // Axis-aligned ellipse; the outline distance is first-order (implicit
+    // function over its gradient), exact on the axes
+    template<typename PixelType>
+    static void blend_ellipse(const RasterTarget<PixelType>& target,
+                              Point2Df center, float radius_x, float radius_y, uint32_t rgba) {
+        int y_begin = 0, y_end = 0;
+        if (radius_x <= 0.0f || radius_y <= 0.0f ||
+            !row_range(target, center.y - radius_y - 0.5f, center.y + radius_y + 0.5f, y_begin, y_end)) {
+            return;
+        }
+        
+        const float inv_x = 1.0f / radius_x;
+        const float inv_y = 1.0f / radius_y;
+        auto sample = [&](float px, float py) {
+            const float qx = (px - center.x) * inv_x;
+            const float qy = (py - center.y) * inv_y;
+            const float q = std::sqrt(qx * qx + qy * qy);
+            const float gradient = std::sqrt(qx * qx * inv_x * inv_x + qy * qy * inv_y * inv_y);
+            return Sample{gradient > 0.0f ? (q - 1.0f) * q / gradient : -1.0f, 0.0f, 0.0f};
+        };
+        
+        const bool has_core = radius_x > 0.5f && radius_y > 0.5f;
+        for (int y = y_begin; y < y_end; ++y) {
+            const auto py = static_cast<float>(y);
+            const Interval core = has_core ? ellipse_row(center, radius_x - 0.5f, radius_y - 0.5f, py) : Interval{};
+            blend_row(target, y, ellipse_row(center, radius_x + 0.5f, radius_y + 0.5f, py), core,
+                      sample, FlatPaint{rgba});
+        }
+    }
+
+private:
+    // Closed interval of x coordinates covered on one row
+    struct Interval {
+        float lo = 1.0f;
+        float hi = 0.0f;
+        
+        bool empty() const noexcept { return lo > hi; }
+        
+        // Union; the shapes drawn here are convex, so covered pieces of a row
+        // always overlap and their union is again one interval
+        void merge(const Interval& other) noexcept {
+            if (other.empty()) {
+                return;
+            }
+            if (empty()) {
+                *this = other;
+                return;
+            }
+            lo = std::min(lo, other.lo);
+            hi = std::max(hi, other.hi);
+        }
+        
+        // Intersect with {x : c0 + c1 * x in [lower, upper]}
+        void constrain(float c0, float c1, float lower, float upper) noexcept {
+            if (c1 == 0.0f) {
+                if (c0 < lower || c0 > upper) {
+                    hi = lo - 1.0f;
+                }
+                return;
+            }
+            float x0 = (lower - c0) / c1;
+            float x1 = (upper - c0) / c1;
+            if (x0 > x1) {
+                std::swap(x0, x1);
+            }
+            lo = std::max(lo, x0);
+            hi = std::min(hi, x1);
+        }
+    };
+    
+    // Canvas rows whose pixel centers fall in [top, bottom], clipped to the target
+    template<typename PixelType>
+    static bool row_range(const RasterTarget<PixelType>& target, float top, float bottom,
+                          int& y_begin, int& y_end) {
+        y_begin = std::max(target.clip.min.y, static_cast<int>(std::ceil(top)));
+        y_end = std::min(target.clip.max.y, static_cast<int>(std::floor(bottom)) + 1);
+        return y_begin < y_end && target.clip.min.x < target.clip.max.x;
+    }
+    
+    // Segment a-(a+d) with the terms every capsule row reuses
+    struct Segment {
+        Point2Df a, b, d;
+        float length_sq, length;
+        
+        Segment(Point2Df start, Point2Df end) noexcept
+            : a(start), b(end), d(end - start), length_sq(d.dot(d)), length(std::sqrt(length_sq)) {}
+        
+        // Row y of the capsule with the given radius
+        Interval capsule_row(float radius, float y) const {
+            const float radius_sq = radius * radius;
+            Interval span = circle_row(a, radius_sq, y);
+            span.merge(circle_row(b, radius_sq, y));
+            if (length_sq > 0.0f) {
+                span.merge(slab_row(a, d, length, length_sq, radius, y));
+            }
+            return span;
+        }
+    };
+    
+    // Outline distance of a pixel center (negative inside) and where it lies
+    // on the shape, for the paint
+    struct Sample {
+        float distance;
+        float across;
+        float along;
+    };
+    
+    // Row y of a disc
+    static Interval circle_row(Point2Df center, float radius_sq, float y) {
+        const float dy = y - center.y;
+        const float remaining = radius_sq - dy * dy;
+        if (remaining < 0.0f) {
+            return {};
+        }
+        const float half_width = std::sqrt(remaining);
+        return Interval{center.x - half_width, center.x + half_width};
+    }
+    
+    // Row y of the rectangle swept by the segment a-(a+d), without end caps
+    static Interval slab_row(Point2Df a, Point2Df d, float length, float length_sq,
+                             float radius, float y) {
+        const float ry = y - a.y;
+        Interval span{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max()};
+        // Along the segment: 0 <= (p - a) . d <= |d|^2
+        span.constrain(ry * d.y - a.x * d.x, d.x, 0.0f, length_sq);
+        // Across the segment: |(p - a) x d| <= radius * |d|
+        span.constrain(-a.x * d.y - ry * d.x, d.y, -radius * length, radius * length);
+        return span;
+    }
+    
+    // Row y of an axis-aligned ellipse
+    static Interval ellipse_row(Point2Df center, float radius_x, float radius_y, float y) {
+        const float dy = (y - center.y) * (1.0f / radius_y);
+        const float remaining = 1.0f - dy * dy;
+        if (remaining < 0.0f) {
+            return {};
+        }
+        const float half_width = radius_x * std::sqrt(remaining);
+        return Interval{center.x - half_width, center.x + half_width};
+    }
+    
+    // Canvas pixels of row y whose centers lie in span, clipped; false if none
+    template<typename PixelType>
+    static bool pixel_range(const RasterTarget<PixelType>& target, const Interval& span, int& x0, int& x1) {
+        if (span.empty()) {
+            return false;
+        }
+        const float lo = std::max(span.lo, static_cast<float>(target.clip.min.x));
+        const float hi = std::min(span.hi, static_cast<float>(target.clip.max.x - 1));
+        if (lo > hi) {
+            return false;
+        }
+        x0 = static_cast<int>(std::ceil(lo));
+        x1 = static_cast<int>(std::floor(hi));
+        return x0 <= x1;
+    }
+    
+    // One row of an anti-aliased fill: `span` holds every pixel with some
+    // coverage, `core` (inside it) the fully covered ones
+    template<typename PixelType, typename Shape, typename Paint>
+    static void blend_row(const RasterTarget<PixelType>& target, int y, const Interval& span,
+                          const Interval& core, const Shape& sample, const Paint& paint) {
+        int x0 = 0, x1 = 0;
+        if (!pixel_range(target, span, x0, x1)) {
+            return;
+        }
+        int core0 = 0, core1 = 0;
+        const bool has_core = pixel_range(target, core, core0, core1);
+        core0 = std::max(core0, x0);
+        core1 = std::min(core1, x1);
+        if (!has_core || core0 > core1) {
+            blend_fringe(target, y, x0, x1, sample, paint);
+            return;
+        }
+        
+        blend_fringe(target, y, x0, core0 - 1, sample, paint);
+        if constexpr (Paint::uniform) {
+            fill_span(target, y, core0, core1, PixelTraits<PixelType>::from_rgba(paint(0, 0, 0.0f, 0.0f)));
+        } else {
+            PixelType* run = target.row(y) + (core0 - target.origin.x);
+            const auto py = static_cast<float>(y);
+            for (int x = core0; x <= core1; ++x) {
+                const Sample at = sample(static_cast<float>(x), py);
+                *run++ = PixelTraits<PixelType>::from_rgba(paint(x, y, at.across, at.along));
+            }
+            count_written(target, static_cast<size_t>(core1 - core0 + 1));
+        }
+        blend_fringe(target, y, core1 + 1, x1, sample, paint);
+    }
+    
+    // Mix pixels x0..x1 (inclusive, inside the clip) of row y by their coverage
+    template<typename PixelType, typename Shape, typename Paint>
+    static void blend_fringe(const RasterTarget<PixelType>& target, int y, int x0, int x1,
+                             const Shape& sample, const Paint& paint) {
+        constexpr int chunk = 64;
+        uint32_t colors[chunk];
+        uint8_t coverage[chunk];
+        
+        const auto py = static_cast<float>(y);
+        for (int begin = x0; begin <= x1; begin += chunk) {
+            const int count = std::min(chunk, x1 - begin + 1);
+            for (int i = 0; i < count; ++i) {
+                const Sample at = sample(static_cast<float>(begin + i), py);
+                const float covered = std::clamp(0.5f - at.distance, 0.0f, 1.0f);
+                coverage[i] = static_cast<uint8_t>(covered * 255.0f + 0.5f);
+                colors[i] = paint(begin + i, y, at.across, at.along);
+            }
+            
+            PixelType* run = target.row(y) + (begin - target.origin.x);
+            if constexpr (std::is_same_v<PixelType, uint32_t>) {
+                simd::PixelOperations::coverage_blend(run, colors, coverage, static_cast<size_t>(count));
+            } else {
+                for (int i = 0; i < count; ++i) {
+                    run[i] = PixelTraits<PixelType>::blend(run[i], colors[i], coverage[i]);
+                }
+            }
+            count_written(target, static_cast<size_t>(count));
+        }
+    }
+    
+    template<typename PixelType>
+    static void count_written(const RasterTarget<PixelType>& target, size_t count) {
+        if constexpr (instrumentation_enabled) {
+            if (target.pixels_written) {
+                *target.pixels_written += count;
+            }
+        }
+    }
+    
+    template<typename PixelType>
+    static void fill_interval(const RasterTarget<PixelType>& target, int y,
+                              const Interval& span, PixelType color) {
+        if (span.empty()) {
+            return;
+        }
+        const float lo = std::max(span.lo, static_cast<float>(target.clip.min.x));
+        const float hi = std::min(span.hi, static_cast<float>(target.clip.max.x - 1));
+        if (lo > hi) {
+            return;
+        }
+        fill_span(target, y, static_cast<int>(std::ceil(lo)), static_cast<int>(std::floor(hi)), color);
+    }
+};
+
+// Integer counterpart of the SpanRasterizer hard-edged fills (FixedGeometry)
+//
+// A shape is converted to 24.8 fixed point once per call. Its row intervals
+// then come from 64-bit integer arithmetic alone: exact products, an integer
+// square root and floor / ceil division, rounded inward so a pixel is filled
+// only when its center lies in the shape. Coverage is therefore the same on
+// every compiler and CPU, and stays inside the float shape's bounds.
+class FixedRasterizer {
+public:
+    using Point = Point2D<int64_t>;     // 24.8
+    
+    template<typename PixelType>
+    static void fill_capsule(const RasterTarget<PixelType>& target,
+                             Point2Df a, Point2Df b, float radius, PixelType color) {
+        fill_capsule(target, to_fixed(a), to_fixed(b), FixedPoint::from_float(radius), color);
+    }
+    
+    template<typename PixelType>
+    static void fill_disc(const RasterTarget<PixelType>& target,
+                          Point2Df center, float radius, PixelType color) {
+        fill_disc(target, to_fixed(center), FixedPoint::from_float(radius), color);
+    }
+    
+    template<typename PixelType>
+    static void fill_ellipse(const RasterTarget<PixelType>& target,
+                             Point2Df center, float radius_x, float radius_y, PixelType color) {
+        fill_ellipse(target, to_fixed(center), FixedPoint::from_float(radius_x),
+                     FixedPoint::from_float(radius_y), color);
+    }
+    
+    // The same fills in 24.8 coordinates
+    template<typename PixelType>
+    static void fill_capsule(const RasterTarget<PixelType>& target,
+                             Point a, Point b, int64_t radius, PixelType color) {
+        int y_begin = 0, y_end = 0;
+        if (!row_range(target, std::min(a.y, b.y) - radius, std::max(a.y, b.y) + radius, y_begin, y_end)) {
+            return;
+        }
+        
+        const Segment segment(a, b, radius);
+        for (int y = y_begin; y < y_end; ++y) {
+            fill_interval(target, y, segment.capsule_row(row_center(y)), color);
+        }
+    }
+    
+    template<typename PixelType>
+    static void fill_disc(const RasterTarget<PixelType>& target,
+                          Point center, int64_t radius, PixelType color) {
+        int y_begin = 0, y_end = 0;
+        if (!row_range(target, center.y - radius, center.y + radius, y_begin, y_end)) {
+            return;
+        }
+        
+        const int64_t radius_sq = radius * radius;
+        for (int y = y_begin; y < y_end; ++y) {
+            fill_interval(target, y, circle_row(center, radius_sq, row_center(y)), color);
+        }
+    }
+    
+    template<typename PixelType>
+    static void fill_ellipse(const RasterTarget<PixelType>& target,
+                             Point center, int64_t radius_x, int64_t radius_y, PixelType color) {
+        if (radius_x <= 0 || radius_y <= 0) {
+            return;
+        }
+        
+        int y_begin = 0, y_end = 0;
+        if (!row_range(target, center.y - radius_y, center.y + radius_y, y_begin, y_end)) {
+            return;
+        }
+        
+        const int64_t radius_y_sq = radius_y * radius_y;
+        for (int y = y_begin; y < y_end; ++y) {
+            const int64_t dy = row_center(y) - center.y;
+            const int64_t remaining = radius_y_sq - dy * dy;
+            if (remaining < 0) {
+                continue;
+            }
+            const int64_t half_width = FixedPoint::floor_div(
+                radius_x * static_cast<int64_t>(FixedPoint::isqrt(static_cast<uint64_t>(remaining))), radius_y);
+            fill_interval(target, y, Interval{center.x - half_width, center.x + half_width}, color);
+        }
+    }
+
+private:
+    // Closed interval of 24.8 x coordinates; see SpanRasterizer::Interval
+    struct Interval {
+        int64_t lo = 1;
+        int64_t hi = 0;
+        
+        bool empty() const noexcept { return lo > hi; }
+        
+        void merge(const Interval& other) noexcept {
+            if (other.empty()) {
+                return;
+            }
+            if (empty()) {
+                *this = other;
+                return;
+            }
+            lo = std::min(lo, other.lo);
+            hi = std::max(hi, other.hi);
+        }
+        
+        // Intersect with the 24.8 x where c0 + c1 * x lies in [lower, upper]
+        void constrain(int64_t c0, int64_t c1, int64_t lower, int64_t upper) noexcept {
+            if (c1 == 0) {
+                if (c0 < lower || c0 > upper) {
+                    hi = lo - 1;
+                }
+                return;
+            }
+            if (c1 < 0) {
+                std::swap(lower, upper);
+            }
+            lo = std::max(lo, FixedPoint::ceil_div(lower - c0, c1));
+            hi = std::min(hi, FixedPoint::floor_div(upper - c0, c1));
+        }
+    };
+    
+    static Point to_fixed(Point2Df point) noexcept {
+        return Point{FixedPoint::from_float(point.x), FixedPoint::from_float(point.y)};
+    }
+    
+    static constexpr int64_t row_center(int y) noexcept {
+        return int64_t{y} * FixedPoint::one;
+    }
+    
+    // Canvas rows whose pixel centers fall in [top, bottom], clipped to the target
+    template<typename PixelType>
+    static bool row_range(const RasterTarget<PixelType>& target, int64_t top, int64_t bottom,
+                          int& y_begin, int& y_end) {
+        const int64_t first = FixedPoint::ceil_div(top, FixedPoint::one);
+        const int64_t last = FixedPoint::floor_div(bottom, FixedPoint::one);
+        y_begin = static_cast<int>(std::max<int64_t>(target.clip.min.y, first));
+        y_end = static_cast<int>(std::min<int64_t>(target.clip.max.y, last + 1));
+        return y_begin < y_end && target.clip.min.x < target.clip.max.x;
+    }
+    
+    // Segment a-(a+d) with the terms every capsule row reuses
+    struct Segment {
+        Point a, b, d;
+        int64_t radius_sq;
+        int64_t length_sq;
+        int64_t reach;          // radius * |d|, rounded down
+        
+        Segment(Point start, Point end, int64_t radius) noexcept
+            : a(start), b(end), d(end - start), radius_sq(radius * radius), length_sq(d.dot(d)),
+              reach(radius * static_cast<int64_t>(FixedPoint::isqrt(static_cast<uint64_t>(length_sq)))) {}
+        
+        Interval capsule_row(int64_t y) const {
+            Interval span = circle_row(a, radius_sq, y);
+            span.merge(circle_row(b, radius_sq, y));
+            if (length_sq > 0) {
+                // Along: 0 <= (p - a) . d <= |d|^2; across: |(p - a) x d| <= radius * |d|
+                const int64_t ry = y - a.y;
+                Interval slab{std::numeric_limits<int64_t>::min() / 2, std::numeric_limits<int64_t>::max() / 2};
+                slab.constrain(ry * d.y - a.x * d.x, d.x, 0, length_sq);
+                slab.constrain(-a.x * d.y - ry * d.x, d.y, -reach, reach);
+                span.merge(slab);
+            }
+            return span;
+        }
+    };
+    
+    static Interval circle_row(Point center, int64_t radius_sq, int64_t y) {
+        const int64_t dy = y - center.y;
+        const int64_t remaining = radius_sq - dy * dy;
+        if (remaining < 0) {
+            return {};
+        }
+        const auto half_width = static_cast<int64_t>(FixedPoint::isqrt(static_cast<uint64_t>(remaining)));
+        return Interval{center.x - half_width, center.x + half_width};
+    }
+    
+    template<typename PixelType>
+    static void fill_interval(const RasterTarget<PixelType>& target, int y,
+                              const Interval& span, PixelType color) {
+        if (span.empty()) {
+            return;
+        }
+        const int64_t x0 = std::max<int64_t>(target.clip.min.x, FixedPoint::ceil_div(span.lo, FixedPoint::one));
+        const int64_t x1 = std::min<int64_t>(target.clip.max.x - 1, FixedPoint::floor_div(span.hi, FixedPoint::one));
+        if (x0 <= x1) {
+            SpanRasterizer::fill_span(target, y, static_cast<int>(x0), static_cast<int>(x1), color);
+        }
+    }
+};
+
+} // namespace pixeltree
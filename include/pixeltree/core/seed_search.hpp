@@ -0,0 +1,79 @@
+#pragma once
+#include "tree_structure.hpp"
+#include <functional>
+#include <limits>
+
+namespace pixeltree {
+
+// What a seed search can judge a tree by without rasterizing it
+struct StructureMetrics {
+    size_t branch_count = 0;
+    int max_depth = 0;
+    size_t leaf_cluster_count = 0;
+    Rect2Df bounding_box;
+    float aspect = 0.0f;            // Bounding box width / height
+    float leaf_coverage = 0.0f;     // Nominal leaf cluster area / bounding box area (overlaps count twice)
+    
+    // Branch metrics only, for a skeleton without leaves
+    template<size_t Capacity>
+    static StructureMetrics of_skeleton(const BasicTreeStructure<Capacity>& tree) noexcept {
+        StructureMetrics metrics;
+        metrics.branch_count = tree.branch_count();
+        metrics.max_depth = tree.max_depth();
+        return metrics;
+    }
+    
+    // Every metric of a finished structure (bounding box included)
+    template<size_t Capacity>
+    static StructureMetrics of(const BasicTreeStructure<Capacity>& tree) noexcept {
+        StructureMetrics metrics = of_skeleton(tree);
+        metrics.leaf_cluster_count = tree.leaf_cluster_count();
+        metrics.bounding_box = tree.bounding_box;
+        
+        const float width = tree.bounding_box.width();
+        const float height = tree.bounding_box.height();
+        metrics.aspect = height > 0.0f ? width / height : 0.0f;
+        
+        float leaf_area = 0.0f;
+        for (const LeafCluster& cluster : tree.leaf_clusters) {
+            const float stretch = cluster.shape == LeafCluster::Shape::Ellipse ? 1.5f : 1.0f;
+            leaf_area += Trig::pi * cluster.size * cluster.size * stretch;
+        }
+        metrics.leaf_coverage = width > 0.0f && height > 0.0f ? leaf_area / (width * height) : 0.0f;
+        return metrics;
+    }
+};
+
+// Acceptance test of a seed search; the defaults accept every tree
+//
+// Bounds are inclusive. Branch count and depth are checked as soon as the
+// skeleton exists, everything else once leaves have grown; `accept`, when
+// set, runs last on the full metrics.
+struct SearchConstraints {
+    size_t min_branches = 0;
+    size_t max_branches = std::numeric_limits<size_t>::max();
+    int min_depth = 0;
+    int max_depth = std::numeric_limits<int>::max();
+    size_t min_leaf_clusters = 0;
+    size_t max_leaf_clusters = std::numeric_limits<size_t>::max();
+    float min_aspect = 0.0f;
+    float max_aspect = std::numeric_limits<float>::infinity();
+    float min_leaf_coverage = 0.0f;
+    float max_leaf_coverage = std::numeric_limits<float>::infinity();
+    std::function<bool(const StructureMetrics&)> accept;
+    
+    bool accepts_skeleton(const StructureMetrics& metrics) const noexcept {
+        return metrics.branch_count >= min_branches && metrics.branch_count <= max_branches &&
+               metrics.max_depth >= min_depth && metrics.max_depth <= max_depth;
+    }
+    
+    bool accepts(const StructureMetrics& metrics) const {
+        return accepts_skeleton(metrics) &&
+               metrics.leaf_cluster_count >= min_leaf_clusters && metrics.leaf_cluster_count <= max_leaf_clusters &&
+               metrics.aspect >= min_aspect && metrics.aspect <= max_aspect &&
+               metrics.leaf_coverage >= min_leaf_coverage && metrics.leaf_coverage <= max_leaf_coverage &&
+               (!accept || accept(metrics));
+    }
+};
+
+} // namespace pixeltree
@@ -1,36 +1,282 @@
 #pragma once
 #include "config.hpp"
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <limits>
+
+// The x86 kernels are always compiled; each carries its own target attribute
+// and only runs once CPU detection has confirmed the instruction set
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define PIXELTREE_SIMD_X86 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+    #if defined(__GNUC__) || defined(__clang__)
+        #define PIXELTREE_TARGET_SSE2 __attribute__((target("sse2")))
+        #define PIXELTREE_TARGET_AVX2 __attribute__((target("avx2")))
+    #else
+        #define PIXELTREE_TARGET_SSE2
+        #define PIXELTREE_TARGET_AVX2
+    #endif
+#endif
 
 namespace pixeltree::simd {
 
+// Instruction set a PixelOperations kernel table is built for
+enum class SimdLevel : uint8_t {
+    Scalar,
+    SSE2,
+    AVX2,
+    NEON
+};
+
+inline const char* to_string(SimdLevel level) noexcept {
+    switch (level) {
+        case SimdLevel::SSE2: return "SSE2";
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::NEON: return "NEON";
+        case SimdLevel::Scalar:
+        default: return "Scalar";
+    }
+}
+
+// Function pointers for one instruction set
+struct KernelTable {
+    SimdLevel level = SimdLevel::Scalar;
+    void (*clear)(uint32_t* data, size_t count, uint32_t value) = nullptr;
+    void (*fill_span)(uint32_t* data, size_t count, uint32_t value) = nullptr;
+    void (*alpha_blend)(uint32_t* dest, const uint32_t* src, size_t count) = nullptr;
+    void (*rgba_to_gray)(uint8_t* dest, const uint32_t* src, size_t count) = nullptr;
+    void (*rgba_to_rgb565)(uint16_t* dest, const uint32_t* src, size_t count) = nullptr;
+    void (*premultiply)(uint32_t* dest, const uint32_t* src, size_t count) = nullptr;
+    void (*swizzle_bgra)(uint32_t* dest, const uint32_t* src, size_t count) = nullptr;
+    void (*coverage_blend)(uint32_t* dest, const uint32_t* src, const uint8_t* coverage, size_t count) = nullptr;
+};
+
 // SIMD-optimized pixel operations
+//
+// Pixels are packed RGBA with red in the high byte and alpha in the low byte
+// (see Color::to_rgba). All kernel tables produce bit-identical results.
+//
+// On x86 every kernel is compiled with a per-function target attribute and
+// the best table for the running CPU is picked once, on first use, so one
+// binary uses AVX2 where it exists and SSE2 elsewhere. NEON is part of the
+// ARM baseline and is chosen at compile time.
 class PixelOperations {
 public:
     // Clear buffer with SIMD acceleration
     static void clear_buffer(uint32_t* data, size_t count, uint32_t value) {
-#ifdef PIXELTREE_HAS_AVX2
-        clear_buffer_avx2(data, count, value);
-#elif defined(PIXELTREE_HAS_SSE2)
-        clear_buffer_sse2(data, count, value);
-#else
-        clear_buffer_scalar(data, count, value);
-#endif
+        kernels().clear(data, count, value);
+    }
+    
+    // Fill one short run of pixels (rasterizer spans)
+    static void fill_span(uint32_t* data, size_t count, uint32_t value) {
+        if (count < 4) {
+            fill_span_scalar(data, count, value);
+            return;
+        }
+        kernels().fill_span(data, count, value);
     }
     
-    // Alpha blend arrays of pixels
+    // Alpha blend src over dest, pixel by pixel
     static void alpha_blend(uint32_t* dest, const uint32_t* src, size_t count) {
-#ifdef PIXELTREE_HAS_AVX2
-        alpha_blend_avx2(dest, src, count);
-#elif defined(PIXELTREE_HAS_SSE2)
-        alpha_blend_sse2(dest, src, count);
-#else
-        alpha_blend_scalar(dest, src, count);
+        kernels().alpha_blend(dest, src, count);
+    }
+    
+    // Luma of every pixel, see gray_pixel
+    static void rgba_to_gray(uint8_t* dest, const uint32_t* src, size_t count) {
+        kernels().rgba_to_gray(dest, src, count);
+    }
+    
+    // RGB565 of every pixel, see rgb565_pixel
+    static void rgba_to_rgb565(uint16_t* dest, const uint32_t* src, size_t count) {
+        kernels().rgba_to_rgb565(dest, src, count);
+    }
+    
+    // Premultiplied alpha of every pixel, see premultiply_pixel (dest may equal src)
+    static void premultiply(uint32_t* dest, const uint32_t* src, size_t count) {
+        kernels().premultiply(dest, src, count);
+    }
+    
+    // BGRA byte order of every pixel, see bgra_pixel (dest may equal src)
+    static void swizzle_bgra(uint32_t* dest, const uint32_t* src, size_t count) {
+        kernels().swizzle_bgra(dest, src, count);
+    }
+    
+    // Mix src into dest by per-pixel coverage, see coverage_pixel
+    static void coverage_blend(uint32_t* dest, const uint32_t* src, const uint8_t* coverage, size_t count) {
+        if (count < 4) {
+            coverage_blend_scalar(dest, src, coverage, count);
+            return;
+        }
+        kernels().coverage_blend(dest, src, coverage, count);
+    }
+    
+    // Blend one pixel: transparent source keeps the background, any other
+    // alpha mixes the color channels and produces an opaque pixel
+    static uint32_t blend_pixel(uint32_t bg, uint32_t fg) noexcept {
+        const uint32_t alpha = fg & 0xFF;
+        if (alpha == 0) return bg;
+        if (alpha == 255) return fg;
+        
+        const uint32_t inv_alpha = 255 - alpha;
+        uint32_t result = 0xFF;
+        for (int shift = 8; shift <= 24; shift += 8) {
+            const uint32_t mixed = ((fg >> shift) & 0xFF) * alpha + ((bg >> shift) & 0xFF) * inv_alpha;
+            result |= div255(mixed) << shift;
+        }
+        return result;
+    }
+    
+    // Mix src into dest by an 8-bit coverage: the average of covered and
+    // uncovered samples in premultiplied alpha, so 255 writes src and 0 keeps
+    // dest. Over a transparent pixel the color stays and only alpha fades;
+    // opaque over opaque is blend_pixel with the coverage as alpha.
+    static uint32_t coverage_pixel(uint32_t dest, uint32_t src, uint32_t coverage) noexcept {
+        if (coverage == 0) return dest;
+        if (coverage == 255) return src;
+        
+        const uint32_t src_alpha = src & 0xFF;
+        const uint32_t dest_alpha = dest & 0xFF;
+        if (dest_alpha == 0) {
+            return (src & 0xFFFFFF00u) | div255(src_alpha * coverage);
+        }
+        if ((src_alpha & dest_alpha) == 255) {
+            return blend_pixel(dest, (src & 0xFFFFFF00u) | coverage);
+        }
+        
+        // Each color weighted by its premultiplied share (dest_weight > 0 here)
+        const uint32_t src_weight = src_alpha * coverage;
+        const uint32_t dest_weight = dest_alpha * (255 - coverage);
+        const uint32_t total = src_weight + dest_weight;
+        uint32_t result = div255(total);
+        for (int shift = 8; shift <= 24; shift += 8) {
+            const uint32_t mixed = ((src >> shift) & 0xFF) * src_weight + ((dest >> shift) & 0xFF) * dest_weight;
+            result |= ((mixed + total / 2) / total) << shift;
+        }
+        return result;
+    }
+    
+    // BT.601 luma in 8-bit fixed point (weights sum to 256)
+    static uint8_t gray_pixel(uint32_t rgba) noexcept {
+        const uint32_t r = (rgba >> 24) & 0xFF;
+        const uint32_t g = (rgba >> 16) & 0xFF;
+        const uint32_t b = (rgba >> 8) & 0xFF;
+        return static_cast<uint8_t>((r * 77 + g * 150 + b * 29 + 128) >> 8);
+    }
+    
+    // Top 5/6/5 bits of red, green and blue; alpha is dropped
+    static uint16_t rgb565_pixel(uint32_t rgba) noexcept {
+        return static_cast<uint16_t>(((rgba >> 16) & 0xF800) | ((rgba >> 13) & 0x07E0) | ((rgba >> 11) & 0x001F));
+    }
+    
+    // Color channels scaled by alpha (rounded); alpha is kept
+    static uint32_t premultiply_pixel(uint32_t rgba) noexcept {
+        const uint32_t alpha = rgba & 0xFF;
+        uint32_t result = alpha;
+        for (int shift = 8; shift <= 24; shift += 8) {
+            result |= div255(((rgba >> shift) & 0xFF) * alpha) << shift;
+        }
+        return result;
+    }
+    
+    // Pixel whose little-endian bytes are B, G, R, A (the usual GPU upload order)
+    static uint32_t bgra_pixel(uint32_t rgba) noexcept {
+        return (rgba >> 8) | (rgba << 24);
+    }
+    
+    // Kernel table selected for this CPU
+    static const KernelTable& kernels() noexcept {
+        static const KernelTable table = table_for(detect_level());
+        return table;
+    }
+    
+    static SimdLevel active_level() noexcept {
+        return kernels().level;
+    }
+    
+    // Whether the running CPU can execute the kernels of `level`
+    static bool supports(SimdLevel level) noexcept {
+        const SimdLevel best = detect_level();
+        switch (level) {
+            case SimdLevel::Scalar: return true;
+            case SimdLevel::SSE2: return best == SimdLevel::SSE2 || best == SimdLevel::AVX2;
+            case SimdLevel::AVX2: return best == SimdLevel::AVX2;
+            case SimdLevel::NEON: return best == SimdLevel::NEON;
+        }
+        return false;
+    }
+    
+    // Kernels for a specific level; levels the CPU cannot run fall back to scalar
+    static KernelTable table_for(SimdLevel level) noexcept {
+        KernelTable table{SimdLevel::Scalar, clear_buffer_scalar, fill_span_scalar,
+                          alpha_blend_scalar, rgba_to_gray_scalar, rgba_to_rgb565_scalar,
+                          premultiply_scalar, swizzle_bgra_scalar, coverage_blend_scalar};
+        if (!supports(level)) {
+            return table;
+        }
+        
+        switch (level) {
+#ifdef PIXELTREE_SIMD_X86
+            case SimdLevel::SSE2:
+                table = {level, clear_buffer_sse2, fill_span_sse2, alpha_blend_sse2, rgba_to_gray_sse2,
+                         rgba_to_rgb565_sse2, premultiply_sse2, swizzle_bgra_sse2, coverage_blend_sse2};
+                break;
+            case SimdLevel::AVX2:
+                table = {level, clear_buffer_avx2, fill_span_avx2, alpha_blend_avx2, rgba_to_gray_avx2,
+                         rgba_to_rgb565_avx2, premultiply_avx2, swizzle_bgra_avx2, coverage_blend_sse2};
+                break;
 #endif
+#ifdef PIXELTREE_HAS_NEON
+            case SimdLevel::NEON:
+                table = {level, clear_buffer_neon, fill_span_neon, alpha_blend_neon, rgba_to_gray_neon,
+                         rgba_to_rgb565_neon, premultiply_neon, swizzle_bgra_neon, coverage_blend_scalar};
+                break;
+#endif
+            default:
+                break;
+        }
+        return table;
     }
 
 private:
+    // Best level the CPU supports
+    static SimdLevel detect_level() noexcept {
+#ifdef PIXELTREE_SIMD_X86
+    #if defined(__GNUC__) || defined(__clang__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+    #elif defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int max_leaf = info[0];
+        __cpuid(info, 1);
+        const bool sse2 = (info[3] & (1 << 26)) != 0;
+        const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 &&
+                                  (_xgetbv(0) & 0x6) == 0x6;
+        if (max_leaf >= 7 && os_saves_ymm) {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5)) return SimdLevel::AVX2;
+        }
+        if (sse2) return SimdLevel::SSE2;
+    #endif
+#elif defined(PIXELTREE_HAS_NEON)
+        return SimdLevel::NEON;
+#endif
+        return SimdLevel::Scalar;
+    }
+    
+    // Exact round(x / 255) for x in [0, 255 * 255], the same formula every
+    // vector path evaluates in 16-bit lanes
+    static constexpr uint32_t div255(uint32_t x) noexcept {
+        const uint32_t t = x + 128;
+        return (t + (t >> 8)) >> 8;
+    }
+    
     // Scalar fallback implementations
     static void clear_buffer_scalar(uint32_t* data, size_t count, uint32_t value) {
         for (size_t i = 0; i < count; ++i) {
@@ -38,40 +284,53 @@ private:
         }
     }
     
+    static void fill_span_scalar(uint32_t* data, size_t count, uint32_t value) {
+        for (size_t i = 0; i < count; ++i) {
+            data[i] = value;
+        }
+    }
+    
     static void alpha_blend_scalar(uint32_t* dest, const uint32_t* src, size_t count) {
         for (size_t i = 0; i < count; ++i) {
-            dest[i] = blend_pixel_scalar(dest[i], src[i]);
+            dest[i] = blend_pixel(dest[i], src[i]);
         }
     }
     
-    static uint32_t blend_pixel_scalar(uint32_t bg, uint32_t fg) {
-        const uint8_t alpha = fg & 0xFF;
-        if (alpha == 0) return bg;
-        if (alpha == 255) return fg;
-        
-        const float a = alpha / 255.0f;
-        const float inv_a = 1.0f - a;
-        
-        const uint8_t bg_r = (bg >> 24) & 0xFF;
-        const uint8_t bg_g = (bg >> 16) & 0xFF;
-        const uint8_t bg_b = (bg >> 8) & 0xFF;
-        
-        const uint8_t fg_r = (fg >> 24) & 0xFF;
-        const uint8_t fg_g = (fg >> 16) & 0xFF;
-        const uint8_t fg_b = (fg >> 8) & 0xFF;
-        
-        const uint8_t r = static_cast<uint8_t>(bg_r * inv_a + fg_r * a);
-        const uint8_t g = static_cast<uint8_t>(bg_g * inv_a + fg_g * a);
-        const uint8_t b = static_cast<uint8_t>(bg_b * inv_a + fg_b * a);
-        
-        return (r << 24) | (g << 16) | (b << 8) | 255;
+    static void rgba_to_gray_scalar(uint8_t* dest, const uint32_t* src, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            dest[i] = gray_pixel(src[i]);
+        }
+    }
+    
+    static void rgba_to_rgb565_scalar(uint16_t* dest, const uint32_t* src, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            dest[i] = rgb565_pixel(src[i]);
+        }
+    }
+    
+    static void premultiply_scalar(uint32_t* dest, const uint32_t* src, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            dest[i] = premultiply_pixel(src[i]);
+        }
+    }
+    
+    static void swizzle_bgra_scalar(uint32_t* dest, const uint32_t* src, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            dest[i] = bgra_pixel(src[i]);
+        }
+    }
+    
+    static void coverage_blend_scalar(uint32_t* dest, const uint32_t* src, const uint8_t* coverage, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            dest[i] = coverage_pixel(dest[i], src[i], coverage[i]);
+        }
     }
 
-#ifdef PIXELTREE_HAS_SSE2
+#ifdef PIXELTREE_SIMD_X86
+    PIXELTREE_TARGET_SSE2
     static void clear_buffer_sse2(uint32_t* data, size_t count, uint32_t value) {
-        const __m128i fill_value = _mm_set1_epi32(value);
+        const __m128i fill_value = _mm_set1_epi32(static_cast<int>(value));
         const size_t simd_count = count / 4;
-        const size_t remainder = count % 4;
         
         for (size_t i = 0; i < simd_count; ++i) {
             _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i * 4), fill_value);
@@ -83,30 +342,237 @@ private:
         }
     }
     
+    // count >= 4: the tail is one overlapping store instead of a scalar loop
+    PIXELTREE_TARGET_SSE2
+    static void fill_span_sse2(uint32_t* data, size_t count, uint32_t value) {
+        const __m128i fill_value = _mm_set1_epi32(static_cast<int>(value));
+        for (size_t i = 0; i + 4 <= count; i += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), fill_value);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + count - 4), fill_value);
+    }
+    
+    // Blend two pixels held as eight 16-bit channels
+    PIXELTREE_TARGET_SSE2
+    static __m128i blend_channels_sse2(__m128i bg, __m128i fg) {
+        // Broadcast each pixel's alpha (lane 0 of its four channels)
+        const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(fg, 0x00), 0x00);
+        const __m128i inv_alpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+        
+        __m128i mixed = _mm_add_epi16(_mm_mullo_epi16(fg, alpha), _mm_mullo_epi16(bg, inv_alpha));
+        mixed = _mm_add_epi16(mixed, _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(mixed, _mm_srli_epi16(mixed, 8)), 8);
+    }
+    
+    // Blend four pixels
+    PIXELTREE_TARGET_SSE2
+    static __m128i blend4_sse2(__m128i bg, __m128i fg) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alpha_mask = _mm_set1_epi32(0xFF);
+        
+        const __m128i lo = blend_channels_sse2(_mm_unpacklo_epi8(bg, zero), _mm_unpacklo_epi8(fg, zero));
+        const __m128i hi = blend_channels_sse2(_mm_unpackhi_epi8(bg, zero), _mm_unpackhi_epi8(fg, zero));
+        const __m128i blended = _mm_or_si128(_mm_packus_epi16(lo, hi), alpha_mask);
+        
+        // Fully transparent source pixels keep the background untouched
+        const __m128i keep = _mm_cmpeq_epi32(_mm_and_si128(fg, alpha_mask), zero);
+        return _mm_or_si128(_mm_and_si128(keep, bg), _mm_andnot_si128(keep, blended));
+    }
+    
+    PIXELTREE_TARGET_SSE2
     static void alpha_blend_sse2(uint32_t* dest, const uint32_t* src, size_t count) {
-        // Simplified SSE2 alpha blending
+        const __m128i alpha_mask = _mm_set1_epi32(0xFF);
+        const __m128i zero = _mm_setzero_si128();
         const size_t simd_count = count / 4;
-        const size_t remainder = count % 4;
         
         for (size_t i = 0; i < simd_count; ++i) {
-            // Process 4 pixels at once (simplified implementation)
-            for (int j = 0; j < 4; ++j) {
-                dest[i * 4 + j] = blend_pixel_scalar(dest[i * 4 + j], src[i * 4 + j]);
+            auto* d = reinterpret_cast<__m128i*>(dest + i * 4);
+            const __m128i fg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            const __m128i alpha = _mm_and_si128(fg, alpha_mask);
+            
+            // Sprites are mostly fully transparent or fully opaque runs
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF) {
+                continue;
+            }
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alpha_mask)) == 0xFFFF) {
+                _mm_storeu_si128(d, fg);
+                continue;
             }
+            _mm_storeu_si128(d, blend4_sse2(_mm_loadu_si128(d), fg));
         }
         
         // Handle remainder
         for (size_t i = simd_count * 4; i < count; ++i) {
-            dest[i] = blend_pixel_scalar(dest[i], src[i]);
+            dest[i] = blend_pixel(dest[i], src[i]);
         }
     }
-#endif
-
-#ifdef PIXELTREE_HAS_AVX2
+    
+    // Anti-aliased fringes fall on transparent background or on opaque
+    // shapes; groups of four with any other destination go through
+    // coverage_pixel. The AVX2 table uses this kernel too, fringe runs being
+    // only a few pixels long.
+    PIXELTREE_TARGET_SSE2
+    static void coverage_blend_sse2(uint32_t* dest, const uint32_t* src, const uint8_t* coverage, size_t count) {
+        const __m128i alpha_mask = _mm_set1_epi32(0xFF);
+        const __m128i color_mask = _mm_set1_epi32(static_cast<int>(0xFFFFFF00u));
+        const __m128i zero = _mm_setzero_si128();
+        const size_t simd_count = count / 4;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            auto* d = reinterpret_cast<__m128i*>(dest + i * 4);
+            const __m128i bg = _mm_loadu_si128(d);
+            const __m128i fg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            
+            const __m128i clear = _mm_cmpeq_epi32(_mm_and_si128(bg, alpha_mask), zero);
+            const __m128i opaque = _mm_cmpeq_epi32(_mm_and_si128(_mm_and_si128(bg, fg), alpha_mask), alpha_mask);
+            if (_mm_movemask_epi8(_mm_or_si128(clear, opaque)) != 0xFFFF) {
+                for (size_t j = i * 4; j < i * 4 + 4; ++j) {
+                    dest[j] = coverage_pixel(dest[j], src[j], coverage[j]);
+                }
+                continue;
+            }
+            
+            int packed = 0;
+            std::memcpy(&packed, coverage + i * 4, sizeof(packed));
+            const __m128i cover = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+            const __m128i color = _mm_and_si128(fg, color_mask);
+            
+            // Opaque lanes: blend with the coverage as alpha
+            const __m128i mixed = blend4_sse2(bg, _mm_or_si128(color, cover));
+            
+            // Transparent lanes: source color with alpha * coverage; both are
+            // below 256, so the 16-bit product is exact
+            const __m128i faded_alpha = _mm_add_epi32(_mm_mullo_epi16(_mm_and_si128(fg, alpha_mask), cover),
+                                                      _mm_set1_epi32(128));
+            const __m128i faded = _mm_or_si128(color, _mm_srli_epi32(
+                _mm_add_epi32(faded_alpha, _mm_srli_epi32(faded_alpha, 8)), 8));
+            
+            // Zero coverage keeps the destination as it is
+            const __m128i keep = _mm_cmpeq_epi32(cover, zero);
+            const __m128i result = _mm_or_si128(_mm_and_si128(opaque, mixed), _mm_andnot_si128(opaque, faded));
+            _mm_storeu_si128(d, _mm_or_si128(_mm_and_si128(keep, bg), _mm_andnot_si128(keep, result)));
+        }
+        
+        // Handle remainder
+        for (size_t i = simd_count * 4; i < count; ++i) {
+            dest[i] = coverage_pixel(dest[i], src[i], coverage[i]);
+        }
+    }
+    
+    // Luma of four pixels in 32-bit lanes. Every partial sum fits in 16 bits,
+    // so 16-bit multiplies are exact and the upper halves stay zero.
+    PIXELTREE_TARGET_SSE2
+    static __m128i gray4_sse2(__m128i rgba) {
+        const __m128i byte_mask = _mm_set1_epi32(0xFF);
+        const __m128i r = _mm_srli_epi32(rgba, 24);
+        const __m128i g = _mm_and_si128(_mm_srli_epi32(rgba, 16), byte_mask);
+        const __m128i b = _mm_and_si128(_mm_srli_epi32(rgba, 8), byte_mask);
+        
+        __m128i luma = _mm_mullo_epi16(r, _mm_set1_epi32(77));
+        luma = _mm_add_epi32(luma, _mm_mullo_epi16(g, _mm_set1_epi32(150)));
+        luma = _mm_add_epi32(luma, _mm_mullo_epi16(b, _mm_set1_epi32(29)));
+        return _mm_srli_epi32(_mm_add_epi32(luma, _mm_set1_epi32(128)), 8);
+    }
+    
+    PIXELTREE_TARGET_SSE2
+    static void rgba_to_gray_sse2(uint8_t* dest, const uint32_t* src, size_t count) {
+        const size_t simd_count = count / 16;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            const auto* s = reinterpret_cast<const __m128i*>(src + i * 16);
+            const __m128i y0 = gray4_sse2(_mm_loadu_si128(s + 0));
+            const __m128i y1 = gray4_sse2(_mm_loadu_si128(s + 1));
+            const __m128i y2 = gray4_sse2(_mm_loadu_si128(s + 2));
+            const __m128i y3 = gray4_sse2(_mm_loadu_si128(s + 3));
+            const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(y0, y1), _mm_packs_epi32(y2, y3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 16), packed);
+        }
+        
+        // Handle remainder
+        for (size_t i = simd_count * 16; i < count; ++i) {
+            dest[i] = gray_pixel(src[i]);
+        }
+    }
+    
+    // RGB565 of four pixels, one per 32-bit lane
+    PIXELTREE_TARGET_SSE2
+    static __m128i rgb565x4_sse2(__m128i rgba) {
+        const __m128i r = _mm_and_si128(_mm_srli_epi32(rgba, 16), _mm_set1_epi32(0xF800));
+        const __m128i g = _mm_and_si128(_mm_srli_epi32(rgba, 13), _mm_set1_epi32(0x07E0));
+        const __m128i b = _mm_and_si128(_mm_srli_epi32(rgba, 11), _mm_set1_epi32(0x001F));
+        return _mm_or_si128(_mm_or_si128(r, g), b);
+    }
+    
+    PIXELTREE_TARGET_SSE2
+    static void rgba_to_rgb565_sse2(uint16_t* dest, const uint32_t* src, size_t count) {
+        // SSE2 only has a signed 32-to-16 pack, so shift into the signed range and back
+        const __m128i bias32 = _mm_set1_epi32(0x8000);
+        const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+        const size_t simd_count = count / 8;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            const auto* s = reinterpret_cast<const __m128i*>(src + i * 8);
+            const __m128i lo = _mm_sub_epi32(rgb565x4_sse2(_mm_loadu_si128(s + 0)), bias32);
+            const __m128i hi = _mm_sub_epi32(rgb565x4_sse2(_mm_loadu_si128(s + 1)), bias32);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 8),
+                             _mm_add_epi16(_mm_packs_epi32(lo, hi), bias16));
+        }
+        
+        // Handle remainder
+        for (size_t i = simd_count * 8; i < count; ++i) {
+            dest[i] = rgb565_pixel(src[i]);
+        }
+    }
+    
+    // Premultiply two pixels held as eight 16-bit channels (alpha lane is fixed up by the caller)
+    PIXELTREE_TARGET_SSE2
+    static __m128i premultiply_channels_sse2(__m128i channels) {
+        const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(channels, 0x00), 0x00);
+        const __m128i mixed = _mm_add_epi16(_mm_mullo_epi16(channels, alpha), _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(mixed, _mm_srli_epi16(mixed, 8)), 8);
+    }
+    
+    PIXELTREE_TARGET_SSE2
+    static void premultiply_sse2(uint32_t* dest, const uint32_t* src, size_t count) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alpha_mask = _mm_set1_epi32(0xFF);
+        const size_t simd_count = count / 4;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            const __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            const __m128i lo = premultiply_channels_sse2(_mm_unpacklo_epi8(rgba, zero));
+            const __m128i hi = premultiply_channels_sse2(_mm_unpackhi_epi8(rgba, zero));
+            const __m128i scaled = _mm_packus_epi16(lo, hi);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4),
+                             _mm_or_si128(_mm_andnot_si128(alpha_mask, scaled), _mm_and_si128(rgba, alpha_mask)));
+        }
+        
+        // Handle remainder
+        for (size_t i = simd_count * 4; i < count; ++i) {
+            dest[i] = premultiply_pixel(src[i]);
+        }
+    }
+    
+    PIXELTREE_TARGET_SSE2
+    static void swizzle_bgra_sse2(uint32_t* dest, const uint32_t* src, size_t count) {
+        const size_t simd_count = count / 4;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            const __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4),
+                             _mm_or_si128(_mm_srli_epi32(rgba, 8), _mm_slli_epi32(rgba, 24)));
+        }
+        
+        // Handle remainder
+        for (size_t i = simd_count * 4; i < count; ++i) {
+            dest[i] = bgra_pixel(src[i]);
+        }
+    }
+    
+    PIXELTREE_TARGET_AVX2
     static void clear_buffer_avx2(uint32_t* data, size_t count, uint32_t value) {
-        const __m256i fill_value = _mm256_set1_epi32(value);
+        const __m256i fill_value = _mm256_set1_epi32(static_cast<int>(value));
         const size_t simd_count = count / 8;
-        const size_t remainder = count % 8;
         
         for (size_t i = 0; i < simd_count; ++i) {
             _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i * 8), fill_value);
@@ -118,22 +584,657 @@ private:
         }
     }
     
+    // count >= 4: the tail is one overlapping store instead of a scalar loop
+    PIXELTREE_TARGET_AVX2
+    static void fill_span_avx2(uint32_t* data, size_t count, uint32_t value) {
+        if (count < 8) {
+            fill_span_sse2(data, count, value);
+            return;
+        }
+        const __m256i fill_value = _mm256_set1_epi32(static_cast<int>(value));
+        for (size_t i = 0; i + 8 <= count; i += 8) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), fill_value);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + count - 8), fill_value);
+    }
+    
+    // Blend four pixels per 128-bit lane, held as sixteen 16-bit channels
+    PIXELTREE_TARGET_AVX2
+    static __m256i blend_channels_avx2(__m256i bg, __m256i fg) {
+        const __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(fg, 0x00), 0x00);
+        const __m256i inv_alpha = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+        
+        __m256i mixed = _mm256_add_epi16(_mm256_mullo_epi16(fg, alpha), _mm256_mullo_epi16(bg, inv_alpha));
+        mixed = _mm256_add_epi16(mixed, _mm256_set1_epi16(128));
+        return _mm256_srli_epi16(_mm256_add_epi16(mixed, _mm256_srli_epi16(mixed, 8)), 8);
+    }
+    
+    PIXELTREE_TARGET_AVX2
     static void alpha_blend_avx2(uint32_t* dest, const uint32_t* src, size_t count) {
-        // Simplified AVX2 alpha blending
+        const __m256i alpha_mask = _mm256_set1_epi32(0xFF);
+        const __m256i zero = _mm256_setzero_si256();
         const size_t simd_count = count / 8;
-        const size_t remainder = count % 8;
         
         for (size_t i = 0; i < simd_count; ++i) {
-            // Process 8 pixels at once (simplified implementation)
-            for (int j = 0; j < 8; ++j) {
-                dest[i * 8 + j] = blend_pixel_scalar(dest[i * 8 + j], src[i * 8 + j]);
+            auto* d = reinterpret_cast<__m256i*>(dest + i * 8);
+            const __m256i fg = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 8));
+            const __m256i alpha = _mm256_and_si256(fg, alpha_mask);
+            const __m256i keep = _mm256_cmpeq_epi32(alpha, zero);
+            
+            // Sprites are mostly fully transparent or fully opaque runs
+            if (_mm256_movemask_epi8(keep) == -1) {
+                continue;
             }
+            if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, alpha_mask)) == -1) {
+                _mm256_storeu_si256(d, fg);
+                continue;
+            }
+            
+            // Unpack and pack both work within 128-bit lanes, so pixel order is preserved
+            const __m256i bg = _mm256_loadu_si256(d);
+            const __m256i lo = blend_channels_avx2(_mm256_unpacklo_epi8(bg, zero), _mm256_unpacklo_epi8(fg, zero));
+            const __m256i hi = blend_channels_avx2(_mm256_unpackhi_epi8(bg, zero), _mm256_unpackhi_epi8(fg, zero));
+            const __m256i blended = _mm256_or_si256(_mm256_packus_epi16(lo, hi), alpha_mask);
+            _mm256_storeu_si256(d, _mm256_blendv_epi8(blended, bg, keep));
+        }
+        
+        // Handle remainder with the SSE2 kernel, then scalar
+        size_t i = simd_count * 8;
+        if (count - i >= 4) {
+            alpha_blend_sse2(dest + i, src + i, 4);
+            i += 4;
+        }
+        for (; i < count; ++i) {
+            dest[i] = blend_pixel(dest[i], src[i]);
+        }
+    }
+    
+    // Luma of eight pixels in 32-bit lanes, see gray4_sse2
+    PIXELTREE_TARGET_AVX2
+    static __m256i gray8_avx2(__m256i rgba) {
+        const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+        const __m256i r = _mm256_srli_epi32(rgba, 24);
+        const __m256i g = _mm256_and_si256(_mm256_srli_epi32(rgba, 16), byte_mask);
+        const __m256i b = _mm256_and_si256(_mm256_srli_epi32(rgba, 8), byte_mask);
+        
+        __m256i luma = _mm256_mullo_epi16(r, _mm256_set1_epi32(77));
+        luma = _mm256_add_epi32(luma, _mm256_mullo_epi16(g, _mm256_set1_epi32(150)));
+        luma = _mm256_add_epi32(luma, _mm256_mullo_epi16(b, _mm256_set1_epi32(29)));
+        return _mm256_srli_epi32(_mm256_add_epi32(luma, _mm256_set1_epi32(128)), 8);
+    }
+    
+    PIXELTREE_TARGET_AVX2
+    static void rgba_to_gray_avx2(uint8_t* dest, const uint32_t* src, size_t count) {
+        // The in-lane packs leave 4-byte groups interleaved across lanes; this
+        // permutation restores pixel order
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        const size_t simd_count = count / 32;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            const auto* s = reinterpret_cast<const __m256i*>(src + i * 32);
+            const __m256i y0 = gray8_avx2(_mm256_loadu_si256(s + 0));
+            const __m256i y1 = gray8_avx2(_mm256_loadu_si256(s + 1));
+            const __m256i y2 = gray8_avx2(_mm256_loadu_si256(s + 2));
+            const __m256i y3 = gray8_avx2(_mm256_loadu_si256(s + 3));
+            const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(y0, y1), _mm256_packs_epi32(y2, y3));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 32),
+                                _mm256_permutevar8x32_epi32(packed, order));
+        }
+        
+        // Handle remainder with the SSE2 kernel
+        const size_t done = simd_count * 32;
+        rgba_to_gray_sse2(dest + done, src + done, count - done);
+    }
+    
+    PIXELTREE_TARGET_AVX2
+    static __m256i rgb565x8_avx2(__m256i rgba) {
+        const __m256i r = _mm256_and_si256(_mm256_srli_epi32(rgba, 16), _mm256_set1_epi32(0xF800));
+        const __m256i g = _mm256_and_si256(_mm256_srli_epi32(rgba, 13), _mm256_set1_epi32(0x07E0));
+        const __m256i b = _mm256_and_si256(_mm256_srli_epi32(rgba, 11), _mm256_set1_epi32(0x001F));
+        return _mm256_or_si256(_mm256_or_si256(r, g), b);
+    }
+    
+    PIXELTREE_TARGET_AVX2
+    static void rgba_to_rgb565_avx2(uint16_t* dest, const uint32_t* src, size_t count) {
+        const size_t simd_count = count / 16;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            const auto* s = reinterpret_cast<const __m256i*>(src + i * 16);
+            const __m256i packed = _mm256_packus_epi32(rgb565x8_avx2(_mm256_loadu_si256(s + 0)),
+                                                       rgb565x8_avx2(_mm256_loadu_si256(s + 1)));
+            // Undo the in-lane interleave of the pack
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 16),
+                                _mm256_permute4x64_epi64(packed, 0xD8));
+        }
+        
+        // Handle remainder with the SSE2 kernel
+        const size_t done = simd_count * 16;
+        rgba_to_rgb565_sse2(dest + done, src + done, count - done);
+    }
+    
+    PIXELTREE_TARGET_AVX2
+    static __m256i premultiply_channels_avx2(__m256i channels) {
+        const __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(channels, 0x00), 0x00);
+        const __m256i mixed = _mm256_add_epi16(_mm256_mullo_epi16(channels, alpha), _mm256_set1_epi16(128));
+        return _mm256_srli_epi16(_mm256_add_epi16(mixed, _mm256_srli_epi16(mixed, 8)), 8);
+    }
+    
+    PIXELTREE_TARGET_AVX2
+    static void premultiply_avx2(uint32_t* dest, const uint32_t* src, size_t count) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i alpha_mask = _mm256_set1_epi32(0xFF);
+        const size_t simd_count = count / 8;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            const __m256i rgba = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 8));
+            const __m256i lo = premultiply_channels_avx2(_mm256_unpacklo_epi8(rgba, zero));
+            const __m256i hi = premultiply_channels_avx2(_mm256_unpackhi_epi8(rgba, zero));
+            const __m256i scaled = _mm256_packus_epi16(lo, hi);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 8),
+                                _mm256_or_si256(_mm256_andnot_si256(alpha_mask, scaled),
+                                                _mm256_and_si256(rgba, alpha_mask)));
+        }
+        
+        // Handle remainder with the SSE2 kernel
+        const size_t done = simd_count * 8;
+        premultiply_sse2(dest + done, src + done, count - done);
+    }
+    
+    PIXELTREE_TARGET_AVX2
+    static void swizzle_bgra_avx2(uint32_t* dest, const uint32_t* src, size_t count) {
+        const size_t simd_count = count / 8;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            const __m256i rgba = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 8));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 8),
+                                _mm256_or_si256(_mm256_srli_epi32(rgba, 8), _mm256_slli_epi32(rgba, 24)));
+        }
+        
+        // Handle remainder with the SSE2 kernel
+        const size_t done = simd_count * 8;
+        swizzle_bgra_sse2(dest + done, src + done, count - done);
+    }
+#endif
+
+#ifdef PIXELTREE_HAS_NEON
+    static void clear_buffer_neon(uint32_t* data, size_t count, uint32_t value) {
+        const uint32x4_t fill_value = vdupq_n_u32(value);
+        const size_t simd_count = count / 4;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            vst1q_u32(data + i * 4, fill_value);
         }
         
         // Handle remainder
-        for (size_t i = simd_count * 8; i < count; ++i) {
-            dest[i] = blend_pixel_scalar(dest[i], src[i]);
+        for (size_t i = simd_count * 4; i < count; ++i) {
+            data[i] = value;
+        }
+    }
+    
+    // count >= 4: the tail is one overlapping store instead of a scalar loop
+    static void fill_span_neon(uint32_t* data, size_t count, uint32_t value) {
+        const uint32x4_t fill_value = vdupq_n_u32(value);
+        for (size_t i = 0; i + 4 <= count; i += 4) {
+            vst1q_u32(data + i, fill_value);
+        }
+        vst1q_u32(data + count - 4, fill_value);
+    }
+    
+    // True when every lane of the comparison mask is set (vminvq is AArch64 only)
+    static bool all_lanes_neon(uint32x4_t mask) {
+        const uint32x2_t folded = vand_u32(vget_low_u32(mask), vget_high_u32(mask));
+        return (vget_lane_u32(folded, 0) & vget_lane_u32(folded, 1)) == 0xFFFFFFFFu;
+    }
+    
+    // round(x / 255) for eight 16-bit channels, narrowed to bytes
+    static uint8x8_t div255_neon(uint16x8_t mixed) {
+        return vraddhn_u16(mixed, vrshrq_n_u16(mixed, 8));
+    }
+    
+    static void alpha_blend_neon(uint32_t* dest, const uint32_t* src, size_t count) {
+        const uint32x4_t alpha_mask = vdupq_n_u32(0xFF);
+        const size_t simd_count = count / 4;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            const uint32x4_t fg = vld1q_u32(src + i * 4);
+            const uint32x4_t alpha = vandq_u32(fg, alpha_mask);
+            
+            // Sprites are mostly fully transparent or fully opaque runs
+            const uint32x4_t keep = vceqq_u32(alpha, vdupq_n_u32(0));
+            if (all_lanes_neon(keep)) {
+                continue;
+            }
+            if (all_lanes_neon(vceqq_u32(alpha, alpha_mask))) {
+                vst1q_u32(dest + i * 4, fg);
+                continue;
+            }
+            
+            const uint32x4_t bg = vld1q_u32(dest + i * 4);
+            
+            // Broadcast each pixel's alpha to its four bytes
+            const uint8x16_t a = vreinterpretq_u8_u32(vmulq_n_u32(alpha, 0x01010101u));
+            const uint8x16_t inv_a = vmvnq_u8(a);
+            const uint8x16_t fg8 = vreinterpretq_u8_u32(fg);
+            const uint8x16_t bg8 = vreinterpretq_u8_u32(bg);
+            
+            const uint16x8_t mixed_lo = vmlal_u8(vmull_u8(vget_low_u8(fg8), vget_low_u8(a)),
+                                                 vget_low_u8(bg8), vget_low_u8(inv_a));
+            const uint16x8_t mixed_hi = vmlal_u8(vmull_u8(vget_high_u8(fg8), vget_high_u8(a)),
+                                                 vget_high_u8(bg8), vget_high_u8(inv_a));
+            
+            const uint32x4_t blended = vorrq_u32(
+                vreinterpretq_u32_u8(vcombine_u8(div255_neon(mixed_lo), div255_neon(mixed_hi))), alpha_mask);
+            vst1q_u32(dest + i * 4, vbslq_u32(keep, bg, blended));
+        }
+        
+        // Handle remainder
+        for (size_t i = simd_count * 4; i < count; ++i) {
+            dest[i] = blend_pixel(dest[i], src[i]);
+        }
+    }
+    
+    static void rgba_to_gray_neon(uint8_t* dest, const uint32_t* src, size_t count) {
+        const size_t simd_count = count / 16;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            // Little-endian bytes of each pixel are A, B, G, R
+            const uint8x16x4_t channels = vld4q_u8(reinterpret_cast<const uint8_t*>(src + i * 16));
+            const uint8x16_t r = channels.val[3];
+            const uint8x16_t g = channels.val[2];
+            const uint8x16_t b = channels.val[1];
+            
+            uint16x8_t lo = vmull_u8(vget_low_u8(r), vdup_n_u8(77));
+            lo = vmlal_u8(lo, vget_low_u8(g), vdup_n_u8(150));
+            lo = vmlal_u8(lo, vget_low_u8(b), vdup_n_u8(29));
+            uint16x8_t hi = vmull_u8(vget_high_u8(r), vdup_n_u8(77));
+            hi = vmlal_u8(hi, vget_high_u8(g), vdup_n_u8(150));
+            hi = vmlal_u8(hi, vget_high_u8(b), vdup_n_u8(29));
+            
+            vst1q_u8(dest + i * 16, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+        }
+        
+        // Handle remainder
+        for (size_t i = simd_count * 16; i < count; ++i) {
+            dest[i] = gray_pixel(src[i]);
+        }
+    }
+    
+    static void rgba_to_rgb565_neon(uint16_t* dest, const uint32_t* src, size_t count) {
+        const uint32x4_t r_mask = vdupq_n_u32(0xF800);
+        const uint32x4_t g_mask = vdupq_n_u32(0x07E0);
+        const uint32x4_t b_mask = vdupq_n_u32(0x001F);
+        const size_t simd_count = count / 4;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            const uint32x4_t rgba = vld1q_u32(src + i * 4);
+            const uint32x4_t packed = vorrq_u32(vorrq_u32(vandq_u32(vshrq_n_u32(rgba, 16), r_mask),
+                                                          vandq_u32(vshrq_n_u32(rgba, 13), g_mask)),
+                                                vandq_u32(vshrq_n_u32(rgba, 11), b_mask));
+            vst1_u16(dest + i * 4, vmovn_u32(packed));
+        }
+        
+        // Handle remainder
+        for (size_t i = simd_count * 4; i < count; ++i) {
+            dest[i] = rgb565_pixel(src[i]);
+        }
+    }
+    
+    static void premultiply_neon(uint32_t* dest, const uint32_t* src, size_t count) {
+        const size_t simd_count = count / 16;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            // Little-endian bytes of each pixel are A, B, G, R
+            uint8x16x4_t channels = vld4q_u8(reinterpret_cast<const uint8_t*>(src + i * 16));
+            const uint8x16_t alpha = channels.val[0];
+            for (int c = 1; c < 4; ++c) {
+                const uint16x8_t lo = vmull_u8(vget_low_u8(channels.val[c]), vget_low_u8(alpha));
+                const uint16x8_t hi = vmull_u8(vget_high_u8(channels.val[c]), vget_high_u8(alpha));
+                channels.val[c] = vcombine_u8(div255_neon(lo), div255_neon(hi));
+            }
+            vst4q_u8(reinterpret_cast<uint8_t*>(dest + i * 16), channels);
+        }
+        
+        // Handle remainder
+        for (size_t i = simd_count * 16; i < count; ++i) {
+            dest[i] = premultiply_pixel(src[i]);
+        }
+    }
+    
+    static void swizzle_bgra_neon(uint32_t* dest, const uint32_t* src, size_t count) {
+        const size_t simd_count = count / 4;
+        
+        for (size_t i = 0; i < simd_count; ++i) {
+            const uint32x4_t rgba = vld1q_u32(src + i * 4);
+            vst1q_u32(dest + i * 4, vorrq_u32(vshrq_n_u32(rgba, 8), vshlq_n_u32(rgba, 24)));
+        }
+        
+        // Handle remainder
+        for (size_t i = simd_count * 4; i < count; ++i) {
+            dest[i] = bgra_pixel(src[i]);
+        }
+    }
+#endif
+};
+
+// Axis-aligned bounds produced by the geometry reductions
+struct Bounds {
+    float min_x = std::numeric_limits<float>::max();
+    float min_y = std::numeric_limits<float>::max();
+    float max_x = std::numeric_limits<float>::lowest();
+    float max_y = std::numeric_limits<float>::lowest();
+    
+    bool empty() const noexcept { return min_x > max_x; }
+    
+    void merge(const Bounds& other) noexcept {
+        min_x = std::min(min_x, other.min_x);
+        min_y = std::min(min_y, other.min_y);
+        max_x = std::max(max_x, other.max_x);
+        max_y = std::max(max_y, other.max_y);
+    }
+};
+
+// Function pointers of the geometry reductions for one instruction set
+struct GeometryKernelTable {
+    SimdLevel level = SimdLevel::Scalar;
+    Bounds (*segment_bounds)(const float* start_x, const float* start_y, const float* end_x,
+                             const float* end_y, const float* thickness, size_t count) = nullptr;
+    Bounds (*circle_bounds)(const float* x, const float* y, const float* radius, size_t count) = nullptr;
+    int32_t (*max_value)(const int32_t* values, size_t count) = nullptr;  // count > 0
+};
+
+// SIMD reductions over structure-of-arrays geometry
+//
+// Dispatched like PixelOperations: the x86 kernels carry target attributes
+// and the table matching PixelOperations::active_level is picked on first use.
+class GeometryOperations {
+public:
+    // Bounds of thick segments: min/max of both endpoints, grown by half the thickness
+    static Bounds segment_bounds(const float* start_x, const float* start_y,
+                                 const float* end_x, const float* end_y,
+                                 const float* thickness, size_t count) {
+        return kernels().segment_bounds(start_x, start_y, end_x, end_y, thickness, count);
+    }
+    
+    // Bounds of circles given by center and radius
+    static Bounds circle_bounds(const float* x, const float* y, const float* radius, size_t count) {
+        return kernels().circle_bounds(x, y, radius, count);
+    }
+    
+    // Largest value in an int array (`fallback` when empty)
+    static int32_t max_value(const int32_t* values, size_t count, int32_t fallback = 0) {
+        if (count == 0) {
+            return fallback;
+        }
+        return kernels().max_value(values, count);
+    }
+    
+    // Kernel table selected for this CPU
+    static const GeometryKernelTable& kernels() noexcept {
+        static const GeometryKernelTable table = table_for(PixelOperations::active_level());
+        return table;
+    }
+    
+    // Kernels for a specific level; levels without geometry kernels, or that
+    // the CPU cannot run, fall back to scalar
+    static GeometryKernelTable table_for(SimdLevel level) noexcept {
+        GeometryKernelTable table{SimdLevel::Scalar, segment_bounds_scalar, circle_bounds_scalar, max_value_scalar};
+        if (!PixelOperations::supports(level)) {
+            return table;
+        }
+        
+        switch (level) {
+#ifdef PIXELTREE_SIMD_X86
+            case SimdLevel::SSE2:
+                table = {level, segment_bounds_sse2, circle_bounds_sse2, max_value_sse2};
+                break;
+            case SimdLevel::AVX2:
+                table = {level, segment_bounds_avx2, circle_bounds_avx2, max_value_avx2};
+                break;
+#endif
+            default:
+                break;
+        }
+        return table;
+    }
+
+private:
+    static Bounds segment_bounds_scalar(const float* start_x, const float* start_y,
+                                        const float* end_x, const float* end_y,
+                                        const float* thickness, size_t count) {
+        return segment_bounds_from(start_x, start_y, end_x, end_y, thickness, count, 0);
+    }
+    
+    static Bounds circle_bounds_scalar(const float* x, const float* y, const float* radius, size_t count) {
+        return circle_bounds_from(x, y, radius, count, 0);
+    }
+    
+    static int32_t max_value_scalar(const int32_t* values, size_t count) {
+        return max_value_from(values, count, 1, values[0]);
+    }
+    
+    // Scalar loops from element `first` on, also used for the SIMD remainders
+    static Bounds segment_bounds_from(const float* start_x, const float* start_y,
+                                      const float* end_x, const float* end_y,
+                                      const float* thickness, size_t count, size_t first,
+                                      Bounds bounds = {}) {
+        for (size_t i = first; i < count; ++i) {
+            const float half = thickness[i] * 0.5f;
+            bounds.min_x = std::min(bounds.min_x, std::min(start_x[i], end_x[i]) - half);
+            bounds.min_y = std::min(bounds.min_y, std::min(start_y[i], end_y[i]) - half);
+            bounds.max_x = std::max(bounds.max_x, std::max(start_x[i], end_x[i]) + half);
+            bounds.max_y = std::max(bounds.max_y, std::max(start_y[i], end_y[i]) + half);
+        }
+        return bounds;
+    }
+    
+    static Bounds circle_bounds_from(const float* x, const float* y, const float* radius,
+                                     size_t count, size_t first, Bounds bounds = {}) {
+        for (size_t i = first; i < count; ++i) {
+            bounds.min_x = std::min(bounds.min_x, x[i] - radius[i]);
+            bounds.min_y = std::min(bounds.min_y, y[i] - radius[i]);
+            bounds.max_x = std::max(bounds.max_x, x[i] + radius[i]);
+            bounds.max_y = std::max(bounds.max_y, y[i] + radius[i]);
+        }
+        return bounds;
+    }
+    
+    static int32_t max_value_from(const int32_t* values, size_t count, size_t first, int32_t result) {
+        for (size_t i = first; i < count; ++i) {
+            result = std::max(result, values[i]);
+        }
+        return result;
+    }
+
+#ifdef PIXELTREE_SIMD_X86
+    PIXELTREE_TARGET_SSE2
+    static float horizontal_min(__m128 v) {
+        v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(v);
+    }
+    
+    PIXELTREE_TARGET_SSE2
+    static float horizontal_max(__m128 v) {
+        v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(v);
+    }
+    
+    PIXELTREE_TARGET_SSE2
+    static Bounds reduce_bounds(__m128 min_x, __m128 min_y, __m128 max_x, __m128 max_y) {
+        Bounds bounds;
+        bounds.min_x = horizontal_min(min_x);
+        bounds.min_y = horizontal_min(min_y);
+        bounds.max_x = horizontal_max(max_x);
+        bounds.max_y = horizontal_max(max_y);
+        return bounds;
+    }
+    
+    PIXELTREE_TARGET_SSE2
+    static Bounds segment_bounds_sse2(const float* start_x, const float* start_y,
+                                      const float* end_x, const float* end_y,
+                                      const float* thickness, size_t count) {
+        const size_t simd_count = count / 4;
+        if (simd_count == 0) {
+            return segment_bounds_scalar(start_x, start_y, end_x, end_y, thickness, count);
+        }
+        
+        const __m128 half = _mm_set1_ps(0.5f);
+        __m128 min_x = _mm_set1_ps(std::numeric_limits<float>::max());
+        __m128 min_y = min_x;
+        __m128 max_x = _mm_set1_ps(std::numeric_limits<float>::lowest());
+        __m128 max_y = max_x;
+        
+        for (size_t i = 0; i < simd_count * 4; i += 4) {
+            const __m128 sx = _mm_loadu_ps(start_x + i);
+            const __m128 sy = _mm_loadu_ps(start_y + i);
+            const __m128 ex = _mm_loadu_ps(end_x + i);
+            const __m128 ey = _mm_loadu_ps(end_y + i);
+            const __m128 h = _mm_mul_ps(_mm_loadu_ps(thickness + i), half);
+            
+            min_x = _mm_min_ps(min_x, _mm_sub_ps(_mm_min_ps(sx, ex), h));
+            min_y = _mm_min_ps(min_y, _mm_sub_ps(_mm_min_ps(sy, ey), h));
+            max_x = _mm_max_ps(max_x, _mm_add_ps(_mm_max_ps(sx, ex), h));
+            max_y = _mm_max_ps(max_y, _mm_add_ps(_mm_max_ps(sy, ey), h));
+        }
+        
+        return segment_bounds_from(start_x, start_y, end_x, end_y, thickness, count,
+                                   simd_count * 4, reduce_bounds(min_x, min_y, max_x, max_y));
+    }
+    
+    PIXELTREE_TARGET_SSE2
+    static Bounds circle_bounds_sse2(const float* x, const float* y, const float* radius, size_t count) {
+        const size_t simd_count = count / 4;
+        if (simd_count == 0) {
+            return circle_bounds_scalar(x, y, radius, count);
+        }
+        
+        __m128 min_x = _mm_set1_ps(std::numeric_limits<float>::max());
+        __m128 min_y = min_x;
+        __m128 max_x = _mm_set1_ps(std::numeric_limits<float>::lowest());
+        __m128 max_y = max_x;
+        
+        for (size_t i = 0; i < simd_count * 4; i += 4) {
+            const __m128 cx = _mm_loadu_ps(x + i);
+            const __m128 cy = _mm_loadu_ps(y + i);
+            const __m128 r = _mm_loadu_ps(radius + i);
+            
+            min_x = _mm_min_ps(min_x, _mm_sub_ps(cx, r));
+            min_y = _mm_min_ps(min_y, _mm_sub_ps(cy, r));
+            max_x = _mm_max_ps(max_x, _mm_add_ps(cx, r));
+            max_y = _mm_max_ps(max_y, _mm_add_ps(cy, r));
+        }
+        
+        return circle_bounds_from(x, y, radius, count, simd_count * 4,
+                                  reduce_bounds(min_x, min_y, max_x, max_y));
+    }
+    
+    PIXELTREE_TARGET_SSE2
+    static int32_t max_value_sse2(const int32_t* values, size_t count) {
+        const size_t simd_count = count / 4;
+        if (simd_count == 0) {
+            return max_value_scalar(values, count);
+        }
+        
+        // SSE2 has no packed 32-bit max, so select through a compare mask
+        __m128i result = _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+        for (size_t i = 0; i < simd_count * 4; i += 4) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+            const __m128i greater = _mm_cmpgt_epi32(v, result);
+            result = _mm_or_si128(_mm_and_si128(greater, v), _mm_andnot_si128(greater, result));
+        }
+        
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), result);
+        const int32_t lane_max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+        return max_value_from(values, count, simd_count * 4, lane_max);
+    }
+    
+    PIXELTREE_TARGET_AVX2
+    static Bounds reduce_bounds(__m256 min_x, __m256 min_y, __m256 max_x, __m256 max_y) {
+        return reduce_bounds(
+            _mm_min_ps(_mm256_castps256_ps128(min_x), _mm256_extractf128_ps(min_x, 1)),
+            _mm_min_ps(_mm256_castps256_ps128(min_y), _mm256_extractf128_ps(min_y, 1)),
+            _mm_max_ps(_mm256_castps256_ps128(max_x), _mm256_extractf128_ps(max_x, 1)),
+            _mm_max_ps(_mm256_castps256_ps128(max_y), _mm256_extractf128_ps(max_y, 1)));
+    }
+    
+    PIXELTREE_TARGET_AVX2
+    static Bounds segment_bounds_avx2(const float* start_x, const float* start_y,
+                                      const float* end_x, const float* end_y,
+                                      const float* thickness, size_t count) {
+        const size_t simd_count = count / 8;
+        if (simd_count == 0) {
+            return segment_bounds_sse2(start_x, start_y, end_x, end_y, thickness, count);
+        }
+        
+        const __m256 half = _mm256_set1_ps(0.5f);
+        __m256 min_x = _mm256_set1_ps(std::numeric_limits<float>::max());
+        __m256 min_y = min_x;
+        __m256 max_x = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+        __m256 max_y = max_x;
+        
+        for (size_t i = 0; i < simd_count * 8; i += 8) {
+            const __m256 sx = _mm256_loadu_ps(start_x + i);
+            const __m256 sy = _mm256_loadu_ps(start_y + i);
+            const __m256 ex = _mm256_loadu_ps(end_x + i);
+            const __m256 ey = _mm256_loadu_ps(end_y + i);
+            const __m256 h = _mm256_mul_ps(_mm256_loadu_ps(thickness + i), half);
+            
+            min_x = _mm256_min_ps(min_x, _mm256_sub_ps(_mm256_min_ps(sx, ex), h));
+            min_y = _mm256_min_ps(min_y, _mm256_sub_ps(_mm256_min_ps(sy, ey), h));
+            max_x = _mm256_max_ps(max_x, _mm256_add_ps(_mm256_max_ps(sx, ex), h));
+            max_y = _mm256_max_ps(max_y, _mm256_add_ps(_mm256_max_ps(sy, ey), h));
+        }
+        
+        return segment_bounds_from(start_x, start_y, end_x, end_y, thickness, count,
+                                   simd_count * 8, reduce_bounds(min_x, min_y, max_x, max_y));
+    }
+    
+    PIXELTREE_TARGET_AVX2
+    static Bounds circle_bounds_avx2(const float* x, const float* y, const float* radius, size_t count) {
+        const size_t simd_count = count / 8;
+        if (simd_count == 0) {
+            return circle_bounds_sse2(x, y, radius, count);
         }
+        
+        __m256 min_x = _mm256_set1_ps(std::numeric_limits<float>::max());
+        __m256 min_y = min_x;
+        __m256 max_x = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+        __m256 max_y = max_x;
+        
+        for (size_t i = 0; i < simd_count * 8; i += 8) {
+            const __m256 cx = _mm256_loadu_ps(x + i);
+            const __m256 cy = _mm256_loadu_ps(y + i);
+            const __m256 r = _mm256_loadu_ps(radius + i);
+            
+            min_x = _mm256_min_ps(min_x, _mm256_sub_ps(cx, r));
+            min_y = _mm256_min_ps(min_y, _mm256_sub_ps(cy, r));
+            max_x = _mm256_max_ps(max_x, _mm256_add_ps(cx, r));
+            max_y = _mm256_max_ps(max_y, _mm256_add_ps(cy, r));
+        }
+        
+        return circle_bounds_from(x, y, radius, count, simd_count * 8,
+                                  reduce_bounds(min_x, min_y, max_x, max_y));
+    }
+    
+    PIXELTREE_TARGET_AVX2
+    static int32_t max_value_avx2(const int32_t* values, size_t count) {
+        const size_t simd_count = count / 8;
+        if (simd_count == 0) {
+            return max_value_sse2(values, count);
+        }
+        
+        __m256i result = _mm256_set1_epi32(std::numeric_limits<int32_t>::min());
+        for (size_t i = 0; i < simd_count * 8; i += 8) {
+            result = _mm256_max_epi32(result,
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)));
+        }
+        
+        alignas(32) int32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), result);
+        return max_value_from(values, count, simd_count * 8,
+                              *std::max_element(lanes, lanes + 8));
     }
 #endif
 };
@@ -0,0 +1,203 @@
+#pragma once
+#include "tree_parameters.hpp"
+#include "tree_structure.hpp"
+#include "lsystem.hpp"
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace pixeltree {
+
+// 64-bit FNV-1a over explicitly fed values, independent of struct layout
+class Fnv1a {
+    uint64_t state_ = 14695981039346656037ULL;
+
+public:
+    void add(uint32_t value) noexcept {
+        for (int byte = 0; byte < 4; ++byte) {
+            state_ = (state_ ^ ((value >> (byte * 8)) & 0xFFu)) * 1099511628211ULL;
+        }
+    }
+    
+    uint64_t value() const noexcept { return state_; }
+};
+
+// Everything the branch skeleton of a tree depends on
+//
+// Built from validated parameters. Canvas size, colors, leaves and season are
+// not part of it: the skeleton is built at the origin and those are applied
+// afterwards.
+struct StructureKey {
+    std::vector<uint32_t> fields;
+    uint64_t hash = 0;
+    
+    static StructureKey make(const TreeParameters& params, uint32_t seed, size_t max_segments,
+                             const CustomGrammar& custom_grammar, bool fixed_point = false) {
+        StructureKey key;
+        auto add_float = [&key](float value) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            key.fields.push_back(bits);
+        };
+        
+        key.fields.push_back(seed);
+        key.fields.push_back(static_cast<uint32_t>(params.type));
+        key.fields.push_back(static_cast<uint32_t>(std::min<size_t>(max_segments, UINT32_MAX)));
+        key.fields.push_back(fixed_point ? 1u : 0u);     // FixedGeometry turtle
+        add_float(params.overall_scale.get());
+        
+        const auto& branches = params.branches;
+        add_float(branches.base_thickness.get());
+        add_float(branches.thickness_decay.get());
+        add_float(branches.branch_probability.get());
+        add_float(branches.branch_angle_variation.get());
+        add_float(branches.curvature.get());
+        key.fields.push_back(static_cast<uint32_t>(branches.max_depth.get()));
+        key.fields.push_back(static_cast<uint32_t>(branches.max_branches.get()));
+        
+        if (params.type == TreeType::Custom) {
+            const RuleSet& rules = custom_grammar.rules;
+            add_float(rules.growth.length_factor);
+            add_float(rules.growth.thickness_factor);
+            add_float(rules.growth.angle_change);
+            key.fields.push_back(static_cast<uint32_t>(rules.split.branch_count));
+            add_float(rules.split.angle_spread);
+            add_float(rules.split.thickness_split);
+            add_float(rules.terminate.probability);
+            add_float(custom_grammar.production.turn_angle);
+            for (size_t i = 0; i < custom_grammar.production.size; ++i) {
+                key.fields.push_back(static_cast<uint8_t>(custom_grammar.production.symbols[i]));
+            }
+        }
+        
+        Fnv1a hasher;
+        for (uint32_t field : key.fields) {
+            hasher.add(field);
+        }
+        key.hash = hasher.value();
+        return key;
+    }
+    
+    bool operator==(const StructureKey& other) const noexcept {
+        return hash == other.hash && fields == other.fields;
+    }
+};
+
+// Thread-safe LRU cache of branch skeletons keyed by StructureKey
+//
+// A hit skips L-System expansion entirely; the generator still places the
+// skeleton on the canvas and grows leaves, so render-only parameter changes
+// (canvas size, season, palettes) reuse the cached branches. Entries are
+// evicted least recently used first once their estimated memory exceeds the
+// limit.
+class StructureCache {
+public:
+    using Skeleton = std::vector<Branch>;     // Branches with the trunk base at the origin
+    
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t entries = 0;
+        size_t memory_bytes = 0;
+    };
+    
+    explicit StructureCache(size_t memory_limit_bytes = size_t{16} << 20)
+        : memory_limit_(memory_limit_bytes) {}
+    
+    // Cached skeleton for key, or nullptr; counts a hit or a miss
+    std::shared_ptr<const Skeleton> find(const StructureKey& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto found = index_.find(key.hash);
+        if (found == index_.end() || !(found->second->key == key)) {
+            ++stats_.misses;
+            return nullptr;
+        }
+        
+        entries_.splice(entries_.begin(), entries_, found->second);
+        ++stats_.hits;
+        return found->second->skeleton;
+    }
+    
+    // Store a skeleton, replacing any entry with the same hash
+    void insert(const StructureKey& key, Skeleton skeleton) {
+        auto shared = std::make_shared<const Skeleton>(std::move(skeleton));
+        const size_t bytes = entry_bytes(key, *shared);
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (const auto found = index_.find(key.hash); found != index_.end()) {
+            erase(found->second);
+        }
+        if (bytes > memory_limit_) {
+            return;
+        }
+        
+        entries_.push_front(Entry{key, std::move(shared), bytes});
+        index_[key.hash] = entries_.begin();
+        stats_.memory_bytes += bytes;
+        ++stats_.entries;
+        evict_to(memory_limit_);
+    }
+    
+    void set_memory_limit(size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        memory_limit_ = bytes;
+        evict_to(memory_limit_);
+    }
+    
+    size_t memory_limit() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return memory_limit_;
+    }
+    
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+    
+    // Drop all entries; counters are kept
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        index_.clear();
+        stats_.entries = 0;
+        stats_.memory_bytes = 0;
+    }
+
+private:
+    struct Entry {
+        StructureKey key;
+        std::shared_ptr<const Skeleton> skeleton;
+        size_t bytes;
+    };
+    
+    static size_t entry_bytes(const StructureKey& key, const Skeleton& skeleton) noexcept {
+        return sizeof(Entry) + sizeof(Skeleton) + key.fields.capacity() * sizeof(uint32_t)
+             + skeleton.capacity() * sizeof(Branch);
+    }
+    
+    void erase(std::list<Entry>::iterator entry) {
+        stats_.memory_bytes -= entry->bytes;
+        --stats_.entries;
+        index_.erase(entry->key.hash);
+        entries_.erase(entry);
+    }
+    
+    void evict_to(size_t limit) {
+        while (stats_.memory_bytes > limit && !entries_.empty()) {
+            erase(std::prev(entries_.end()));
+            ++stats_.evictions;
+        }
+    }
+    
+    mutable std::mutex mutex_;
+    size_t memory_limit_;
+    std::list<Entry> entries_;                                     // Most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+    Stats stats_;
+};
+
+} // namespace pixeltree
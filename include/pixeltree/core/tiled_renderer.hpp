@@ -0,0 +1,285 @@
+#pragma once
+#include "tree_renderer.hpp"
+#include "parallel.hpp"
+#include <mutex>
+#include <vector>
+
+namespace pixeltree {
+
+// Branches and leaf clusters binned into a grid of canvas cells
+//
+// Each cell lists the primitives whose pixel bounds overlap it, in their
+// original (painter's) order, as compressed index ranges into one shared
+// array per primitive kind.
+class PrimitiveBins {
+    int cell_width_ = 0, cell_height_ = 0;
+    int columns_ = 0, rows_ = 0;
+    Rect2Di canvas_;
+    
+    std::vector<uint32_t> branch_offsets_, branch_indices_;
+    std::vector<uint32_t> cluster_offsets_, cluster_indices_;
+
+public:
+    // Bin the primitives of `tree` (a tree structure or a TreeView) into
+    // cells of the given size covering the canvas [0, width) x [0, height)
+    template<typename Tree>
+    void build(const Tree& tree, int canvas_width, int canvas_height, int cell_width, int cell_height) {
+        build(tree, Rect2Di{{0, 0}, {canvas_width, canvas_height}}, cell_width, cell_height);
+    }
+    
+    // Same for the cells of one canvas area, starting at its corner
+    template<typename Tree>
+    void build(const Tree& tree, const Rect2Di& area, int cell_width, int cell_height) {
+        cell_width_ = std::max(1, cell_width);
+        cell_height_ = std::max(1, cell_height);
+        canvas_ = area;
+        columns_ = (area.width() + cell_width_ - 1) / cell_width_;
+        rows_ = (area.height() + cell_height_ - 1) / cell_height_;
+        
+        bin(tree.branches, branch_offsets_, branch_indices_,
+            [](const Branch& branch) { return TreeRenderer::branch_bounds(branch); });
+        bin(tree.leaf_clusters, cluster_offsets_, cluster_indices_,
+            [](const auto& cluster) { return TreeRenderer::cluster_bounds(cluster); });
+    }
+    
+    int columns() const noexcept { return columns_; }
+    int rows() const noexcept { return rows_; }
+    size_t cell_count() const noexcept { return static_cast<size_t>(columns_) * static_cast<size_t>(rows_); }
+    
+    // Canvas rectangle of a cell (max exclusive, clipped to the canvas)
+    Rect2Di cell_rect(size_t cell) const noexcept {
+        const int column = static_cast<int>(cell % static_cast<size_t>(columns_));
+        const int row = static_cast<int>(cell / static_cast<size_t>(columns_));
+        return Rect2Di{{canvas_.min.x + column * cell_width_, canvas_.min.y + row * cell_height_},
+                       {std::min(canvas_.max.x, canvas_.min.x + (column + 1) * cell_width_),
+                        std::min(canvas_.max.y, canvas_.min.y + (row + 1) * cell_height_)}};
+    }
+    
+    const uint32_t* branches(size_t cell) const noexcept { return branch_indices_.data() + branch_offsets_[cell]; }
+    size_t branch_count(size_t cell) const noexcept { return branch_offsets_[cell + 1] - branch_offsets_[cell]; }
+    
+    const uint32_t* clusters(size_t cell) const noexcept { return cluster_indices_.data() + cluster_offsets_[cell]; }
+    size_t cluster_count(size_t cell) const noexcept { return cluster_offsets_[cell + 1] - cluster_offsets_[cell]; }
+    
+    bool cell_empty(size_t cell) const noexcept {
+        return branch_count(cell) == 0 && cluster_count(cell) == 0;
+    }
+
+private:
+    // Row-major index of a cell inside the grid
+    size_t cell_index(int column, int row) const noexcept {
+        return static_cast<size_t>(row) * static_cast<size_t>(columns_) + static_cast<size_t>(column);
+    }
+    
+    // Cells touched by `bounds`, as an inclusive column/row range
+    bool cell_range(const Rect2Di& bounds, int& col0, int& row0, int& col1, int& row1) const noexcept {
+        const int x0 = std::max(bounds.min.x, canvas_.min.x);
+        const int y0 = std::max(bounds.min.y, canvas_.min.y);
+        const int x1 = std::min(bounds.max.x, canvas_.max.x);
+        const int y1 = std::min(bounds.max.y, canvas_.max.y);
+        if (x0 >= x1 || y0 >= y1) {
+            return false;
+        }
+        col0 = (x0 - canvas_.min.x) / cell_width_;
+        row0 = (y0 - canvas_.min.y) / cell_height_;
+        col1 = (x1 - 1 - canvas_.min.x) / cell_width_;
+        row1 = (y1 - 1 - canvas_.min.y) / cell_height_;
+        return true;
+    }
+    
+    // Two passes: count per cell, then scatter indices in input order
+    template<typename Container, typename BoundsFn>
+    void bin(const Container& primitives, std::vector<uint32_t>& offsets,
+             std::vector<uint32_t>& indices, BoundsFn&& bounds_of) {
+        offsets.assign(cell_count() + 1, 0);
+        int col0 = 0, row0 = 0, col1 = 0, row1 = 0;
+        
+        for (const auto& primitive : primitives) {
+            if (!cell_range(bounds_of(primitive), col0, row0, col1, row1)) {
+                continue;
+            }
+            for (int row = row0; row <= row1; ++row) {
+                for (int column = col0; column <= col1; ++column) {
+                    ++offsets[cell_index(column, row) + 1];
+                }
+            }
+        }
+        
+        for (size_t cell = 0; cell < cell_count(); ++cell) {
+            offsets[cell + 1] += offsets[cell];
+        }
+        indices.resize(offsets.back());
+        
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        uint32_t index = 0;
+        for (const auto& primitive : primitives) {
+            if (cell_range(bounds_of(primitive), col0, row0, col1, row1)) {
+                for (int row = row0; row <= row1; ++row) {
+                    for (int column = col0; column <= col1; ++column) {
+                        indices[cursor[cell_index(column, row)]++] = index;
+                    }
+                }
+            }
+            ++index;
+        }
+    }
+};
+
+// Renders large canvases as independent tiles, never allocating the full canvas
+//
+// Primitives are binned into tile_size x tile_size tiles, tiles are rasterized
+// in parallel into per-worker buffers small enough to stay in cache, and each
+// finished tile is handed to the sink as soon as it is done. Tile pixels equal
+// the same region of BasicTreeRenderer<Geometry>::render.
+template<typename PixelType = uint32_t, typename Geometry = FloatGeometry>
+class TiledRenderer {
+    BasicTreeRenderer<Geometry> renderer_;
+    int tile_size_;
+    size_t thread_count_;
+
+public:
+    // Position of a finished tile on the canvas
+    struct Tile {
+        size_t index;                       // Row-major tile index
+        int column, row;
+        Rect2Di rect;                       // Canvas rectangle covered (max exclusive)
+        bool empty;                         // No primitive touches the tile
+    };
+    
+    explicit TiledRenderer(int tile_size = 256, size_t thread_count = 0)
+        : tile_size_(std::max(16, tile_size)), thread_count_(thread_count) {}
+    
+    int tile_size() const noexcept { return tile_size_; }
+    
+    // Render every tile of the tree's canvas and call sink(tile, pixels) for
+    // each, in completion order. Calls are serialized, so the sink needs no
+    // locking; `pixels` is only valid for the duration of the call.
+    template<size_t Capacity, typename Sink>
+    void render(const BasicTreeStructure<Capacity>& tree, Sink&& sink) const {
+        PrimitiveBins bins;
+        bins.build(tree, tree.parameters.canvas_width.get(), tree.parameters.canvas_height.get(),
+                   tile_size_, tile_size_);
+        
+        const size_t tile_count = bins.cell_count();
+        const size_t workers = resolve_thread_count(tile_count, thread_count_);
+        std::vector<PixelBuffer<PixelType>> tile_buffers(workers);
+        std::mutex sink_mutex;
+        
+        parallel_for(tile_count, workers, [&](size_t index, size_t worker) {
+            const Rect2Di rect = bins.cell_rect(index);
+            PixelBuffer<PixelType>& pixels = tile_buffers[worker];
+            pixels.reset(static_cast<size_t>(rect.width()), static_cast<size_t>(rect.height()));
+            pixels.clear(PixelTraits<PixelType>::from_rgba(0x00000000));
+            
+            renderer_.render_primitives(RasterTarget<PixelType>::from(pixels, rect.min), tree,
+                                        bins.branches(index), bins.branch_count(index),
+                                        bins.clusters(index), bins.cluster_count(index));
+            
+            const Tile tile{index, static_cast<int>(index) % bins.columns(),
+                            static_cast<int>(index) / bins.columns(), rect, bins.cell_empty(index)};
+            std::lock_guard<std::mutex> lock(sink_mutex);
+            sink(tile, static_cast<const PixelBuffer<PixelType>&>(pixels));
+        });
+    }
+};
+
+// Renders one tree with several threads by splitting the canvas into row bands
+//
+// Each band is a clipped window of the shared output buffer and draws only
+// the primitives binned to it, in their original order. Every pixel therefore
+// sees the same writes in the same order as the serial painter, so the output
+// is byte-identical to BasicTreeRenderer<Geometry>::render for any thread count.
+template<typename Geometry = FloatGeometry>
+class BasicBandRenderer {
+    BasicTreeRenderer<Geometry> renderer_;
+    size_t thread_count_;
+    int band_height_;
+
+public:
+    // thread_count 0 = one per core; band_height 0 = about four bands per thread
+    explicit BasicBandRenderer(size_t thread_count = 0, int band_height = 0)
+        : thread_count_(thread_count), band_height_(band_height) {}
+    
+    template<typename PixelType = uint32_t, size_t Capacity>
+    PixelBuffer<PixelType> render(const BasicTreeStructure<Capacity>& tree) const {
+        PixelBuffer<PixelType> buffer;
+        render_into(buffer, tree);
+        return buffer;
+    }
+    
+    // Same contract as TreeRenderer::render_into
+    template<typename PixelType, size_t Capacity>
+    void render_into(PixelBuffer<PixelType>& buffer, const BasicTreeStructure<Capacity>& tree,
+                     uint64_t* pixels_written = nullptr) const {
+        const int width = tree.parameters.canvas_width.get();
+        const int height = tree.parameters.canvas_height.get();
+        buffer.reset(static_cast<size_t>(width), static_cast<size_t>(height));
+        render_bands(RasterTarget<PixelType>::from(buffer), tree, pixels_written);
+    }
+    
+    template<typename PixelType>
+    void render_into(PixelBuffer<PixelType>& buffer, const TreeView& tree, uint64_t* pixels_written = nullptr) const {
+        const int width = tree.parameters->canvas_width.get();
+        const int height = tree.parameters->canvas_height.get();
+        buffer.reset(static_cast<size_t>(width), static_cast<size_t>(height));
+        render_bands(RasterTarget<PixelType>::from(buffer), tree, pixels_written);
+    }
+    
+    // Same contract as TreeRenderer::render_cropped_into
+    template<typename PixelType, size_t Capacity>
+    void render_cropped_into(CroppedSprite<PixelType>& sprite, const BasicTreeStructure<Capacity>& tree,
+                             uint64_t* pixels_written = nullptr) const {
+        const Rect2Di area = TreeRenderer::crop_rect(tree);
+        sprite.origin = area.min;
+        sprite.pixels.reset(static_cast<size_t>(area.width()), static_cast<size_t>(area.height()));
+        render_bands(RasterTarget<PixelType>::from(sprite.pixels, sprite.origin), tree, pixels_written);
+    }
+
+private:
+    // Clear and draw every row band of the surface's clip, which must span
+    // whole rows of its buffer
+    template<typename PixelType, typename Tree>
+    void render_bands(const RasterTarget<PixelType>& surface, const Tree& tree, uint64_t* pixels_written) const {
+        const Rect2Di area = surface.clip;
+        const size_t threads = thread_count_ == 0 ? default_thread_count() : thread_count_;
+        const int band_height = band_height_ > 0
+            ? band_height_
+            : std::max(16, static_cast<int>((static_cast<size_t>(area.height()) + threads * 4 - 1) / (threads * 4)));
+        
+        PrimitiveBins bins;
+        bins.build(tree, area, area.width(), band_height);
+        
+        const PixelType background = PixelTraits<PixelType>::from_rgba(0x00000000);
+        
+        // Bands count into their own slot so the counters are not shared
+        std::vector<uint64_t> band_written(instrumentation_enabled && pixels_written ? bins.cell_count() : 0);
+        
+        parallel_for(bins.cell_count(), threads, [&](size_t band, size_t) {
+            const Rect2Di rect = bins.cell_rect(band);
+            auto target = surface.clipped(rect);
+            target.pixels_written = band_written.empty() ? nullptr : &band_written[band];
+            
+            // Clear this band's rows (contiguous in the buffer) on the thread that draws them
+            const size_t band_pixels = static_cast<size_t>(area.width()) * static_cast<size_t>(rect.height());
+            if constexpr (std::is_same_v<PixelType, uint32_t>) {
+                simd::PixelOperations::clear_buffer(target.row(rect.min.y), band_pixels, background);
+            } else {
+                std::fill_n(target.row(rect.min.y), band_pixels, background);
+            }
+            
+            renderer_.render_primitives(target, tree,
+                                        bins.branches(band), bins.branch_count(band),
+                                        bins.clusters(band), bins.cluster_count(band));
+        });
+        
+        if (pixels_written) {
+            for (uint64_t written : band_written) {
+                *pixels_written += written;
+            }
+        }
+    }
+};
+
+using BandRenderer = BasicBandRenderer<FloatGeometry>;
+
+} // namespace pixeltree
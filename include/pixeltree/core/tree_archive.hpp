@@ -0,0 +1,390 @@
+#pragma once
+#include "tree_structure.hpp"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace pixeltree {
+
+// Binary tree archive ("PTSA")
+//
+// A forest of tree structures stored in the flat in-memory layout, so a
+// mapped file can be rendered without rebuilding any structure:
+//
+//   TreeArchiveHeader
+//   TreeArchiveRecord[tree_count]
+//   Branch[branch_count]                (16-byte aligned section)
+//   LeafClusterRecord[cluster_count]    (16-byte aligned section)
+//   Point2Df[leaf_count]                (16-byte aligned section)
+//
+// Records hold each tree's ranges in the shared sections; Branch links stay
+// relative to the tree's first branch. Records are raw struct copies in
+// native byte order; the header stores the record sizes and a byte order
+// mark, and readers reject archives written with a different layout.
+// Bump version whenever Branch, TreeParameters or the records change.
+
+// Leaf cluster with its leaf positions moved to the shared leaf section
+struct LeafClusterRecord {
+    Point2Df position;
+    float size;
+    Color color;
+    uint32_t shape;             // LeafCluster::Shape
+    uint32_t first_leaf;        // Into the tree's leaf positions
+    uint32_t leaf_count;
+    
+    LeafCluster::Shape cluster_shape() const noexcept { return static_cast<LeafCluster::Shape>(shape); }
+    float reach() const noexcept { return LeafCluster::reach(cluster_shape(), size); }
+};
+
+struct TreeArchiveRecord {
+    TreeParameters parameters;
+    Rect2Df bounding_box;
+    uint32_t generation_id;
+    uint32_t first_branch, branch_count;
+    uint32_t first_cluster, cluster_count;
+    uint32_t first_leaf, leaf_count;
+};
+
+struct TreeArchiveHeader {
+    static constexpr char magic_bytes[4] = {'P', 'T', 'S', 'A'};
+    static constexpr uint32_t current_version = 2;
+    static constexpr uint32_t byte_order_mark = 0x01020304;
+    static constexpr uint64_t section_alignment = 16;
+    
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t tree_count;
+    uint32_t record_size;       // sizeof(TreeArchiveRecord) of the writer
+    uint32_t branch_size;       // sizeof(Branch)
+    uint32_t cluster_size;      // sizeof(LeafClusterRecord)
+    uint32_t leaf_size;         // sizeof(Point2Df)
+    uint64_t branch_offset, cluster_offset, leaf_offset;   // Section byte offsets
+    uint64_t branch_count, cluster_count, leaf_count;      // Section lengths
+};
+
+static_assert(std::is_trivially_copyable_v<Branch> && std::is_trivially_copyable_v<TreeParameters>,
+              "Archived types are stored as raw bytes");
+static_assert(sizeof(TreeArchiveHeader) % TreeArchiveHeader::section_alignment == 0);
+
+// Read-only tree in archive memory
+//
+// Renders like the TreeStructure it was written from (TreeRenderer and
+// TreeGenerator::render_structure accept it directly). Valid as long as the
+// archive memory it points into.
+struct TreeView {
+    const TreeParameters* parameters = nullptr;
+    Rect2Df bounding_box;
+    uint32_t generation_id = 0;
+    std::span<const Branch> branches;
+    std::span<const LeafClusterRecord> leaf_clusters;
+    std::span<const Point2Df> leaf_positions;       // Leaves of all clusters
+    
+    std::span<const Point2Df> leaves_of(const LeafClusterRecord& cluster) const noexcept {
+        return leaf_positions.subspan(cluster.first_leaf, cluster.leaf_count);
+    }
+    
+    size_t branch_count() const noexcept { return branches.size(); }
+    size_t leaf_cluster_count() const noexcept { return leaf_clusters.size(); }
+    
+    // Owning copy, e.g. to edit a loaded tree
+    TreeStructure to_structure() const {
+        TreeStructure tree(*parameters);
+        tree.branches.assign(branches.begin(), branches.end());
+        tree.leaf_clusters.reserve(leaf_clusters.size());
+        for (const LeafClusterRecord& record : leaf_clusters) {
+            LeafCluster& cluster = tree.leaf_clusters.emplace_back(record.position, record.size, record.color);
+            cluster.shape = record.cluster_shape();
+            const auto leaves = leaves_of(record);
+            cluster.leaf_positions.assign(leaves.begin(), leaves.end());
+        }
+        tree.bounding_box = bounding_box;
+        tree.generation_id = generation_id;
+        return tree;
+    }
+};
+
+// Collects trees and produces the archive bytes
+class TreeArchiveWriter {
+    std::vector<TreeArchiveRecord> records_;
+    std::vector<Branch> branches_;
+    std::vector<LeafClusterRecord> clusters_;
+    std::vector<Point2Df> leaves_;
+
+public:
+    template<size_t Capacity>
+    void add(const BasicTreeStructure<Capacity>& tree) {
+        // Zeroed first: the record's padding bytes are written to the archive too
+        TreeArchiveRecord record;
+        std::memset(static_cast<void*>(&record), 0, sizeof(record));
+        record.parameters = tree.parameters;
+        record.bounding_box = tree.bounding_box;
+        record.generation_id = tree.generation_id;
+        record.first_branch = static_cast<uint32_t>(branches_.size());
+        record.branch_count = static_cast<uint32_t>(tree.branches.size());
+        record.first_cluster = static_cast<uint32_t>(clusters_.size());
+        record.cluster_count = static_cast<uint32_t>(tree.leaf_clusters.size());
+        record.first_leaf = static_cast<uint32_t>(leaves_.size());
+        
+        branches_.insert(branches_.end(), tree.branches.begin(), tree.branches.end());
+        for (const LeafCluster& cluster : tree.leaf_clusters) {
+            clusters_.push_back(LeafClusterRecord{
+                cluster.position, cluster.size, cluster.color, static_cast<uint32_t>(cluster.shape),
+                static_cast<uint32_t>(leaves_.size() - record.first_leaf),
+                static_cast<uint32_t>(cluster.leaf_positions.size())});
+            leaves_.insert(leaves_.end(), cluster.leaf_positions.begin(), cluster.leaf_positions.end());
+        }
+        record.leaf_count = static_cast<uint32_t>(leaves_.size() - record.first_leaf);
+        records_.push_back(record);
+    }
+    
+    size_t size() const noexcept { return records_.size(); }
+    
+    void clear() noexcept {
+        records_.clear();
+        branches_.clear();
+        clusters_.clear();
+        leaves_.clear();
+    }
+    
+    std::vector<uint8_t> bytes() const {
+        TreeArchiveHeader header{};
+        std::memcpy(header.magic, TreeArchiveHeader::magic_bytes, sizeof(header.magic));
+        header.version = TreeArchiveHeader::current_version;
+        header.byte_order = TreeArchiveHeader::byte_order_mark;
+        header.tree_count = static_cast<uint32_t>(records_.size());
+        header.record_size = sizeof(TreeArchiveRecord);
+        header.branch_size = sizeof(Branch);
+        header.cluster_size = sizeof(LeafClusterRecord);
+        header.leaf_size = sizeof(Point2Df);
+        header.branch_count = branches_.size();
+        header.cluster_count = clusters_.size();
+        header.leaf_count = leaves_.size();
+        header.branch_offset = align(sizeof(header) + records_.size() * sizeof(TreeArchiveRecord));
+        header.cluster_offset = align(header.branch_offset + branches_.size() * sizeof(Branch));
+        header.leaf_offset = align(header.cluster_offset + clusters_.size() * sizeof(LeafClusterRecord));
+        
+        std::vector<uint8_t> out(header.leaf_offset + leaves_.size() * sizeof(Point2Df));
+        std::memcpy(out.data(), &header, sizeof(header));
+        copy_section(out, sizeof(header), records_);
+        copy_section(out, header.branch_offset, branches_);
+        copy_section(out, header.cluster_offset, clusters_);
+        copy_section(out, header.leaf_offset, leaves_);
+        return out;
+    }
+    
+    void save(const std::string& path) const {
+        const std::vector<uint8_t> data = bytes();
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            throw std::runtime_error("Cannot write tree archive " + path);
+        }
+    }
+
+private:
+    static uint64_t align(uint64_t offset) noexcept {
+        const uint64_t mask = TreeArchiveHeader::section_alignment - 1;
+        return (offset + mask) & ~mask;
+    }
+    
+    template<typename T>
+    static void copy_section(std::vector<uint8_t>& out, uint64_t offset, const std::vector<T>& items) {
+        if (!items.empty()) {
+            std::memcpy(out.data() + offset, items.data(), items.size() * sizeof(T));
+        }
+    }
+};
+
+// Zero-copy reader over archive bytes held by the caller
+//
+// The constructor checks the header, every record and cluster range, every
+// branch link (parents precede their children, as renderers, LodBuilder and
+// WindAnimator rely on), leaf shapes and the stored parameter bounds, and
+// throws std::runtime_error on anything malformed; the data pointer must be
+// aligned like TreeArchiveHeader (heap and mapped memory are).
+class TreeArchiveView {
+    const uint8_t* data_ = nullptr;
+    const TreeArchiveHeader* header_ = nullptr;
+    const TreeArchiveRecord* records_ = nullptr;
+
+public:
+    TreeArchiveView() = default;
+    
+    TreeArchiveView(const void* data, size_t size) : data_(static_cast<const uint8_t*>(data)) {
+        if (reinterpret_cast<uintptr_t>(data) % alignof(TreeArchiveHeader) != 0) {
+            throw std::invalid_argument("Misaligned tree archive memory");
+        }
+        if (size < sizeof(TreeArchiveHeader)) {
+            throw std::runtime_error("Not a tree archive");
+        }
+        header_ = reinterpret_cast<const TreeArchiveHeader*>(data_);
+        const TreeArchiveHeader& header = *header_;
+        if (std::memcmp(header.magic, TreeArchiveHeader::magic_bytes, sizeof(header.magic)) != 0) {
+            throw std::runtime_error("Not a tree archive");
+        }
+        if (header.version != TreeArchiveHeader::current_version ||
+            header.byte_order != TreeArchiveHeader::byte_order_mark ||
+            header.record_size != sizeof(TreeArchiveRecord) || header.branch_size != sizeof(Branch) ||
+            header.cluster_size != sizeof(LeafClusterRecord) || header.leaf_size != sizeof(Point2Df)) {
+            throw std::runtime_error("Tree archive written by an incompatible version or platform");
+        }
+        
+        const uint64_t records_end = sizeof(TreeArchiveHeader) + uint64_t{header.tree_count} * sizeof(TreeArchiveRecord);
+        if (records_end > size ||
+            !section_fits(header.branch_offset, header.branch_count, sizeof(Branch), size) ||
+            !section_fits(header.cluster_offset, header.cluster_count, sizeof(LeafClusterRecord), size) ||
+            !section_fits(header.leaf_offset, header.leaf_count, sizeof(Point2Df), size)) {
+            throw std::runtime_error("Truncated tree archive");
+        }
+        records_ = reinterpret_cast<const TreeArchiveRecord*>(data_ + sizeof(TreeArchiveHeader));
+        
+        const auto* branches = reinterpret_cast<const Branch*>(data_ + header.branch_offset);
+        const auto* clusters = reinterpret_cast<const LeafClusterRecord*>(data_ + header.cluster_offset);
+        for (uint32_t index = 0; index < header.tree_count; ++index) {
+            const TreeArchiveRecord& record = records_[index];
+            if (!range_fits(record.first_branch, record.branch_count, header.branch_count) ||
+                !range_fits(record.first_cluster, record.cluster_count, header.cluster_count) ||
+                !range_fits(record.first_leaf, record.leaf_count, header.leaf_count) ||
+                !record.parameters.in_bounds()) {
+                throw std::runtime_error("Corrupt tree archive record");
+            }
+            for (uint32_t b = 0; b < record.branch_count; ++b) {
+                const Branch& branch = branches[record.first_branch + b];
+                if ((branch.parent != Branch::npos && branch.parent >= b) ||
+                    !link_fits(branch.first_child, record.branch_count) ||
+                    !link_fits(branch.next_sibling, record.branch_count)) {
+                    throw std::runtime_error("Corrupt tree archive branch");
+                }
+            }
+            for (uint32_t c = 0; c < record.cluster_count; ++c) {
+                const LeafClusterRecord& cluster = clusters[record.first_cluster + c];
+                if (!range_fits(cluster.first_leaf, cluster.leaf_count, record.leaf_count) ||
+                    cluster.leaf_count > LeafCluster::max_leaves ||
+                    cluster.shape > static_cast<uint32_t>(LeafCluster::Shape::Scattered)) {
+                    throw std::runtime_error("Corrupt tree archive leaf cluster");
+                }
+            }
+        }
+    }
+    
+    size_t size() const noexcept { return header_ ? header_->tree_count : 0; }
+    bool empty() const noexcept { return size() == 0; }
+    
+    TreeView operator[](size_t index) const noexcept {
+        const TreeArchiveRecord& record = records_[index];
+        TreeView view;
+        view.parameters = &record.parameters;
+        view.bounding_box = record.bounding_box;
+        view.generation_id = record.generation_id;
+        view.branches = {reinterpret_cast<const Branch*>(data_ + header_->branch_offset) + record.first_branch,
+                         record.branch_count};
+        view.leaf_clusters = {reinterpret_cast<const LeafClusterRecord*>(data_ + header_->cluster_offset)
+                              + record.first_cluster, record.cluster_count};
+        view.leaf_positions = {reinterpret_cast<const Point2Df*>(data_ + header_->leaf_offset) + record.first_leaf,
+                               record.leaf_count};
+        return view;
+    }
+
+private:
+    static bool section_fits(uint64_t offset, uint64_t count, uint64_t item_size, size_t size) noexcept {
+        return offset % TreeArchiveHeader::section_alignment == 0 && offset <= size &&
+               (item_size == 0 || count <= (size - offset) / item_size);
+    }
+    
+    static bool range_fits(uint64_t first, uint64_t count, uint64_t total) noexcept {
+        return first <= total && count <= total - first;
+    }
+    
+    static bool link_fits(uint32_t link, uint32_t branch_count) noexcept {
+        return link == Branch::npos || link < branch_count;
+    }
+};
+
+// Tree archive file mapped into memory
+//
+// Pages are loaded by the OS on first touch, so opening a large forest
+// costs little more than its header and records. Platforms without mmap
+// read the whole file instead.
+class MappedTreeArchive {
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<uint8_t> fallback_;
+    TreeArchiveView view_;
+
+public:
+    explicit MappedTreeArchive(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open tree archive " + path);
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(TreeArchiveHeader))) {
+            ::close(fd);
+            throw std::runtime_error("Not a tree archive: " + path);
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("Cannot map tree archive " + path);
+        }
+        data_ = static_cast<const uint8_t*>(mapping);
+        mapped_ = true;
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            throw std::runtime_error("Cannot open tree archive " + path);
+        }
+        fallback_.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(fallback_.data()), static_cast<std::streamsize>(fallback_.size()));
+        data_ = fallback_.data();
+        size_ = fallback_.size();
+#endif
+        try {
+            view_ = TreeArchiveView(data_, size_);
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+    
+    ~MappedTreeArchive() { unmap(); }
+    
+    MappedTreeArchive(const MappedTreeArchive&) = delete;
+    MappedTreeArchive& operator=(const MappedTreeArchive&) = delete;
+    
+    const TreeArchiveView& view() const noexcept { return view_; }
+    size_t size() const noexcept { return view_.size(); }
+    TreeView operator[](size_t index) const noexcept { return view_[index]; }
+    
+    // Bytes of the file
+    size_t file_size() const noexcept { return size_; }
+
+private:
+    void unmap() noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+        if (mapped_) {
+            ::munmap(const_cast<uint8_t*>(data_), size_);
+            mapped_ = false;
+        }
+#endif
+    }
+};
+
+} // namespace pixeltree
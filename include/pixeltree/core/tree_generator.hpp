@@ -3,8 +3,17 @@
 #include "tree_structure.hpp"
 #include "pixel_buffer.hpp"
 #include "tree_renderer.hpp"
+#include "tiled_renderer.hpp"
+#include "atlas.hpp"
+#include "lod.hpp"
+#include "wind.hpp"
 #include "lsystem.hpp"
+#include "structure_cache.hpp"
+#include "seed_search.hpp"
+#include "instrumentation.hpp"
 #include "random.hpp"
+#include "parallel.hpp"
+#include <chrono>
 #include <memory>
 #include <future>
 
@@ -19,164 +28,904 @@ struct TreeMetadata {
     float generation_time_ms;
     Rect2Df bounding_box;
     uint32_t random_seed;
+    GenerationStats stats;      // Per-stage breakdown; zero unless instrumented
 };
 
+// Outcome of TreeGenerator::search_seeds
+template<typename PixelType = uint32_t>
+struct SeedSearchResult {
+    std::vector<std::pair<PixelBuffer<PixelType>, TreeMetadata>> trees;    // Accepted, in seed order
+    size_t examined = 0;                // Seeds whose skeleton was built
+    size_t rejected_skeleton = 0;       // Rejected on branch metrics, before leaves grew
+    size_t rejected_structure = 0;      // Rejected on the finished structure
+    size_t accepted = 0;                // Matches found, including any beyond max_results
+};
+
+// Pipeline stages redone by an incremental update (bit flags)
+enum class DirtyFlags : uint32_t {
+    None         = 0,
+    Skeleton     = 1u << 0,     // L-System expansion
+    Placement    = 1u << 1,     // Skeleton moved to a different canvas
+    Leaves       = 1u << 2,     // Leaf clusters regrown
+    LeafColors   = 1u << 3,     // Leaf clusters recolored in place
+    BranchColors = 1u << 4,     // Branches recolored in place
+    Raster       = 1u << 5,     // Pixels re-rendered
+    All          = (1u << 6) - 1
+};
+
+constexpr DirtyFlags operator|(DirtyFlags a, DirtyFlags b) noexcept {
+    return static_cast<DirtyFlags>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+constexpr DirtyFlags operator&(DirtyFlags a, DirtyFlags b) noexcept {
+    return static_cast<DirtyFlags>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b));
+}
+
+// Whether any of `stages` is set in flags
+constexpr bool has(DirtyFlags flags, DirtyFlags stages) noexcept {
+    return (flags & stages) != DirtyFlags::None;
+}
+
 // Main tree generator class
-template<typename PixelType = uint32_t, size_t MaxBranches = 64>
+//
+// MaxBranches caps the number of segments per tree on top of
+// BranchParameters::max_branches. Small caps keep the per-tree branch and
+// leaf storage inline in the generator, so building a tree's geometry does
+// not allocate.
+//
+// Geometry selects the arithmetic of the whole pipeline. FixedGeometry grows
+// the skeleton, places and colors the leaves and rasterizes the Pixel style
+// with integers only, so its output is bit-identical across compilers, flags
+// and CPUs and can key a shared cache; its trees differ slightly from the
+// FloatGeometry ones for the same seed. Smooth rendering, wind poses and LOD
+// merging remain float.
+//
+// A generator owns mutable RNG and rule state, so one instance must not be used
+// from several threads at once. generate_batch and generate_async run on private
+// per-worker copies instead.
+template<typename PixelType = uint32_t, size_t MaxBranches = 64, typename Geometry = FloatGeometry>
 class TreeGenerator {
     mutable Random rng_;
+    mutable Random seed_rng_;   // Source of seeds for params with random_seed == 0
     LSystemGenerator lsystem_;
-    TreeRenderer renderer_;
+    BasicTreeRenderer<Geometry> renderer_;
+    size_t render_threads_ = 1;     // Row-band threads per render (see BandRenderer)
+    std::shared_ptr<StructureCache> structure_cache_;   // Optional, may be shared
+    std::shared_ptr<StatsSink> stats_sink_;             // Optional, shared by copies
+    mutable GenerationStats stats_;                     // Stats of the current call
     
 public:
     static constexpr size_t max_branches = MaxBranches;
     
+    // Branch budgets up to this size keep the generate() arena inline
+    static constexpr size_t fixed_storage_limit = 256;
+    static constexpr bool uses_fixed_storage = MaxBranches <= fixed_storage_limit;
+    using ScratchStructure = BasicTreeStructure<uses_fixed_storage ? MaxBranches : 0>;
+    
+private:
+    ScratchStructure scratch_{TreeParameters{}};  // Branch/leaf arena reused by generate()
+    LSystemGenerator::ExpansionPlan plan_;        // Expansion decisions reused across trees
+    
+    // Palette pick and raw [0, 1) variation draws behind one cluster's color,
+    // kept by edit sessions so palette edits can recolor without regrowing
+    struct LeafColorDraw {
+        int palette_index;
+        std::array<float, 3> variation;
+    };
+    
+public:
     // Constructor
     explicit TreeGenerator(uint32_t seed = 0) 
-        : rng_(seed == 0 ? std::random_device{}() : seed) {
+        : rng_(seed == 0 ? std::random_device{}() : seed)
+        , seed_rng_(rng_.next_uint()) {
+    }
+    
+    // Share a skeleton cache: trees whose StructureKey was seen before skip
+    // L-System expansion. Output is identical with or without a cache.
+    // nullptr disables caching.
+    void set_structure_cache(std::shared_ptr<StructureCache> cache) noexcept {
+        structure_cache_ = std::move(cache);
+    }
+    
+    const std::shared_ptr<StructureCache>& structure_cache() const noexcept { return structure_cache_; }
+    
+    // Grammar for parameters with TreeType::Custom
+    void set_custom_grammar(const CustomGrammar& grammar) {
+        lsystem_.set_custom_grammar(grammar);
     }
     
+    // Threads used to rasterize each single tree (0 = one per core), for full,
+    // cropped and archived renders. Output is identical for every setting;
+    // worth it for large canvases only.
+    void set_render_threads(size_t thread_count) noexcept { render_threads_ = thread_count; }
+    size_t render_threads() const noexcept { return render_threads_; }
+    
+    // Receive the GenerationStats of every generate, generate_structure,
+    // render_structure and edit-session update of this generator and of the
+    // copies generate_batch and generate_async make. Only instrumented builds
+    // (PIXELTREE_ENABLE_INSTRUMENTATION) record anything. nullptr detaches.
+    void set_stats_sink(std::shared_ptr<StatsSink> sink) noexcept { stats_sink_ = std::move(sink); }
+    const std::shared_ptr<StatsSink>& stats_sink() const noexcept { return stats_sink_; }
+    
+    // Stats of the most recent call, also for the calls without metadata
+    const GenerationStats& last_stats() const noexcept { return stats_; }
+    
     // Generate tree and return both structure and rendered buffer
     auto generate(const TreeParameters& params) 
         -> std::pair<PixelBuffer<PixelType>, TreeMetadata> {
-        
+        PixelBuffer<PixelType> pixel_buffer;
+        TreeMetadata metadata = generate_into(params, pixel_buffer);
+        return {std::move(pixel_buffer), metadata};
+    }
+    
+    // Generate a tree into caller-owned storage (e.g. from a PixelBufferPool);
+    // the buffer is resized to the canvas, reusing its allocation when possible
+    TreeMetadata generate_into(const TreeParameters& params, PixelBuffer<PixelType>& pixel_buffer) {
         const auto start_time = std::chrono::high_resolution_clock::now();
+        begin_stats();
+        const uint32_t actual_seed = build_scratch_structure(params);
         
-        // Setup random seed
-        const uint32_t actual_seed = params.random_seed == 0 ? 
-            std::random_device{}() : params.random_seed;
-        rng_ = Random(actual_seed);
+        // Render to pixel buffer, directly in the output pixel format
+        render_tree_into(pixel_buffer, scratch_);
         
-        // Validate and normalize parameters
-        TreeParameters normalized_params = params;
-        normalized_params.validate();
+        return make_metadata(scratch_, actual_seed, start_time);
+    }
+    
+    // Generate a tree rendered only within its bounding box
+    //
+    // The sprite's origin gives its position on the canvas described by params,
+    // so blitting it there reproduces generate() without the empty space.
+    auto generate_cropped(const TreeParameters& params)
+        -> std::pair<CroppedSprite<PixelType>, TreeMetadata> {
+        CroppedSprite<PixelType> sprite;
+        TreeMetadata metadata = generate_cropped_into(params, sprite);
+        return {std::move(sprite), metadata};
+    }
+    
+    TreeMetadata generate_cropped_into(const TreeParameters& params, CroppedSprite<PixelType>& sprite) {
+        const auto start_time = std::chrono::high_resolution_clock::now();
+        begin_stats();
+        const uint32_t actual_seed = build_scratch_structure(params);
         
-        // Setup L-System rules for tree type
-        lsystem_.setup_rules(normalized_params.type);
+        {
+            StageTimer timer(stats_, GenerationStage::Raster);
+            GrowthProbe probe(stats_, sprite.pixels);
+            if (render_threads_ == 1) {
+                renderer_.render_cropped_into(sprite, scratch_, pixel_counter());
+            } else {
+                BasicBandRenderer<Geometry>(render_threads_).render_cropped_into(sprite, scratch_, pixel_counter());
+            }
+            count_covered(sprite.pixels);
+        }
         
-        // Generate L-System string
-        const std::string lstring = lsystem_.generate_string(normalized_params, rng_);
+        return make_metadata(scratch_, actual_seed, start_time);
+    }
+    
+    // Generate a tree once and render it as a LOD chain (see LodBuilder)
+    //
+    // Element 0 is the full-size render, identical to generate(); each further
+    // level halves the canvas and is drawn from a pruned, cluster-merged copy
+    // of the same structure, so the L-System runs only once. The chain ends
+    // early where a level would drop below the 16-pixel minimum canvas. Each
+    // level's metadata describes its simplified tree; generation time and
+    // stats cover the whole chain.
+    auto generate_lods(const TreeParameters& params, const LodOptions& options = {})
+        -> std::vector<std::pair<PixelBuffer<PixelType>, TreeMetadata>> {
+        const auto start_time = std::chrono::high_resolution_clock::now();
+        begin_stats();
+        const uint32_t actual_seed = build_scratch_structure(params);
         
-        // Convert to tree structure
-        auto tree_structure = lsystem_.string_to_tree(lstring, normalized_params, rng_);
+        std::vector<std::pair<PixelBuffer<PixelType>, TreeMetadata>> chain;
+        chain.reserve(std::max<size_t>(options.levels, 1));
+        chain.emplace_back();
+        render_tree_into(chain.front().first, scratch_);
+        chain.front().second = describe(scratch_, actual_seed);
         
-        // Generate leaf clusters
-        generate_leaf_clusters(*tree_structure, rng_);
+        TreeStructure lod{TreeParameters{}};
+        for (size_t level = 1; level < options.levels && LodBuilder::level_canvas(scratch_.parameters, level); ++level) {
+            LodBuilder::simplify(scratch_, level, options, lod);
+            chain.emplace_back();
+            render_tree_into(chain.back().first, lod);
+            chain.back().second = describe(lod, actual_seed);
+        }
         
-        // Calculate bounding box
-        tree_structure->calculate_bounding_box();
+        const TreeMetadata totals = make_metadata(scratch_, actual_seed, start_time);
+        for (auto& [pixels, metadata] : chain) {
+            metadata.generation_time_ms = totals.generation_time_ms;
+            metadata.stats = totals.stats;
+        }
+        return chain;
+    }
+    
+    // Generate a tree once and render a looping wind animation of it (see
+    // WindAnimator), driven by params.wind_strength and wind_direction
+    auto generate_wind_frames(const TreeParameters& params, const WindOptions& options = {})
+        -> std::pair<FrameStrip<PixelType>, TreeMetadata> {
+        const auto start_time = std::chrono::high_resolution_clock::now();
+        begin_stats();
+        const uint32_t actual_seed = build_scratch_structure(params);
         
-        // Render to pixel buffer
-        PixelBuffer<PixelType> pixel_buffer;
-        if constexpr (std::is_same_v<PixelType, uint32_t>) {
-            pixel_buffer = std::move(renderer_.render(*tree_structure));
-        } else {
-            // Convert from uint32_t to other pixel types
-            auto rgba_buffer = renderer_.render(*tree_structure);
-            pixel_buffer = convert_pixel_buffer<PixelType>(rgba_buffer);
+        FrameStrip<PixelType> strip;
+        {
+            StageTimer timer(stats_, GenerationStage::Raster);
+            GrowthProbe probe(stats_, strip.pixels);
+            WindAnimator<PixelType, Geometry>(options).animate_into(scratch_, strip);
         }
         
-        // Calculate generation time
-        const auto end_time = std::chrono::high_resolution_clock::now();
-        const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
-            end_time - start_time);
-        const float generation_time = duration.count() / 1000.0f; // Convert to milliseconds
+        return {std::move(strip), make_metadata(scratch_, actual_seed, start_time)};
+    }
+    
+    // Generate a tree and render it tile by tile, for canvases too large to
+    // hold in memory; see TiledRenderer::render for the sink contract
+    template<typename Sink>
+    TreeMetadata generate_tiled(const TreeParameters& params, const TiledRenderer<PixelType, Geometry>& tiles, Sink&& sink) {
+        const auto start_time = std::chrono::high_resolution_clock::now();
+        begin_stats();
+        const uint32_t actual_seed = build_scratch_structure(params);
         
-        // Create metadata
-        TreeMetadata metadata{
-            .generation_id = tree_structure->generation_id,
-            .branch_count = tree_structure->branch_count(),
-            .leaf_count = tree_structure->leaf_cluster_count(),
-            .max_depth = tree_structure->max_depth(),
-            .generation_time_ms = generation_time,
-            .bounding_box = tree_structure->bounding_box,
-            .random_seed = actual_seed
-        };
+        {
+            // Tiles are handed to the sink as they finish; their pixels are not counted
+            StageTimer timer(stats_, GenerationStage::Raster);
+            tiles.render(scratch_, std::forward<Sink>(sink));
+        }
         
-        return {std::move(pixel_buffer), metadata};
+        return make_metadata(scratch_, actual_seed, start_time);
     }
     
     // Generate only tree structure (without rendering)
     std::unique_ptr<TreeStructure> generate_structure(const TreeParameters& params) {
-        // Setup random seed
-        const uint32_t actual_seed = params.random_seed == 0 ? 
-            std::random_device{}() : params.random_seed;
-        rng_ = Random(actual_seed);
-        
         TreeParameters normalized_params = params;
         normalized_params.validate();
         
-        lsystem_.setup_rules(normalized_params.type);
-        const std::string lstring = lsystem_.generate_string(normalized_params, rng_);
-        auto tree_structure = lsystem_.string_to_tree(lstring, normalized_params, rng_);
-        
-        generate_leaf_clusters(*tree_structure, rng_);
-        tree_structure->calculate_bounding_box();
-        
+        auto tree_structure = std::make_unique<TreeStructure>(normalized_params);
+        begin_stats();
+        build_structure(normalized_params, resolve_seed(params), *tree_structure);
+        finish_stats();
         return tree_structure;
     }
     
+    // Replace a structure's leaf clusters with the ones generate() grows for
+    // seed (see TreeMetadata::random_seed), keeping its branches
+    template<size_t Capacity>
+    void grow_leaves(BasicTreeStructure<Capacity>& tree, uint32_t seed) const {
+        tree.leaf_clusters.clear();
+        Random leaf_rng(seed, leaf_stream);
+        generate_leaf_clusters(tree, leaf_rng);
+    }
+    
     // Render existing tree structure
     PixelBuffer<PixelType> render_structure(const TreeStructure& tree) const {
-        if constexpr (std::is_same_v<PixelType, uint32_t>) {
-            return renderer_.render(tree);
-        } else {
-            auto rgba_buffer = renderer_.render(tree);
-            return convert_pixel_buffer<PixelType>(rgba_buffer);
-        }
+        PixelBuffer<PixelType> buffer;
+        render_structure_into(tree, buffer);
+        return buffer;
+    }
+    
+    void render_structure_into(const TreeStructure& tree, PixelBuffer<PixelType>& buffer) const {
+        begin_stats();
+        render_tree_into(buffer, tree);
+        finish_stats();
+    }
+    
+    // Render a tree loaded from an archive without copying it (see
+    // MappedTreeArchive)
+    PixelBuffer<PixelType> render_structure(const TreeView& tree) const {
+        PixelBuffer<PixelType> buffer;
+        render_structure_into(tree, buffer);
+        return buffer;
+    }
+    
+    void render_structure_into(const TreeView& tree, PixelBuffer<PixelType>& buffer) const {
+        begin_stats();
+        render_tree_into(buffer, tree);
+        finish_stats();
     }
     
     // Batch generation for multiple trees
+    //
+    // Trees are generated in parallel on `thread_count` workers (0 = one per core),
+    // each with its own copy of this generator. Seeds for parameters with
+    // random_seed == 0 are drawn up front in input order, so the output depends
+    // only on the inputs and this generator's seed, never on the worker count.
     std::vector<std::pair<PixelBuffer<PixelType>, TreeMetadata>> 
-    generate_batch(const std::vector<TreeParameters>& params_list) {
-        std::vector<std::pair<PixelBuffer<PixelType>, TreeMetadata>> results;
-        results.reserve(params_list.size());
+    generate_batch(const std::vector<TreeParameters>& params_list, size_t thread_count = 0) {
+        std::vector<std::pair<PixelBuffer<PixelType>, TreeMetadata>> results(params_list.size());
+        const std::vector<uint32_t> seeds = resolve_seeds(params_list);
+        std::vector<TreeGenerator> contexts = worker_contexts(params_list.size(), thread_count);
         
-        for (const auto& params : params_list) {
-            results.emplace_back(generate(params));
-        }
+        parallel_for(params_list.size(), contexts.size(), [&](size_t index, size_t worker) {
+            TreeParameters params = params_list[index];
+            params.random_seed = seeds[index];
+            results[index] = contexts[worker].generate(params);
+        });
         
         return results;
     }
     
-    // Async generation
+    // Seed search
+    //
+    // Screens params with the seeds first_seed, first_seed + 1, ... (count of
+    // them, wrapping, seed 0 skipped) against `constraints` on thread_count
+    // workers (0 = one per core). Each candidate is dropped at the first stage
+    // that can rule it out: branch count and depth right after the L-System
+    // expansion, the remaining metrics once its leaves have grown. Nothing is
+    // rasterized while screening; only the accepted structures are rendered,
+    // as they were screened, with the pixels generate() gives them. Screening
+    // bypasses the StructureCache, so a search does not evict the skeletons
+    // of the trees being worked on. Seeds are screened in blocks of search_block
+    // and the search stops after the block that completes max_results
+    // matches, so the result holds the lowest matching seeds for any worker
+    // count.
+    SeedSearchResult<PixelType> search_seeds(const TreeParameters& params, uint32_t first_seed, size_t count,
+                                             const SearchConstraints& constraints,
+                                             size_t max_results = std::numeric_limits<size_t>::max(),
+                                             size_t thread_count = 0) {
+        TreeParameters normalized_params = params;
+        normalized_params.validate();
+        
+        using Clock = std::chrono::high_resolution_clock;
+        SeedSearchResult<PixelType> result;
+        std::vector<TreeGenerator> contexts = worker_contexts(std::min(count, search_block), thread_count);
+        std::vector<SeedVerdict> verdicts(search_block);
+        std::vector<ScratchStructure> screened(std::min(count, search_block), ScratchStructure(TreeParameters{}));
+        std::vector<GenerationStats> screen_stats(screened.size());
+        std::vector<Clock::duration> screen_times(screened.size());
+        
+        // Accepted structures are kept and rendered as they are, never rebuilt
+        std::vector<ScratchStructure> winners;
+        std::vector<uint32_t> winner_seeds;
+        std::vector<GenerationStats> winner_stats;
+        std::vector<Clock::duration> winner_times;
+        
+        for (size_t begin = 0; begin < count && winners.size() < max_results; begin += search_block) {
+            const size_t block = std::min(search_block, count - begin);
+            parallel_for(block, contexts.size(), [&](size_t index, size_t worker) {
+                const auto seed = static_cast<uint32_t>(first_seed + begin + index);
+                if (seed == 0) {
+                    verdicts[index] = SeedVerdict::Skipped;
+                    return;
+                }
+                const auto start_time = Clock::now();
+                TreeGenerator& context = contexts[worker];
+                context.begin_stats();
+                verdicts[index] = context.screen_seed(normalized_params, seed, constraints, screened[index]);
+                screen_stats[index] = context.stats_;
+                screen_times[index] = Clock::now() - start_time;
+            });
+            
+            for (size_t index = 0; index < block; ++index) {
+                switch (verdicts[index]) {
+                    case SeedVerdict::Skipped:
+                        continue;
+                    case SeedVerdict::RejectedSkeleton:
+                        ++result.rejected_skeleton;
+                        break;
+                    case SeedVerdict::RejectedStructure:
+                        ++result.rejected_structure;
+                        break;
+                    case SeedVerdict::Accepted:
+                        ++result.accepted;
+                        if (winners.size() < max_results) {
+                            winners.push_back(screened[index]);
+                            winner_seeds.push_back(static_cast<uint32_t>(first_seed + begin + index));
+                            winner_stats.push_back(screen_stats[index]);
+                            winner_times.push_back(screen_times[index]);
+                        }
+                        break;
+                }
+                ++result.examined;
+            }
+        }
+        
+        result.trees.resize(winners.size());
+        parallel_for(winners.size(), contexts.size(), [&](size_t index, size_t worker) {
+            const auto start_time = Clock::now() - winner_times[index];
+            TreeGenerator& context = contexts[worker];
+            context.stats_ = winner_stats[index];
+            context.render_tree_into(result.trees[index].first, winners[index]);
+            result.trees[index].second = context.make_metadata(winners[index], winner_seeds[index], start_time);
+        });
+        return result;
+    }
+    
+    // Seeds search_seeds screens between two checks of max_results
+    static constexpr size_t search_block = 256;
+    
+    // Batch generation straight into a sprite atlas
+    //
+    // All structures are built first, their cropped canvas rectangles packed
+    // into pages (see ShelfPacker), and each worker then rasterizes its tree
+    // directly into the page region reserved for it, so no sprite is copied.
+    // Every sprite matches generate_cropped for the same parameters; seeds are
+    // resolved as in generate_batch.
+    std::pair<SpriteAtlas<PixelType>, std::vector<TreeMetadata>>
+    generate_atlas(const std::vector<TreeParameters>& params_list, const AtlasLayout& layout = {},
+                   size_t thread_count = 0) {
+        using Clock = std::chrono::high_resolution_clock;
+        const size_t count = params_list.size();
+        const std::vector<uint32_t> seeds = resolve_seeds(params_list);
+        std::vector<TreeGenerator> contexts = worker_contexts(count, thread_count);
+        
+        std::vector<TreeStructure> trees(count, TreeStructure(TreeParameters{}));
+        std::vector<GenerationStats> build_stats(count);
+        std::vector<Clock::duration> build_times(count);
+        parallel_for(count, contexts.size(), [&](size_t index, size_t worker) {
+            const auto start_time = Clock::now();
+            TreeParameters normalized_params = params_list[index];
+            normalized_params.validate();
+            
+            TreeGenerator& context = contexts[worker];
+            context.begin_stats();
+            context.build_structure(normalized_params, seeds[index], trees[index]);
+            build_stats[index] = context.stats_;
+            build_times[index] = Clock::now() - start_time;
+        });
+        
+        std::vector<Rect2Di> rects;
+        rects.reserve(count);
+        for (const auto& tree : trees) {
+            rects.push_back(TreeRenderer::crop_rect(tree));
+        }
+        auto atlas = SpriteAtlas<PixelType>::reserve(rects, layout);
+        
+        // Reserved regions never overlap, so workers share the pages without locking
+        std::vector<TreeMetadata> metadata(count);
+        parallel_for(count, contexts.size(), [&](size_t index, size_t worker) {
+            const auto start_time = Clock::now() - build_times[index];
+            TreeGenerator& context = contexts[worker];
+            context.stats_ = build_stats[index];
+            {
+                StageTimer timer(context.stats_, GenerationStage::Raster);
+                auto target = atlas.target(index);
+                target.pixels_written = context.pixel_counter();
+                context.renderer_.render_into(target, trees[index]);
+            }
+            metadata[index] = context.make_metadata(trees[index], seeds[index], start_time);
+        });
+        
+        return {std::move(atlas), std::move(metadata)};
+    }
+    
+    // Live-editing view of one tree
+    //
+    // update() compares the new parameters with the previous ones and redoes
+    // only the stages that depend on what changed: style and bark edits only
+    // redraw, palette edits recolor in place, leaf edits regrow leaves on the
+    // kept skeleton, canvas edits re-place it, and only skeleton edits re-run
+    // the L-System. The result is always identical to generate() with the
+    // same parameters and seed. The session uses its generator, which must
+    // outlive it and not be used concurrently.
+    class EditSession {
+        TreeGenerator& generator_;
+        TreeParameters params_;                     // Validated parameters of the current tree
+        uint32_t seed_ = 0;
+        StructureKey key_;
+        bool built_ = false;
+        
+        StructureCache::Skeleton skeleton_;         // Trunk base at the origin
+        TreeStructure tree_{TreeParameters{}};
+        std::vector<LeafColorDraw> color_draws_;    // One per leaf cluster
+        PixelBuffer<PixelType> pixels_;
+        
+    public:
+        explicit EditSession(TreeGenerator& generator) : generator_(generator) {}
+        
+        // Bring the tree and pixels up to date with params and report the
+        // stages that were redone (DirtyFlags::None if nothing relevant changed).
+        // random_seed == 0 keeps the seed of the previous update.
+        DirtyFlags update(const TreeParameters& params) {
+            TreeParameters normalized_params = params;
+            normalized_params.validate();
+            generator_.begin_stats();
+            
+            const uint32_t seed = params.random_seed != 0 ? params.random_seed
+                                : built_ ? seed_ : generator_.resolve_seed(params);
+            StructureKey key = StructureKey::make(normalized_params, seed, MaxBranches,
+                                                  generator_.lsystem_.custom_grammar(), Geometry::fixed_point);
+            const DirtyFlags dirty = built_ ? changes(normalized_params, key) : DirtyFlags::All;
+            
+            if (has(dirty, DirtyFlags::Skeleton)) {
+                generator_.build_skeleton(normalized_params, seed, key, tree_);
+                skeleton_.assign(tree_.branches.begin(), tree_.branches.end());
+            }
+            
+            if (has(dirty, DirtyFlags::Skeleton | DirtyFlags::Placement | DirtyFlags::Leaves)) {
+                if (!has(dirty, DirtyFlags::Skeleton)) {
+                    copy_skeleton(skeleton_, normalized_params, tree_);
+                }
+                tree_.parameters = normalized_params;
+                generator_.dress_structure(normalized_params, seed, tree_, &color_draws_);
+            } else {
+                tree_.parameters = normalized_params;
+                if (has(dirty, DirtyFlags::BranchColors)) {
+                    apply_trunk_color(tree_);
+                }
+                if (has(dirty, DirtyFlags::LeafColors)) {
+                    for (size_t i = 0; i < tree_.leaf_clusters.size(); ++i) {
+                        tree_.leaf_clusters[i].color = leaf_color(normalized_params.leaves, color_draws_[i]);
+                    }
+                }
+            }
+            
+            if (has(dirty, DirtyFlags::Raster)) {
+                generator_.render_tree_into(pixels_, tree_);
+            }
+            
+            params_ = normalized_params;
+            seed_ = seed;
+            key_ = std::move(key);
+            built_ = true;
+            generator_.finish_stats();
+            return dirty;
+        }
+        
+        const PixelBuffer<PixelType>& pixels() const noexcept { return pixels_; }
+        const TreeStructure& structure() const noexcept { return tree_; }
+        uint32_t seed() const noexcept { return seed_; }
+        
+    private:
+        // Stages affected by moving from params_ to the validated `next`
+        DirtyFlags changes(const TreeParameters& next, const StructureKey& next_key) const {
+            DirtyFlags dirty = DirtyFlags::None;
+            if (!(next_key == key_)) {
+                dirty = dirty | DirtyFlags::Skeleton;
+            }
+            if (next.canvas_width.get() != params_.canvas_width.get() ||
+                next.canvas_height.get() != params_.canvas_height.get()) {
+                dirty = dirty | DirtyFlags::Placement;
+            }
+            
+            const LeafParameters& leaves = params_.leaves;
+            if (next.leaves.density.get() != leaves.density.get() ||
+                next.leaves.size_base.get() != leaves.size_base.get() ||
+                next.leaves.size_variation.get() != leaves.size_variation.get()) {
+                dirty = dirty | DirtyFlags::Leaves;
+            }
+            if (next.leaves.color_variation.get() != leaves.color_variation.get() ||
+                !std::equal(leaves.base_colors.begin(), leaves.base_colors.end(), next.leaves.base_colors.begin(),
+                            [](const Color& a, const Color& b) { return a.to_rgba() == b.to_rgba(); })) {
+                dirty = dirty | DirtyFlags::LeafColors;
+            }
+            if (next.trunk.base_color.to_rgba() != params_.trunk.base_color.to_rgba()) {
+                dirty = dirty | DirtyFlags::BranchColors;
+            }
+            if (next.render_style != params_.render_style ||
+                next.trunk.texture_noise.get() != params_.trunk.texture_noise.get() ||
+                next.trunk.bark_detail.get() != params_.trunk.bark_detail.get()) {
+                dirty = dirty | DirtyFlags::Raster;     // Same structure, drawn differently
+            }
+            
+            return dirty == DirtyFlags::None ? dirty : dirty | DirtyFlags::Raster;
+        }
+    };
+    
+    // Start a live-editing session on this generator
+    EditSession edit_session() {
+        return EditSession(*this);
+    }
+    
+    // Async generation on a private copy of this generator
+    //
+    // Each call starts its own thread; for sustained request streams use a
+    // GeneratorService, which runs a fixed worker pool.
     std::future<std::pair<PixelBuffer<PixelType>, TreeMetadata>> 
     generate_async(const TreeParameters& params) {
-        return std::async(std::launch::async, [this, params]() {
-            return generate(params);
+        TreeParameters seeded_params = params;
+        seeded_params.random_seed = resolve_seed(params);
+        
+        return std::async(std::launch::async, [context = *this, seeded_params]() mutable {
+            return context.generate(seeded_params);
         });
     }
+    
+    // Seed generate() uses for params: an explicit random_seed as-is,
+    // otherwise the next draw from this generator's seed stream
+    uint32_t resolve_seed(const TreeParameters& params) const {
+        if (params.random_seed != 0) {
+            return params.random_seed;
+        }
+        
+        uint32_t seed = seed_rng_.next_uint();
+        while (seed == 0) {
+            seed = seed_rng_.next_uint();
+        }
+        return seed;
+    }
 
 private:
+    // Streams of a tree's seed: the branch structure and the leaves draw from
+    // independent sequences, so changing one does not reshuffle the other
+    static constexpr uint64_t structure_stream = 0;
+    static constexpr uint64_t leaf_stream = 1;
+    
+    // Seeds for a batch, drawn up front in input order
+    std::vector<uint32_t> resolve_seeds(const std::vector<TreeParameters>& params_list) const {
+        std::vector<uint32_t> seeds;
+        seeds.reserve(params_list.size());
+        for (const auto& params : params_list) {
+            seeds.push_back(resolve_seed(params));
+        }
+        return seeds;
+    }
+    
+    // Private copies of this generator for the workers of a batch
+    std::vector<TreeGenerator> worker_contexts(size_t work_items, size_t thread_count) const {
+        const size_t workers = resolve_thread_count(work_items, thread_count);
+        std::vector<TreeGenerator> contexts(workers, *this);
+        if (workers > 1) {
+            // The batch is already parallel; do not nest per-tree render threads
+            for (auto& context : contexts) {
+                context.render_threads_ = 1;
+            }
+        }
+        return contexts;
+    }
+    
+    enum class SeedVerdict : uint8_t {
+        Skipped,
+        RejectedSkeleton,
+        RejectedStructure,
+        Accepted
+    };
+    
+    // One search_seeds candidate, built into tree only as far as needed and
+    // without the StructureCache, so screening leaves its working set alone
+    template<size_t Capacity>
+    SeedVerdict screen_seed(const TreeParameters& normalized_params, uint32_t seed,
+                            const SearchConstraints& constraints, BasicTreeStructure<Capacity>& tree) {
+        expand_skeleton(normalized_params, seed, tree);
+        if (!constraints.accepts_skeleton(StructureMetrics::of_skeleton(tree))) {
+            return SeedVerdict::RejectedSkeleton;
+        }
+        dress_structure(normalized_params, seed, tree, nullptr);
+        return constraints.accepts(StructureMetrics::of(tree)) ? SeedVerdict::Accepted
+                                                               : SeedVerdict::RejectedStructure;
+    }
+    
+    // Build the tree for params into scratch_ and return the seed used
+    uint32_t build_scratch_structure(const TreeParameters& params) {
+        // Validate and normalize parameters
+        TreeParameters normalized_params = params;
+        normalized_params.validate();
+        
+        // Build into the arena from the previous tree
+        const uint32_t actual_seed = resolve_seed(params);
+        build_structure(normalized_params, actual_seed, scratch_);
+        return actual_seed;
+    }
+    
+    // Build the tree for validated params: branch skeleton, then everything
+    // that does not change the branch layout
+    template<size_t Capacity>
+    void build_structure(const TreeParameters& normalized_params, uint32_t seed,
+                         BasicTreeStructure<Capacity>& tree) {
+        if (structure_cache_) {
+            build_skeleton(normalized_params, seed, StructureKey::make(normalized_params, seed, MaxBranches,
+                                                                       lsystem_.custom_grammar(), Geometry::fixed_point),
+                           tree);
+        } else {
+            expand_skeleton(normalized_params, seed, tree);
+        }
+        dress_structure(normalized_params, seed, tree, nullptr);
+    }
+    
+    // Branches with the trunk base at the origin, from the StructureCache when set
+    template<size_t Capacity>
+    void build_skeleton(const TreeParameters& normalized_params, uint32_t seed, const StructureKey& key,
+                        BasicTreeStructure<Capacity>& tree) {
+        if (structure_cache_) {
+            if (const auto cached = structure_cache_->find(key)) {
+                StageTimer timer(stats_, GenerationStage::TreeBuild);
+                GrowthProbe probe(stats_, tree.branches);
+                copy_skeleton(*cached, normalized_params, tree);
+                if constexpr (instrumentation_enabled) {
+                    ++stats_.cache_hits;
+                }
+                return;
+            }
+        }
+        
+        expand_skeleton(normalized_params, seed, tree);
+        if (structure_cache_) {
+            structure_cache_->insert(key, StructureCache::Skeleton(tree.branches.begin(), tree.branches.end()));
+        }
+    }
+    
+    // Branches with the trunk base at the origin, expanded from the L-System
+    // straight into the tree structure; never touches the StructureCache
+    template<size_t Capacity>
+    void expand_skeleton(const TreeParameters& normalized_params, uint32_t seed,
+                         BasicTreeStructure<Capacity>& tree) {
+        lsystem_.setup_rules(normalized_params.type);
+        rng_ = Random(seed, structure_stream);
+        {
+            StageTimer timer(stats_, GenerationStage::Expansion);
+            GrowthProbe probe(stats_, plan_.decisions);
+            lsystem_.plan_expansion(normalized_params, rng_, plan_, MaxBranches);
+        }
+        {
+            StageTimer timer(stats_, GenerationStage::TreeBuild);
+            GrowthProbe probe(stats_, plan_.state_stack, tree.branches);
+            const size_t symbols = lsystem_.build_from_plan<Geometry>(normalized_params, rng_, tree, plan_);
+            if constexpr (instrumentation_enabled) {
+                stats_.lstring_length += symbols;
+                stats_.rng_draws += rng_.draws_since(Random(seed, structure_stream));
+            }
+        }
+    }
+    
+    template<size_t Capacity>
+    static void copy_skeleton(const StructureCache::Skeleton& skeleton, const TreeParameters& params,
+                              BasicTreeStructure<Capacity>& tree) {
+        tree.reset(params);
+        for (const Branch& branch : skeleton) {
+            tree.branches.push_back(branch);
+        }
+    }
+    
+    // Place a skeleton on the canvas, color it, grow leaves and compute bounds
+    template<size_t Capacity>
+    void dress_structure(const TreeParameters& normalized_params, uint32_t seed,
+                         BasicTreeStructure<Capacity>& tree, std::vector<LeafColorDraw>* color_draws) const {
+        StageTimer timer(stats_, GenerationStage::Leaves);
+        GrowthProbe probe(stats_, tree.leaf_clusters);
+        tree.translate(LSystemGenerator::trunk_base<Geometry>(normalized_params));
+        apply_trunk_color(tree);
+        
+        // Generate leaf clusters
+        Random leaf_rng(seed, leaf_stream);
+        generate_leaf_clusters(tree, leaf_rng, color_draws);
+        if constexpr (instrumentation_enabled) {
+            stats_.rng_draws += leaf_rng.draws_since(Random(seed, leaf_stream));
+        }
+        
+        // Calculate bounding box
+        tree.calculate_bounding_box();
+    }
+    
+    template<size_t Capacity>
+    static void apply_trunk_color(BasicTreeStructure<Capacity>& tree) noexcept {
+        for (auto& branch : tree.branches) {
+            branch.color = tree.parameters.trunk.base_color;
+        }
+    }
+    
+    // Full-canvas render of a tree structure or TreeView on render_threads_
+    template<typename Tree>
+    void render_tree_into(PixelBuffer<PixelType>& pixel_buffer, const Tree& tree) const {
+        StageTimer timer(stats_, GenerationStage::Raster);
+        GrowthProbe probe(stats_, pixel_buffer);
+        if (render_threads_ == 1) {
+            renderer_.render_into(pixel_buffer, tree, pixel_counter());
+        } else {
+            BasicBandRenderer<Geometry>(render_threads_).render_into(pixel_buffer, tree, pixel_counter());
+        }
+        count_covered(pixel_buffer);
+    }
+    
+    // Start a fresh GenerationStats for one call
+    void begin_stats() const noexcept {
+        if constexpr (instrumentation_enabled) {
+            stats_ = GenerationStats{};
+            stats_.trees = 1;
+        }
+    }
+    
+    // Hand the stats of the finished call to the sink
+    void finish_stats() const {
+        if constexpr (instrumentation_enabled) {
+            if (stats_sink_) {
+                stats_sink_->record(stats_);
+            }
+        }
+    }
+    
+    uint64_t* pixel_counter() const noexcept {
+        return instrumentation_enabled ? &stats_.pixels_written : nullptr;
+    }
+    
+    // Pixels that differ from the background, for the overdraw count
+    void count_covered(const PixelBuffer<PixelType>& pixels) const {
+        if constexpr (instrumentation_enabled) {
+            const PixelType background = PixelTraits<PixelType>::from_rgba(0x00000000);
+            stats_.pixels_covered += static_cast<uint64_t>(std::count_if(
+                pixels.data(), pixels.data() + pixels.size(),
+                [background](PixelType pixel) { return pixel != background; }));
+        }
+    }
+    
+    // Metadata of the finished call; also hands its stats to the sink
+    template<size_t Capacity>
+    TreeMetadata make_metadata(const BasicTreeStructure<Capacity>& tree_structure, uint32_t actual_seed,
+                               std::chrono::high_resolution_clock::time_point start_time) const {
+        // Calculate generation time
+        const auto end_time = std::chrono::high_resolution_clock::now();
+        const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            end_time - start_time);
+        const float generation_time = duration.count() / 1000.0f; // Convert to milliseconds
+        finish_stats();
+        
+        TreeMetadata metadata = describe(tree_structure, actual_seed);
+        metadata.generation_time_ms = generation_time;
+        metadata.stats = stats_;
+        return metadata;
+    }
+    
+    // Metadata fields that depend only on the tree
+    template<size_t Capacity>
+    static TreeMetadata describe(const BasicTreeStructure<Capacity>& tree_structure, uint32_t actual_seed) {
+        return TreeMetadata{
+            .generation_id = tree_structure.generation_id,
+            .branch_count = tree_structure.branch_count(),
+            .leaf_count = tree_structure.leaf_cluster_count(),
+            .max_depth = tree_structure.max_depth(),
+            .generation_time_ms = 0.0f,
+            .bounding_box = tree_structure.bounding_box,
+            .random_seed = actual_seed,
+            .stats = {}
+        };
+    }
+    
+    // Same arithmetic as Random::next_float(-color_var, color_var) per channel;
+    // FixedGeometry redoes it in 16.16 from the exact 24-bit draws
+    static Color leaf_color(const LeafParameters& leaves, const LeafColorDraw& draw) noexcept {
+        const Color base_color = leaves.base_colors[static_cast<size_t>(draw.palette_index)];
+        if constexpr (Geometry::fixed_point) {
+            const int64_t color_var = FixedPoint::from_float(leaves.color_variation.get(), FixedPoint::scale_bits);
+            auto channel = [color_var](uint8_t value, float variation) {
+                const int64_t bits = FixedPoint::from_float(variation, 24);
+                const int64_t jitter = -color_var + ((2 * color_var * bits) >> 24);
+                const int64_t scaled = (value * ((int64_t{1} << FixedPoint::scale_bits) + jitter)) >> FixedPoint::scale_bits;
+                return static_cast<uint8_t>(std::clamp<int64_t>(scaled, 0, 255));
+            };
+            return Color{channel(base_color.r, draw.variation[0]),
+                         channel(base_color.g, draw.variation[1]),
+                         channel(base_color.b, draw.variation[2]),
+                         base_color.a};
+        }
+        
+        const float color_var = leaves.color_variation.get();
+        auto channel = [color_var](uint8_t value, float variation) {
+            const float jitter = -color_var + variation * (color_var - -color_var);
+            return static_cast<uint8_t>(std::clamp(value * (1.0f + jitter), 0.0f, 255.0f));
+        };
+        return Color{channel(base_color.r, draw.variation[0]),
+                     channel(base_color.g, draw.variation[1]),
+                     channel(base_color.b, draw.variation[2]),
+                     base_color.a};
+    }
+    
     // Generate leaf clusters at branch endpoints
-    void generate_leaf_clusters(TreeStructure& tree, Random& rng) const {
+    template<size_t Capacity>
+    void generate_leaf_clusters(BasicTreeStructure<Capacity>& tree, Random& rng,
+                                std::vector<LeafColorDraw>* color_draws = nullptr) const {
+        if (color_draws) {
+            color_draws->clear();
+        }
         if (tree.parameters.leaves.density.get() <= 0.0f) {
             return; // No leaves for dead trees
         }
         
-        const auto leaf_branches = tree.get_leaf_branches();
-        tree.leaf_clusters.reserve(leaf_branches.size());
-        
-        for (const auto& branch : leaf_branches) {
+        for (const auto& branch : tree.branches) {
+            if (!branch.is_leaf()) {
+                continue;
+            }
+            
             if (rng.next_float() < tree.parameters.leaves.density.get()) {
                 // Create leaf cluster at branch endpoint
                 const float base_size = tree.parameters.leaves.size_base.get();
                 const float size_var = tree.parameters.leaves.size_variation.get();
-                const float cluster_size = base_size * (1.0f + rng.next_float(-size_var, size_var));
+                const float cluster_size = next_cluster_size(rng, base_size, size_var);
                 
                 // Color variation
-                const auto& base_colors = tree.parameters.leaves.base_colors;
-                const Color base_color = base_colors[rng.next_int(0, 3)];
-                const float color_var = tree.parameters.leaves.color_variation.get();
-                
-                Color leaf_color{
-                    static_cast<uint8_t>(std::clamp(base_color.r * (1.0f + rng.next_float(-color_var, color_var)), 0.0f, 255.0f)),
-                    static_cast<uint8_t>(std::clamp(base_color.g * (1.0f + rng.next_float(-color_var, color_var)), 0.0f, 255.0f)),
-                    static_cast<uint8_t>(std::clamp(base_color.b * (1.0f + rng.next_float(-color_var, color_var)), 0.0f, 255.0f)),
-                    base_color.a
-                };
+                LeafColorDraw color_draw{rng.next_int(0, 3), {}};
+                for (float& variation : color_draw.variation) {
+                    variation = rng.next_float();
+                }
+                if (color_draws) {
+                    color_draws->push_back(color_draw);
+                }
                 
-                LeafCluster cluster(branch->end_point, cluster_size, leaf_color);
+                LeafCluster cluster(branch.end_point, cluster_size, leaf_color(tree.parameters.leaves, color_draw));
                 
                 // Set cluster shape based on tree type
                 switch (tree.parameters.type) {
@@ -197,32 +946,77 @@ private:
                 tree.leaf_clusters.emplace_back(std::move(cluster));
             }
         }
+        
+        // Individual leaves for the shapes that are drawn from them. Drawn after
+        // all clusters so the cluster RNG sequence is the same for every shape.
+        for (auto& cluster : tree.leaf_clusters) {
+            if (cluster.shape == LeafCluster::Shape::Spiky ||
+                cluster.shape == LeafCluster::Shape::Scattered) {
+                scatter_leaves(cluster, rng);
+            }
+        }
     }
     
-    // Convert pixel buffer types
-    template<typename TargetPixelType>
-    PixelBuffer<TargetPixelType> convert_pixel_buffer(const PixelBuffer32& source) const {
-        PixelBuffer<TargetPixelType> result(source.width(), source.height());
-        
-        for (size_t i = 0; i < source.size(); ++i) {
-            if constexpr (std::is_same_v<TargetPixelType, uint8_t>) {
-                // Convert RGBA to grayscale
-                const uint32_t rgba = source.data()[i];
-                const uint8_t r = (rgba >> 24) & 0xFF;
-                const uint8_t g = (rgba >> 16) & 0xFF;
-                const uint8_t b = (rgba >> 8) & 0xFF;
-                result.data()[i] = static_cast<uint8_t>(0.299f * r + 0.587f * g + 0.114f * b);
-            } else {
-                result.data()[i] = static_cast<TargetPixelType>(source.data()[i]);
+    // base_size * (1 + next_float(-size_var, size_var)), on the 24.8 grid for FixedGeometry
+    static float next_cluster_size(Random& rng, float base_size, float size_var) noexcept {
+        if constexpr (Geometry::fixed_point) {
+            constexpr int64_t unit = int64_t{1} << FixedPoint::scale_bits;
+            const int64_t variation = FixedPoint::from_float(size_var, FixedPoint::scale_bits);
+            const int64_t factor = unit + FixedPoint::draw(rng, -variation, variation);
+            return FixedPoint::to_float(FixedPoint::mul(FixedPoint::from_float(base_size), factor,
+                                                        FixedPoint::scale_bits));
+        }
+        return base_size * (1.0f + rng.next_float(-size_var, size_var));
+    }
+    
+    // The cluster's individual leaves (LeafCluster::generate_leaves); FixedGeometry
+    // draws the same points in integers, on the 24.8 grid
+    static void scatter_leaves(LeafCluster& cluster, Random& rng) {
+        if constexpr (!Geometry::fixed_point) {
+            cluster.generate_leaves(rng, 4 + static_cast<int>(cluster.size * 1.5f));
+        } else {
+            const int64_t size = FixedPoint::from_float(cluster.size);
+            const int64_t leaf_count = 4 + ((size * 3) >> (FixedPoint::fraction_bits + 1));
+            const int64_t center_x = FixedPoint::from_float(cluster.position.x);
+            const int64_t center_y = FixedPoint::from_float(cluster.position.y);
+            constexpr int64_t full_turn = int64_t{360} << FixedPoint::scale_bits;
+            constexpr int64_t unit = int64_t{1} << FixedPoint::scale_bits;
+            
+            cluster.leaf_positions.clear();
+            cluster.leaf_positions.reserve(static_cast<size_t>(leaf_count));
+            for (int64_t i = 0; i < leaf_count; ++i) {
+                // Point in the circle: uniform angle, sqrt(uniform) radius (Random::next_point_in_circle)
+                const FixedSinCos angle = FixedPoint::sincos_degrees(FixedPoint::draw(rng, 0, full_turn));
+                const auto unit_radius = static_cast<int64_t>(FixedPoint::isqrt(uint64_t{rng.next_uint() >> 8} << 8));
+                int64_t radius = FixedPoint::mul(size, unit_radius, FixedPoint::scale_bits);    // 24.8
+                int64_t stretch_x = unit;
+                switch (cluster.shape) {
+                    case LeafCluster::Shape::Ellipse:
+                        stretch_x = unit + unit / 2;
+                        break;
+                    case LeafCluster::Shape::Spiky:
+                        radius = FixedPoint::mul(radius, unit + FixedPoint::draw(rng, -(unit * 3) / 10, unit / 2),
+                                                 FixedPoint::scale_bits);
+                        break;
+                    case LeafCluster::Shape::Scattered:
+                        radius = radius + radius / 2;
+                        break;
+                    case LeafCluster::Shape::Circle:
+                        break;
+                }
+                const int64_t x = FixedPoint::mul(FixedPoint::mul(radius, angle.cos, FixedPoint::unit_bits), stretch_x,
+                                                  FixedPoint::scale_bits);
+                const int64_t y = FixedPoint::mul(radius, angle.sin, FixedPoint::unit_bits);
+                cluster.leaf_positions.push_back(Point2Df{FixedPoint::to_float(center_x + x),
+                                                          FixedPoint::to_float(center_y + y)});
             }
         }
-        
-        return result;
     }
 };
 
 // Convenience type aliases
 using TreeGenerator32 = TreeGenerator<uint32_t, 64>;
 using TreeGenerator8 = TreeGenerator<uint8_t, 32>;
+using FixedTreeGenerator32 = TreeGenerator<uint32_t, 64, FixedGeometry>;
 
 } // namespace pixeltree
\ No newline at end of file
@@ -35,6 +35,12 @@ enum class Season : uint8_t {
     Winter
 };
 
+// How a tree is rasterized
+enum class RenderStyle : uint8_t {
+    Pixel = 0,      // Hard-edged, flat-colored shapes (pixel art)
+    Smooth          // Anti-aliased edges, with the trunk texture parameters applied
+};
+
 // Branch generation parameters
 struct BranchParameters {
     BoundedFloat10 base_thickness{2.0f};        // Base trunk thickness
@@ -66,8 +72,8 @@ struct LeafParameters {
 struct TrunkParameters {
     Color base_color{101, 67, 33};              // Base trunk color
     BoundedFloat01 color_variation{0.15f};      // Color variation amount
-    BoundedFloat01 texture_noise{0.1f};         // Texture noise intensity
-    BoundedFloat01 bark_detail{0.0f};           // Bark texture detail (0 = smooth)
+    BoundedFloat01 texture_noise{0.1f};         // Texture noise intensity (RenderStyle::Smooth)
+    BoundedFloat01 bark_detail{0.0f};           // Bark texture detail, 0 = smooth (RenderStyle::Smooth)
 };
 
 // Main tree generation parameters
@@ -78,8 +84,9 @@ struct TreeParameters {
     Season season = Season::Summer;
     
     // Size constraints
-    BoundedValue<int, 16, 512> canvas_width{128};
-    BoundedValue<int, 16, 512> canvas_height{128};
+    // Large canvases are best rendered with TiledRenderer
+    BoundedValue<int, 16, 8192> canvas_width{128};
+    BoundedValue<int, 16, 8192> canvas_height{128};
     BoundedFloat10 overall_scale{1.0f};
     
     // Component parameters
@@ -92,6 +99,9 @@ struct TreeParameters {
     BoundedFloat01 wind_strength{0.0f};         // Wind strength (affects lean)
     BoundedFloat01 age_factor{0.5f};            // Age factor (affects appearance)
     
+    // Rendering
+    RenderStyle render_style = RenderStyle::Pixel;
+    
     // Generation settings
     uint32_t random_seed = 0;                   // 0 = use random seed
     BoundedFloat01 determinism{0.8f};           // How deterministic vs random
@@ -134,6 +144,23 @@ struct TreeParameters {
             leaves.density = leaves.density.get() * 0.3f; // Sparse leaves
         }
     }
+    
+    // Every bounded field in range and every enum a declared value; holds for
+    // any TreeParameters built in code, not necessarily for raw stored bytes
+    bool in_bounds() const noexcept {
+        return type <= TreeType::Custom && growth_stage <= GrowthStage::Dead && season <= Season::Winter &&
+               render_style <= RenderStyle::Smooth &&
+               canvas_width.in_bounds() && canvas_height.in_bounds() && overall_scale.in_bounds() &&
+               branches.base_thickness.in_bounds() && branches.thickness_decay.in_bounds() &&
+               branches.branch_probability.in_bounds() && branches.branch_angle_variation.in_bounds() &&
+               branches.max_depth.in_bounds() && branches.max_branches.in_bounds() &&
+               branches.curvature.in_bounds() && branches.asymmetry.in_bounds() &&
+               leaves.density.in_bounds() && leaves.size_base.in_bounds() && leaves.size_variation.in_bounds() &&
+               leaves.color_variation.in_bounds() && leaves.alpha_variation.in_bounds() &&
+               trunk.color_variation.in_bounds() && trunk.texture_noise.in_bounds() && trunk.bark_detail.in_bounds() &&
+               wind_direction.in_bounds() && wind_strength.in_bounds() && age_factor.in_bounds() &&
+               determinism.in_bounds();
+    }
 };
 
 // Preset configurations for common tree types
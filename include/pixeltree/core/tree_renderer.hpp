@@ -1,120 +1,418 @@
 #pragma once
 #include "pixel_buffer.hpp"
+#include "pixel_format.hpp"
 #include "tree_structure.hpp"
+#include "tree_archive.hpp"
+#include "rasterizer.hpp"
 #include <cmath>
 
 namespace pixeltree {
 
+// Sprite holding only the part of the canvas a tree covers
+template<typename PixelType>
+struct CroppedSprite {
+    PixelBuffer<PixelType> pixels;
+    Point2Di origin;                    // Canvas position of pixels(0, 0)
+    
+    // Canvas rectangle covered by the sprite (max exclusive)
+    Rect2Di canvas_rect() const noexcept {
+        return Rect2Di{origin, {origin.x + static_cast<int>(pixels.width()),
+                                origin.y + static_cast<int>(pixels.height())}};
+    }
+};
+
 // High-performance tree renderer
-class TreeRenderer {
+//
+// Renders straight into any PixelType with PixelTraits: each shape color is
+// converted once and spans are filled in the target format, so no RGBA
+// intermediate is needed for gray or RGB565 output.
+//
+// TreeParameters::render_style picks the look. Pixel draws hard-edged shapes
+// at pixel-snapped sizes; Smooth draws the exact geometry anti-aliased (see
+// the SpanRasterizer blend_* fills) with bark from TrunkParameters, in one
+// pass at canvas resolution. Both stay within branch_bounds / cluster_bounds.
+//
+// Geometry picks the rasterizer of the Pixel style: SpanRasterizer for
+// FloatGeometry, the integer FixedRasterizer for FixedGeometry. The Smooth
+// coverage ramp is float with either.
+template<typename Geometry = FloatGeometry>
+class BasicTreeRenderer {
+    using Raster = typename Geometry::Rasterizer;
+
 public:
     // Render complete tree to pixel buffer
-    PixelBuffer32 render(const TreeStructure& tree) const {
+    template<typename PixelType = uint32_t, size_t Capacity>
+    PixelBuffer<PixelType> render(const BasicTreeStructure<Capacity>& tree) const {
+        PixelBuffer<PixelType> buffer;
+        render_into(buffer, tree);
+        return buffer;
+    }
+    
+    // Render into caller-owned storage, resized to the canvas; the existing
+    // allocation is reused when it is large enough. In instrumented builds the
+    // written span pixels are added to *pixels_written when given.
+    template<typename PixelType, size_t Capacity>
+    void render_into(PixelBuffer<PixelType>& buffer, const BasicTreeStructure<Capacity>& tree,
+                     uint64_t* pixels_written = nullptr) const {
         const auto& params = tree.parameters;
-        PixelBuffer32 buffer(params.canvas_width.get(), params.canvas_height.get());
+        buffer.reset(static_cast<size_t>(params.canvas_width.get()), static_cast<size_t>(params.canvas_height.get()));
         
-        // Clear with transparent background
-        buffer.clear(0x00000000);
+        // Clear with transparent background (the only clear of the canvas)
+        buffer.clear(PixelTraits<PixelType>::from_rgba(0x00000000));
         
-        // Render branches first (back to front)
-        render_branches(buffer, tree);
+        auto target = RasterTarget<PixelType>::from(buffer);
+        target.pixels_written = pixels_written;
+        render_into(target, tree);
+    }
+    
+    // Render only the canvas pixels inside the tree's bounding box; the pixels
+    // match the same region of a full render
+    template<typename PixelType = uint32_t, size_t Capacity>
+    CroppedSprite<PixelType> render_cropped(const BasicTreeStructure<Capacity>& tree) const {
+        CroppedSprite<PixelType> sprite;
+        render_cropped_into(sprite, tree);
+        return sprite;
+    }
+    
+    // Cropped render reusing the sprite's existing storage
+    template<typename PixelType, size_t Capacity>
+    void render_cropped_into(CroppedSprite<PixelType>& sprite, const BasicTreeStructure<Capacity>& tree,
+                             uint64_t* pixels_written = nullptr) const {
+        const Rect2Di area = crop_rect(tree);
+        sprite.origin = area.min;
+        sprite.pixels.reset(static_cast<size_t>(area.width()), static_cast<size_t>(area.height()));
+        sprite.pixels.clear(PixelTraits<PixelType>::from_rgba(0x00000000));
         
-        // Render leaves on top
-        render_leaves(buffer, tree);
+        auto target = RasterTarget<PixelType>::from(sprite.pixels, sprite.origin);
+        target.pixels_written = pixels_written;
+        render_into(target, tree);
+    }
+    
+    // Canvas pixels a render can touch (max exclusive): the bounding box grown
+    // by the rounding the rasterizer applies to stroke widths and leaf centers,
+    // clipped to the canvas
+    template<size_t Capacity>
+    static Rect2Di crop_rect(const BasicTreeStructure<Capacity>& tree) noexcept {
+        return crop_rect(tree.bounding_box, tree.parameters.canvas_width.get(),
+                         tree.parameters.canvas_height.get());
+    }
+    
+    // Same from a bounding box alone, e.g. TreeMetadata::bounding_box
+    static Rect2Di crop_rect(const Rect2Df& box, int canvas_width, int canvas_height) noexcept {
+        constexpr int margin = 2;
+        Rect2Di area{
+            {std::max(0, static_cast<int>(std::floor(box.min.x)) - margin),
+             std::max(0, static_cast<int>(std::floor(box.min.y)) - margin)},
+            {std::min(canvas_width, static_cast<int>(std::ceil(box.max.x)) + margin + 1),
+             std::min(canvas_height, static_cast<int>(std::ceil(box.max.y)) + margin + 1)}
+        };
         
-        return buffer;
+        // Trees entirely off-canvas give an empty sprite
+        area.max.x = std::max(area.max.x, area.min.x);
+        area.max.y = std::max(area.max.y, area.min.y);
+        return area;
     }
-
-private:
-    // Render all branches using line drawing
-    void render_branches(PixelBuffer32& buffer, const TreeStructure& tree) const {
-        for (const auto& branch : tree.all_branches) {
-            draw_thick_line(buffer, 
-                           branch->start_point, 
-                           branch->end_point,
-                           branch->thickness,
-                           branch->color.to_rgba());
+    
+    // Render a tree straight from archive memory (see TreeArchiveView); the
+    // pixels match a render of the structure it was written from
+    template<typename PixelType>
+    void render_into(PixelBuffer<PixelType>& buffer, const TreeView& tree, uint64_t* pixels_written = nullptr) const {
+        buffer.reset(static_cast<size_t>(tree.parameters->canvas_width.get()),
+                     static_cast<size_t>(tree.parameters->canvas_height.get()));
+        buffer.clear(PixelTraits<PixelType>::from_rgba(0x00000000));
+        
+        auto target = RasterTarget<PixelType>::from(buffer);
+        target.pixels_written = pixels_written;
+        render_into(target, tree);
+    }
+    
+    template<typename PixelType>
+    void render_into(const RasterTarget<PixelType>& target, const TreeView& tree) const {
+        const Style style = Style::of(*tree.parameters);
+        for (const auto& branch : tree.branches) {
+            draw_branch(target, branch, style);
+        }
+        for (const auto& cluster : tree.leaf_clusters) {
+            draw_leaf_shape(target, cluster.position, cluster.size, cluster.color, cluster.cluster_shape(),
+                            tree.leaves_of(cluster), style);
+        }
+    }
+    
+    // Draw the tree into an existing surface (nothing is cleared)
+    template<typename PixelType, size_t Capacity>
+    void render_into(const RasterTarget<PixelType>& target, const BasicTreeStructure<Capacity>& tree) const {
+        // Render branches first (back to front), leaves on top
+        render_branches(target, tree);
+        render_leaves(target, tree);
+    }
+    
+    // The two passes of render_into
+    template<typename PixelType, size_t Capacity>
+    void render_branches(const RasterTarget<PixelType>& target, const BasicTreeStructure<Capacity>& tree) const {
+        const Style style = Style::of(tree.parameters);
+        for (const auto& branch : tree.branches) {
+            draw_branch(target, branch, style);
         }
     }
     
-    // Render all leaf clusters
-    void render_leaves(PixelBuffer32& buffer, const TreeStructure& tree) const {
+    template<typename PixelType, size_t Capacity>
+    void render_leaves(const RasterTarget<PixelType>& target, const BasicTreeStructure<Capacity>& tree) const {
+        const Style style = Style::of(tree.parameters);
         for (const auto& cluster : tree.leaf_clusters) {
-            draw_leaf_cluster(buffer, cluster);
+            draw_leaf_cluster(target, cluster, style);
         }
     }
     
-    // Draw a thick line using Bresenham's algorithm with thickness
-    void draw_thick_line(PixelBuffer32& buffer, 
-                        Point2Df start, Point2Df end, 
-                        float thickness, uint32_t color) const {
-        // Convert to integer coordinates
-        const int x0 = static_cast<int>(std::round(start.x));
-        const int y0 = static_cast<int>(std::round(start.y));
-        const int x1 = static_cast<int>(std::round(end.x));
-        const int y1 = static_cast<int>(std::round(end.y));
-        
-        const int half_thickness = static_cast<int>(std::ceil(thickness * 0.5f));
-        
-        // Simple thick line by drawing multiple parallel lines
-        for (int offset = -half_thickness; offset <= half_thickness; ++offset) {
-            draw_line(buffer, x0 + offset, y0, x1 + offset, y1, color);
-            draw_line(buffer, x0, y0 + offset, x1, y1 + offset, color);
+    // Draw only the listed branches and clusters, in list order; with
+    // ascending index lists this matches render_into wherever the
+    // omitted primitives do not reach (see branch_bounds / cluster_bounds)
+    template<typename PixelType, size_t Capacity>
+    void render_primitives(const RasterTarget<PixelType>& target, const BasicTreeStructure<Capacity>& tree,
+                           const uint32_t* branch_indices, size_t branch_count,
+                           const uint32_t* cluster_indices, size_t cluster_count) const {
+        const Style style = Style::of(tree.parameters);
+        for (size_t i = 0; i < branch_count; ++i) {
+            draw_branch(target, tree.branches[branch_indices[i]], style);
+        }
+        for (size_t i = 0; i < cluster_count; ++i) {
+            draw_leaf_cluster(target, tree.leaf_clusters[cluster_indices[i]], style);
         }
     }
     
-    // Bresenham's line algorithm
-    void draw_line(PixelBuffer32& buffer, 
-                   int x0, int y0, int x1, int y1, uint32_t color) const {
-        const int dx = std::abs(x1 - x0);
-        const int dy = std::abs(y1 - y0);
-        const int sx = x0 < x1 ? 1 : -1;
-        const int sy = y0 < y1 ? 1 : -1;
-        int err = dx - dy;
+    // Same for a tree in archive memory
+    template<typename PixelType>
+    void render_primitives(const RasterTarget<PixelType>& target, const TreeView& tree,
+                           const uint32_t* branch_indices, size_t branch_count,
+                           const uint32_t* cluster_indices, size_t cluster_count) const {
+        const Style style = Style::of(*tree.parameters);
+        for (size_t i = 0; i < branch_count; ++i) {
+            draw_branch(target, tree.branches[branch_indices[i]], style);
+        }
+        for (size_t i = 0; i < cluster_count; ++i) {
+            const LeafClusterRecord& cluster = tree.leaf_clusters[cluster_indices[i]];
+            draw_leaf_shape(target, cluster.position, cluster.size, cluster.color, cluster.cluster_shape(),
+                            tree.leaves_of(cluster), style);
+        }
+    }
+    
+    // Canvas pixels a branch can touch (max exclusive, not clipped)
+    static Rect2Di branch_bounds(const Branch& branch) noexcept {
+        const float radius = branch_radius(branch.thickness);
+        return pixel_bounds(std::min(branch.start_point.x, branch.end_point.x) - radius,
+                            std::min(branch.start_point.y, branch.end_point.y) - radius,
+                            std::max(branch.start_point.x, branch.end_point.x) + radius,
+                            std::max(branch.start_point.y, branch.end_point.y) + radius);
+    }
+    
+    // Canvas pixels a leaf cluster can touch (max exclusive, not clipped); the
+    // margin covers center rounding and the width of individual leaves
+    static Rect2Di cluster_bounds(const LeafCluster& cluster) noexcept {
+        return cluster_bounds(cluster.position, cluster.size, cluster.reach());
+    }
+    
+    static Rect2Di cluster_bounds(const LeafClusterRecord& cluster) noexcept {
+        return cluster_bounds(cluster.position, cluster.size, cluster.reach());
+    }
+
+private:
+    static Rect2Di cluster_bounds(Point2Df position, float size, float shape_reach) noexcept {
+        const float reach = std::max(std::ceil(size), shape_reach) + 2.0f;
+        return pixel_bounds(position.x - reach, position.y - reach, position.x + reach, position.y + reach);
+    }
+    
+    static Rect2Di pixel_bounds(float min_x, float min_y, float max_x, float max_y) noexcept {
+        return Rect2Di{{static_cast<int>(std::floor(min_x)), static_cast<int>(std::floor(min_y))},
+                       {static_cast<int>(std::ceil(max_x)) + 1, static_cast<int>(std::ceil(max_y)) + 1}};
+    }
+    
+    // Render settings taken from the tree's parameters once per draw
+    struct Style {
+        bool smooth = false;
+        float bark_noise = 0.0f;
+        float bark_detail = 0.0f;
         
-        int x = x0, y = y0;
+        static Style of(const TreeParameters& params) noexcept {
+            return Style{params.render_style == RenderStyle::Smooth,
+                         params.trunk.texture_noise.get(), params.trunk.bark_detail.get()};
+        }
         
-        while (true) {
-            if (buffer.contains(x, y)) {
-                buffer(x, y) = color;
-            }
-            
-            if (x == x1 && y == y1) break;
+        bool textured() const noexcept { return bark_noise > 0.0f || bark_detail > 0.0f; }
+    };
+    
+    // Smooth-style branch surface: per-pixel grain scaled by texture_noise,
+    // and for bark_detail a rounded shading across the branch with broken
+    // grooves running along it. Grain hashes the canvas position and grooves
+    // the branch's own coordinates, so every clip of a draw agrees.
+    struct BarkPaint {
+        static constexpr bool uniform = false;
+        uint32_t rgba;
+        float noise;
+        float detail;
+        float grooves;          // Grooves across the branch
+        uint32_t salt;          // Varies the groove pattern between branches
+        
+        uint32_t operator()(int x, int y, float across, float along) const noexcept {
+            const float grain = signed_unit(hash(static_cast<uint32_t>(x) * 0x9E3779B1u ^
+                                                 static_cast<uint32_t>(y) * 0x85EBCA77u));
+            const auto lane = static_cast<uint32_t>((across + 1.0f) * 0.5f * grooves);     // across >= -1
+            const auto segment = static_cast<uint32_t>(along * 0.25f);                     // along >= 0
+            const float groove = signed_unit(hash(salt ^ lane * 0xC2B2AE3Du ^ segment * 0x27D4EB2Fu));
             
-            const int e2 = 2 * err;
-            if (e2 > -dy) {
-                err -= dy;
-                x += sx;
+            const float shade = 1.0f + 0.3f * noise * grain + detail * (0.2f * groove - 0.35f * across * across);
+            uint32_t result = rgba & 0xFF;
+            for (int shift = 8; shift <= 24; shift += 8) {
+                const float channel = static_cast<float>((rgba >> shift) & 0xFF) * shade;
+                result |= static_cast<uint32_t>(std::clamp(channel + 0.5f, 0.0f, 255.0f)) << shift;
             }
-            if (e2 < dx) {
-                err += dx;
-                y += sy;
+            return result;
+        }
+        
+        static uint32_t hash(uint32_t x) noexcept {
+            x ^= x >> 16;
+            x *= 0x7FEB352Du;
+            x ^= x >> 15;
+            x *= 0x846CA68Bu;
+            return x ^ (x >> 16);
+        }
+        
+        // Hash bits to [-1, 1)
+        static float signed_unit(uint32_t bits) noexcept {
+            return static_cast<float>(bits >> 8) * (2.0f / 16777216.0f) - 1.0f;
+        }
+    };
+    
+    // Draw one branch as a filled capsule
+    template<typename PixelType>
+    void draw_branch(const RasterTarget<PixelType>& target, const Branch& branch, const Style& style) const {
+        if (style.smooth) {
+            const float radius = std::max(0.5f, branch.thickness * 0.5f);
+            const uint32_t rgba = branch.color.to_rgba();
+            if (!style.textured()) {
+                SpanRasterizer::blend_capsule(target, branch.start_point, branch.end_point, radius, FlatPaint{rgba});
+                return;
             }
+            const uint32_t salt = BarkPaint::hash(static_cast<uint32_t>(std::lround(branch.start_point.x)) * 73856093u ^
+                                                  static_cast<uint32_t>(std::lround(branch.start_point.y)) * 19349663u);
+            SpanRasterizer::blend_capsule(target, branch.start_point, branch.end_point, radius,
+                                          BarkPaint{rgba, style.bark_noise, style.bark_detail,
+                                                    std::max(2.0f, std::round(radius)), salt});
+            return;
         }
+        Raster::fill_capsule(target,
+                             branch.start_point,
+                             branch.end_point,
+                             branch_radius(branch.thickness),
+                             PixelTraits<PixelType>::from_rgba(branch.color.to_rgba()));
+    }
+    
+    // Stroke half-width for a branch; matches the rounded-up half thickness of
+    // the previous line drawer, with hairlines still one pixel wide
+    static float branch_radius(float thickness) noexcept {
+        return std::max(0.5f, std::ceil(thickness * 0.5f));
+    }
+    
+    // Draw a leaf cluster as span-filled shapes
+    template<typename PixelType>
+    void draw_leaf_cluster(const RasterTarget<PixelType>& target, const LeafCluster& cluster,
+                           const Style& style) const {
+        draw_leaf_shape(target, cluster.position, cluster.size, cluster.color, cluster.shape,
+                        std::span<const Point2Df>(cluster.leaf_positions), style);
     }
     
-    // Draw a leaf cluster as filled circles
-    void draw_leaf_cluster(PixelBuffer32& buffer, const LeafCluster& cluster) const {
-        const int center_x = static_cast<int>(std::round(cluster.position.x));
-        const int center_y = static_cast<int>(std::round(cluster.position.y));
-        const int radius = static_cast<int>(std::ceil(cluster.size));
+    template<typename PixelType>
+    void draw_leaf_shape(const RasterTarget<PixelType>& target, Point2Df position, float size, Color shape_color,
+                         LeafCluster::Shape shape, std::span<const Point2Df> leaf_positions,
+                         const Style& style) const {
+        if (style.smooth) {
+            draw_smooth_leaf_shape(target, position, size, shape_color.to_rgba(), shape, leaf_positions);
+            return;
+        }
+        
+        const Point2Df center{std::round(position.x), std::round(position.y)};
+        const float radius = std::ceil(size);
+        const PixelType color = PixelTraits<PixelType>::from_rgba(shape_color.to_rgba());
         
-        const uint32_t color = cluster.color.to_rgba();
+        // Spiky and Scattered clusters are drawn from their individual leaves
+        const bool has_leaves = !leaf_positions.empty();
         
-        // Draw filled circle using midpoint circle algorithm
-        for (int y = -radius; y <= radius; ++y) {
-            for (int x = -radius; x <= radius; ++x) {
-                if (x * x + y * y <= radius * radius) {
-                    const int pixel_x = center_x + x;
-                    const int pixel_y = center_y + y;
-                    
-                    if (buffer.contains(pixel_x, pixel_y)) {
-                        buffer(pixel_x, pixel_y) = color;
+        switch (shape) {
+            case LeafCluster::Shape::Ellipse:
+                Raster::fill_ellipse(target, center, radius * 1.5f, radius, color);
+                break;
+                
+            case LeafCluster::Shape::Spiky:
+                if (has_leaves) {
+                    // Dense core with a needle out to every leaf
+                    Raster::fill_disc(target, center, radius * 0.6f, color);
+                    for (const auto& leaf : leaf_positions) {
+                        Raster::fill_capsule(target, center, leaf, 0.5f, color);
                     }
+                    break;
                 }
-            }
+                Raster::fill_disc(target, center, radius, color);
+                break;
+                
+            case LeafCluster::Shape::Scattered:
+                if (has_leaves) {
+                    const float leaf_radius = std::max(1.0f, std::round(radius * 0.3f));
+                    for (const auto& leaf : leaf_positions) {
+                        Raster::fill_disc(target, Point2Df{std::round(leaf.x), std::round(leaf.y)},
+                                          leaf_radius, color);
+                    }
+                    break;
+                }
+                Raster::fill_disc(target, center, radius, color);
+                break;
+                
+            case LeafCluster::Shape::Circle:
+            default:
+                Raster::fill_disc(target, center, radius, color);
+                break;
+        }
+    }
+    
+    // The same shapes at their exact position and size, anti-aliased
+    template<typename PixelType>
+    void draw_smooth_leaf_shape(const RasterTarget<PixelType>& target, Point2Df center, float radius, uint32_t rgba,
+                                LeafCluster::Shape shape, std::span<const Point2Df> leaf_positions) const {
+        const bool has_leaves = !leaf_positions.empty();
+        
+        switch (shape) {
+            case LeafCluster::Shape::Ellipse:
+                SpanRasterizer::blend_ellipse(target, center, radius * 1.5f, radius, rgba);
+                break;
+                
+            case LeafCluster::Shape::Spiky:
+                if (has_leaves) {
+                    SpanRasterizer::blend_disc(target, center, radius * 0.6f, rgba);
+                    for (const auto& leaf : leaf_positions) {
+                        SpanRasterizer::blend_capsule(target, center, leaf, 0.5f, FlatPaint{rgba});
+                    }
+                    break;
+                }
+                SpanRasterizer::blend_disc(target, center, radius, rgba);
+                break;
+                
+            case LeafCluster::Shape::Scattered:
+                if (has_leaves) {
+                    const float leaf_radius = std::max(1.0f, radius * 0.3f);
+                    for (const auto& leaf : leaf_positions) {
+                        SpanRasterizer::blend_disc(target, leaf, leaf_radius, rgba);
+                    }
+                    break;
+                }
+                SpanRasterizer::blend_disc(target, center, radius, rgba);
+                break;
+                
+            case LeafCluster::Shape::Circle:
+            default:
+                SpanRasterizer::blend_disc(target, center, radius, rgba);
+                break;
         }
     }
 };
 
+using TreeRenderer = BasicTreeRenderer<FloatGeometry>;
+using FixedTreeRenderer = BasicTreeRenderer<FixedGeometry>;
+
 } // namespace pixeltree
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+#include "tree_structure.hpp"
+#include "simd_utils.hpp"
+#include <vector>
+
+namespace pixeltree {
+
+// Structure-of-arrays copy of TreeStructure::branches
+//
+// Each attribute is a separate contiguous array, so whole-tree passes such as
+// bounding boxes and depth statistics become SIMD reductions instead of a
+// strided walk over Branch records.
+struct BranchSoA {
+    std::vector<float> start_x, start_y;
+    std::vector<float> end_x, end_y;
+    std::vector<float> thickness;
+    std::vector<int32_t> depth;
+    std::vector<uint32_t> color;          // Packed RGBA
+    
+    size_t size() const noexcept { return thickness.size(); }
+    bool empty() const noexcept { return thickness.empty(); }
+    
+    void clear() noexcept {
+        start_x.clear(); start_y.clear();
+        end_x.clear(); end_y.clear();
+        thickness.clear();
+        depth.clear();
+        color.clear();
+    }
+    
+    void reserve(size_t count) {
+        start_x.reserve(count); start_y.reserve(count);
+        end_x.reserve(count); end_y.reserve(count);
+        thickness.reserve(count);
+        depth.reserve(count);
+        color.reserve(count);
+    }
+    
+    void push_back(const Branch& branch) {
+        start_x.push_back(branch.start_point.x);
+        start_y.push_back(branch.start_point.y);
+        end_x.push_back(branch.end_point.x);
+        end_y.push_back(branch.end_point.y);
+        thickness.push_back(branch.thickness);
+        depth.push_back(branch.depth_level);
+        color.push_back(branch.color.to_rgba());
+    }
+};
+
+// Structure-of-arrays copy of TreeStructure::leaf_clusters
+struct LeafClusterSoA {
+    std::vector<float> x, y;
+    std::vector<float> size;
+    std::vector<float> reach;             // LeafCluster::reach, the bounding radius
+    std::vector<uint32_t> color;          // Packed RGBA
+    std::vector<LeafCluster::Shape> shape;
+    
+    size_t count() const noexcept { return size.size(); }
+    bool empty() const noexcept { return size.empty(); }
+    
+    void clear() noexcept {
+        x.clear(); y.clear();
+        size.clear();
+        reach.clear();
+        color.clear();
+        shape.clear();
+    }
+    
+    void reserve(size_t count) {
+        x.reserve(count); y.reserve(count);
+        size.reserve(count);
+        reach.reserve(count);
+        color.reserve(count);
+        shape.reserve(count);
+    }
+    
+    void push_back(const LeafCluster& cluster) {
+        x.push_back(cluster.position.x);
+        y.push_back(cluster.position.y);
+        size.push_back(cluster.size);
+        reach.push_back(cluster.reach());
+        color.push_back(cluster.color.to_rgba());
+        shape.push_back(cluster.shape);
+    }
+};
+
+// Optional SoA view of a whole tree, rebuilt on demand from a TreeStructure
+struct TreeSoA {
+    BranchSoA branches;
+    LeafClusterSoA leaves;
+    
+    TreeSoA() = default;
+    template<size_t Capacity>
+    explicit TreeSoA(const BasicTreeStructure<Capacity>& tree) { assign(tree); }
+    
+    // Refill from a tree, reusing the existing array storage
+    template<size_t Capacity>
+    void assign(const BasicTreeStructure<Capacity>& tree) {
+        branches.clear();
+        branches.reserve(tree.branches.size());
+        for (const auto& branch : tree.branches) {
+            branches.push_back(branch);
+        }
+        
+        leaves.clear();
+        leaves.reserve(tree.leaf_clusters.size());
+        for (const auto& cluster : tree.leaf_clusters) {
+            leaves.push_back(cluster);
+        }
+    }
+    
+    // Same result as TreeStructure::calculate_bounding_box
+    Rect2Df bounding_box() const {
+        if (branches.empty()) {
+            return Rect2Df{{0, 0}, {0, 0}};
+        }
+        
+        simd::Bounds bounds = simd::GeometryOperations::segment_bounds(
+            branches.start_x.data(), branches.start_y.data(),
+            branches.end_x.data(), branches.end_y.data(),
+            branches.thickness.data(), branches.size());
+        
+        if (!leaves.empty()) {
+            bounds.merge(simd::GeometryOperations::circle_bounds(
+                leaves.x.data(), leaves.y.data(), leaves.reach.data(), leaves.count()));
+        }
+        
+        return Rect2Df{{bounds.min_x, bounds.min_y}, {bounds.max_x, bounds.max_y}};
+    }
+    
+    // Same result as TreeStructure::max_depth
+    int max_depth() const {
+        return std::max(0, simd::GeometryOperations::max_value(
+            branches.depth.data(), branches.size()));
+    }
+};
+
+} // namespace pixeltree
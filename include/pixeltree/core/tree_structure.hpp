@@ -2,21 +2,27 @@
 #include "math_types.hpp"
 #include "tree_parameters.hpp"
 #include "random.hpp"
+#include "fixed_vector.hpp"
+#include <type_traits>
 #include <vector>
-#include <memory>
+#include <limits>
 #include <optional>
 
 namespace pixeltree {
 
-// Forward declarations
-struct Branch;
-struct LeafCluster;
-
 // Branch node in the tree structure
+//
+// Branches live in one flat TreeStructure::branches array and refer to each
+// other by index. A parent always precedes its children, so a linear pass over
+// the array visits the tree in creation (depth-first) order.
 struct Branch {
-    // Hierarchy
-    std::shared_ptr<Branch> parent;
-    std::vector<std::shared_ptr<Branch>> children;
+    // Sentinel index for a missing link
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+    
+    // Hierarchy (indices into TreeStructure::branches)
+    uint32_t parent = npos;
+    uint32_t first_child = npos;
+    uint32_t next_sibling = npos;
     
     // Geometry
     Point2Df start_point;
@@ -53,18 +59,7 @@ struct Branch {
     
     // Check if this is a leaf branch (no children)
     bool is_leaf() const noexcept {
-        return children.empty();
-    }
-    
-    // Get all leaf branches in this subtree
-    void get_leaf_branches(std::vector<std::shared_ptr<Branch>>& leaves) const {
-        if (is_leaf()) {
-            leaves.push_back(std::const_pointer_cast<Branch>(shared_from_this()));
-        } else {
-            for (const auto& child : children) {
-                child->get_leaf_branches(leaves);
-            }
-        }
+        return first_child == npos;
     }
     
     // Calculate bounding box of this branch
@@ -77,24 +72,20 @@ struct Branch {
              std::max(start_point.y, end_point.y) + half_thickness}
         };
     }
-    
-private:
-    // Enable shared_from_this
-    std::shared_ptr<Branch> shared_from_this() const {
-        return std::const_pointer_cast<Branch>(
-            std::static_pointer_cast<const Branch>(
-                std::enable_shared_from_this<Branch>::shared_from_this()
-            )
-        );
-    }
 };
 
 // Leaf cluster attached to branch endpoints
+//
+// Leaf positions are stored inline, so clusters never allocate: the generator
+// scatters 4 + 1.5 * size leaves, and cluster sizes stay below twice the
+// largest LeafParameters::size_base.
 struct LeafCluster {
+    static constexpr size_t max_leaves = 4 + static_cast<size_t>(BoundedFloat10::max_value() * 2.0f * 1.5f);
+    
     Point2Df position;
     float size;
     Color color;
-    std::vector<Point2Df> leaf_positions;  // Individual leaf positions
+    FixedVector<Point2Df, max_leaves> leaf_positions;  // Individual leaf positions
     
     // Shape information
     enum class Shape {
@@ -108,10 +99,10 @@ struct LeafCluster {
     LeafCluster(Point2Df pos, float sz, Color col) 
         : position(pos), size(sz), color(col) {}
     
-    // Generate leaf positions based on shape
+    // Generate leaf positions based on shape (more than max_leaves throws std::length_error)
     void generate_leaves(Random& rng, int leaf_count) {
         leaf_positions.clear();
-        leaf_positions.reserve(leaf_count);
+        leaf_positions.reserve(static_cast<size_t>(leaf_count));
         
         for (int i = 0; i < leaf_count; ++i) {
             Point2Df leaf_pos;
@@ -138,20 +129,50 @@ struct LeafCluster {
         }
     }
     
+    // Largest distance from `position` the drawn shape can cover
+    float reach() const noexcept {
+        return reach(shape, size);
+    }
+    
+    static float reach(Shape shape, float size) noexcept {
+        switch (shape) {
+            case Shape::Ellipse:
+                return size * 1.5f;
+            case Shape::Spiky:
+            case Shape::Scattered:
+                return size * 2.0f;  // Leaves spread to 1.5x size, plus their own width
+            case Shape::Circle:
+            default:
+                return size;
+        }
+    }
+    
     // Calculate bounding box
     Rect2Df bounding_box() const noexcept {
+        const float r = reach();
         return Rect2Df{
-            {position.x - size, position.y - size},
-            {position.x + size, position.y + size}
+            {position.x - r, position.y - r},
+            {position.x + r, position.y + r}
         };
     }
 };
 
 // Complete tree structure
-struct TreeStructure {
-    std::shared_ptr<Branch> root;
-    std::vector<std::shared_ptr<Branch>> all_branches;
-    std::vector<LeafCluster> leaf_clusters;
+//
+// FixedCapacity == 0 stores branches and leaf clusters in std::vector. A
+// non-zero capacity keeps them inline in the structure (see FixedVector), for
+// branch-budgeted generation that should not touch the heap.
+template<size_t FixedCapacity = 0>
+struct BasicTreeStructure {
+    template<typename T>
+    using Storage = std::conditional_t<FixedCapacity == 0,
+                                       std::vector<T>,
+                                       FixedVector<T, (FixedCapacity == 0 ? 1 : FixedCapacity)>>;
+    
+    static constexpr size_t fixed_capacity = FixedCapacity;
+    
+    Storage<Branch> branches;               // Flat branch store, branches[0] is the root
+    Storage<LeafCluster> leaf_clusters;
     
     // Tree metadata
     TreeParameters parameters;
@@ -159,22 +180,73 @@ struct TreeStructure {
     uint32_t generation_id;
     
     // Constructor
-    explicit TreeStructure(const TreeParameters& params) 
+    explicit BasicTreeStructure(const TreeParameters& params) 
         : parameters(params), generation_id(0) {}
     
+    // Drop all branches and leaves but keep their storage, so a generator can
+    // reuse one structure as an arena across trees without reallocating
+    void reset(const TreeParameters& params) {
+        branches.clear();
+        leaf_clusters.clear();
+        parameters = params;
+        bounding_box = Rect2Df{};
+        generation_id = 0;
+    }
+    
+    // Append a branch as the last child of `parent` (Branch::npos for the root)
+    uint32_t add_branch(const Branch& branch, uint32_t parent = Branch::npos) {
+        const auto index = static_cast<uint32_t>(branches.size());
+        branches.push_back(branch);
+        
+        Branch& added = branches.back();
+        added.parent = parent;
+        added.first_child = Branch::npos;
+        added.next_sibling = Branch::npos;
+        
+        if (parent != Branch::npos) {
+            uint32_t* link = &branches[parent].first_child;
+            while (*link != Branch::npos) {
+                link = &branches[*link].next_sibling;
+            }
+            *link = index;
+        }
+        
+        return index;
+    }
+    
+    // Move every branch and leaf cluster by offset
+    void translate(Point2Df offset) noexcept {
+        for (auto& branch : branches) {
+            branch.start_point = branch.start_point + offset;
+            branch.end_point = branch.end_point + offset;
+        }
+        for (auto& cluster : leaf_clusters) {
+            cluster.position = cluster.position + offset;
+            for (auto& leaf : cluster.leaf_positions) {
+                leaf = leaf + offset;
+            }
+        }
+        bounding_box = Rect2Df{bounding_box.min + offset, bounding_box.max + offset};
+    }
+    
+    // Root branch, or nullptr for an empty tree
+    const Branch* root() const noexcept {
+        return branches.empty() ? nullptr : &branches.front();
+    }
+    
     // Calculate overall bounding box
     void calculate_bounding_box() {
-        if (all_branches.empty()) {
+        if (branches.empty()) {
             bounding_box = Rect2Df{{0, 0}, {0, 0}};
             return;
         }
         
         // Start with first branch
-        bounding_box = all_branches[0]->bounding_box();
+        bounding_box = branches[0].bounding_box();
         
         // Expand for all branches
-        for (const auto& branch : all_branches) {
-            const auto branch_box = branch->bounding_box();
+        for (const auto& branch : branches) {
+            const auto branch_box = branch.bounding_box();
             bounding_box.min.x = std::min(bounding_box.min.x, branch_box.min.x);
             bounding_box.min.y = std::min(bounding_box.min.y, branch_box.min.y);
             bounding_box.max.x = std::max(bounding_box.max.x, branch_box.max.x);
@@ -191,25 +263,29 @@ struct TreeStructure {
         }
     }
     
-    // Get all leaf branches
-    std::vector<std::shared_ptr<Branch>> get_leaf_branches() const {
-        std::vector<std::shared_ptr<Branch>> leaves;
-        if (root) {
-            root->get_leaf_branches(leaves);
+    // Indices of all leaf branches, in depth-first order
+    std::vector<uint32_t> get_leaf_branches() const {
+        std::vector<uint32_t> leaves;
+        for (uint32_t i = 0; i < branches.size(); ++i) {
+            if (branches[i].is_leaf()) {
+                leaves.push_back(i);
+            }
         }
         return leaves;
     }
     
     // Statistics
-    size_t branch_count() const noexcept { return all_branches.size(); }
+    size_t branch_count() const noexcept { return branches.size(); }
     size_t leaf_cluster_count() const noexcept { return leaf_clusters.size(); }
     int max_depth() const noexcept {
         int max_d = 0;
-        for (const auto& branch : all_branches) {
-            max_d = std::max(max_d, branch->depth_level);
+        for (const auto& branch : branches) {
+            max_d = std::max(max_d, branch.depth_level);
         }
         return max_d;
     }
 };
 
+using TreeStructure = BasicTreeStructure<>;
+
 } // namespace pixeltree
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace pixeltree {
+
+struct SinCos {
+    float sin, cos;
+};
+
+// Polynomial sine/cosine in float
+//
+// Range reduction to [-pi/4, pi/4] followed by the Cephes minimax
+// polynomials (about 1 ulp). Only IEEE add/multiply/floor are used, so
+// results are bit-identical on every compiler and platform as long as FMA
+// contraction is off (the build passes -ffp-contract=off), unlike libm
+// sin/cos whose last bits vary between implementations.
+class Trig {
+public:
+    static constexpr float pi = 3.14159265358979323846f;
+    static constexpr float degrees_to_radians = pi / 180.0f;
+    
+    // Angle in degrees; quarter turns are reduced exactly
+    static SinCos sincos_degrees(float degrees) noexcept {
+        const float quadrant = std::floor(degrees * (1.0f / 90.0f) + 0.5f);
+        const float x = (degrees - quadrant * 90.0f) * degrees_to_radians;
+        return from_quadrant(static_cast<int32_t>(quadrant), x);
+    }
+    
+    // Angle in radians; three-part Cody-Waite split of pi/2
+    static SinCos sincos(float radians) noexcept {
+        const float quadrant = std::floor(radians * (2.0f / pi) + 0.5f);
+        float x = radians - quadrant * 1.5703125f;
+        x -= quadrant * 4.837512969970703125e-4f;
+        x -= quadrant * 7.54978995489188216e-8f;
+        return from_quadrant(static_cast<int32_t>(quadrant), x);
+    }
+    
+    // Batched form for vectorized consumers; same values as the scalar calls
+    static void sincos_degrees(const float* degrees, float* sin_out, float* cos_out, size_t count) noexcept {
+        for (size_t i = 0; i < count; ++i) {
+            const SinCos sc = sincos_degrees(degrees[i]);
+            sin_out[i] = sc.sin;
+            cos_out[i] = sc.cos;
+        }
+    }
+
+private:
+    static SinCos from_quadrant(int32_t quadrant, float x) noexcept {
+        const float z = x * x;
+        const float s = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * x + x;
+        const float c = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z
+                        - 0.5f * z + 1.0f;
+        
+        switch (quadrant & 3) {
+            case 0:  return {s, c};
+            case 1:  return {c, -s};
+            case 2:  return {-s, -c};
+            default: return {-c, s};
+        }
+    }
+};
+
+} // namespace pixeltree
@@ -0,0 +1,295 @@
+#pragma once
+#include "tree_structure.hpp"
+#include "tree_renderer.hpp"
+#include "tiled_renderer.hpp"
+#include "trig.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace pixeltree {
+
+// Sway of a wind animation; its strength and direction come from
+// TreeParameters::wind_strength and wind_direction
+struct WindOptions {
+    size_t frame_count = 8;     // Frames of one seamlessly looping sway cycle
+    float max_bend = 0.15f;     // Peak bend in radians per branch, at full strength and depth
+    float lean = 0.5f;          // Steady bend downwind, as a fraction of the sway
+    float phase_lag = 0.6f;     // Radians each depth level trails its parent, so tips follow through
+    int tile_size = 16;         // Dirty-region granularity in pixels
+};
+
+// Frames side by side in one preallocated buffer
+template<typename PixelType = uint32_t>
+struct FrameStrip {
+    PixelBuffer<PixelType> pixels;      // frame_count * frame_width x frame_height
+    int frame_width = 0;
+    int frame_height = 0;
+    size_t frame_count = 0;
+    std::vector<size_t> tiles_redrawn;  // Per frame: tiles rasterized (frame 0 is drawn whole)
+    
+    // Frame `index` as a surface in canvas coordinates
+    RasterTarget<PixelType> frame(size_t index) {
+        RasterTarget<PixelType> target;
+        target.pixels = pixels.data() + index * static_cast<size_t>(frame_width);
+        target.stride = pixels.width();
+        target.clip = Rect2Di{{0, 0}, {frame_width, frame_height}};
+        return target;
+    }
+    
+    // Frame pixels inside the strip (max exclusive)
+    Rect2Di frame_rect(size_t index) const noexcept {
+        const int x = static_cast<int>(index) * frame_width;
+        return Rect2Di{{x, 0}, {x + frame_width, frame_height}};
+    }
+};
+
+// Wind animation of one tree structure
+//
+// Each frame bends every branch about its start point, accumulated from the
+// root outward, so child branches ride on their parents' motion; the trunk
+// (depth 0) stays put and deeper branches bend more and lag behind. Leaf
+// clusters move with the branch they hang from.
+//
+// Frames are rendered incrementally: frame 0 is drawn whole, each later frame
+// starts as a copy of the previous one and only the tiles touched by a
+// primitive that moved (at its old or new position) are cleared and redrawn
+// from the primitives binned to them. Every frame is byte-identical to a full
+// render of pose() at its phase. Geometry picks the rasterizer as for
+// BasicTreeRenderer; poses are float with either.
+template<typename PixelType = uint32_t, typename Geometry = FloatGeometry>
+class WindAnimator {
+    BasicTreeRenderer<Geometry> renderer_;
+    WindOptions options_;
+
+public:
+    explicit WindAnimator(const WindOptions& options = {}) : options_(options) {}
+    
+    const WindOptions& options() const noexcept { return options_; }
+    
+    // Phase of frame `index`, in radians of the sway cycle
+    float frame_phase(size_t index) const noexcept {
+        return 2.0f * Trig::pi * static_cast<float>(index) / static_cast<float>(std::max<size_t>(1, options_.frame_count));
+    }
+    
+    template<size_t Capacity>
+    FrameStrip<PixelType> animate(const BasicTreeStructure<Capacity>& tree) const {
+        FrameStrip<PixelType> strip;
+        animate_into(tree, strip);
+        return strip;
+    }
+    
+    // Render all frames into `strip`, reusing its storage when large enough
+    template<size_t Capacity>
+    void animate_into(const BasicTreeStructure<Capacity>& tree, FrameStrip<PixelType>& strip) const {
+        const int width = tree.parameters.canvas_width.get();
+        const int height = tree.parameters.canvas_height.get();
+        strip.frame_width = width;
+        strip.frame_height = height;
+        strip.frame_count = options_.frame_count;
+        strip.pixels.reset(static_cast<size_t>(width) * options_.frame_count, static_cast<size_t>(height));
+        strip.tiles_redrawn.assign(options_.frame_count, 0);
+        if (options_.frame_count == 0) {
+            return;
+        }
+        
+        const std::vector<uint32_t> anchors = cluster_anchors(tree);
+        const int tile_size = std::max(1, options_.tile_size);
+        const PixelType background = PixelTraits<PixelType>::from_rgba(0x00000000);
+        
+        // Poses and bins of the previous and the current frame, swapped per frame
+        TreeStructure previous{tree.parameters}, current{tree.parameters};
+        PrimitiveBins previous_bins, current_bins;
+        std::vector<uint8_t> dirty;
+        
+        pose(tree, anchors, frame_phase(0), previous);
+        previous_bins.build(previous, width, height, tile_size, tile_size);
+        const RasterTarget<PixelType> first = strip.frame(0);
+        for (int y = 0; y < height; ++y) {
+            std::fill_n(first.row(y), static_cast<size_t>(width), background);
+        }
+        renderer_.render_into(first, previous);
+        strip.tiles_redrawn[0] = previous_bins.cell_count();
+        
+        for (size_t index = 1; index < options_.frame_count; ++index) {
+            pose(tree, anchors, frame_phase(index), current);
+            current_bins.build(current, width, height, tile_size, tile_size);
+            
+            const RasterTarget<PixelType> source = strip.frame(index - 1);
+            const RasterTarget<PixelType> target = strip.frame(index);
+            for (int y = 0; y < height; ++y) {
+                std::memcpy(target.row(y), source.row(y), static_cast<size_t>(width) * sizeof(PixelType));
+            }
+            
+            mark_moved(previous, current, current_bins, tile_size, dirty);
+            for (size_t cell = 0; cell < dirty.size(); ++cell) {
+                if (!dirty[cell]) {
+                    continue;
+                }
+                const Rect2Di rect = current_bins.cell_rect(cell);
+                for (int y = rect.min.y; y < rect.max.y; ++y) {
+                    std::fill_n(target.row(y) + rect.min.x, static_cast<size_t>(rect.width()), background);
+                }
+                renderer_.render_primitives(target.clipped(rect), current,
+                                            current_bins.branches(cell), current_bins.branch_count(cell),
+                                            current_bins.clusters(cell), current_bins.cluster_count(cell));
+                ++strip.tiles_redrawn[index];
+            }
+            
+            std::swap(previous, current);
+            std::swap(previous_bins, current_bins);
+        }
+    }
+    
+    // The tree as bent at `phase` (see frame_phase), written into `posed`
+    template<size_t Capacity, size_t PosedCapacity>
+    void pose(const BasicTreeStructure<Capacity>& tree, float phase, BasicTreeStructure<PosedCapacity>& posed) const {
+        pose(tree, cluster_anchors(tree), phase, posed);
+    }
+
+private:
+    // Rigid transform p -> R(angle) p + offset
+    struct Transform {
+        float angle = 0.0f;
+        SinCos rotation{0.0f, 1.0f};
+        Point2Df offset;
+        
+        Point2Df apply(Point2Df p) const noexcept {
+            return Point2Df{rotation.cos * p.x - rotation.sin * p.y + offset.x,
+                            rotation.sin * p.x + rotation.cos * p.y + offset.y};
+        }
+    };
+    
+    // Branch each leaf cluster hangs from: the one ending at its position, or
+    // the nearest branch end for clusters not placed by the generator
+    template<size_t Capacity>
+    static std::vector<uint32_t> cluster_anchors(const BasicTreeStructure<Capacity>& tree) {
+        std::vector<uint32_t> anchors(tree.leaf_clusters.size(), Branch::npos);
+        for (size_t c = 0; c < tree.leaf_clusters.size(); ++c) {
+            const Point2Df position = tree.leaf_clusters[c].position;
+            float best = std::numeric_limits<float>::max();
+            for (uint32_t b = 0; b < tree.branches.size() && best > 0.0f; ++b) {
+                const Point2Df delta = tree.branches[b].end_point - position;
+                const float distance = delta.x * delta.x + delta.y * delta.y;
+                if (distance < best) {
+                    best = distance;
+                    anchors[c] = b;
+                }
+            }
+        }
+        return anchors;
+    }
+    
+    template<size_t Capacity, size_t PosedCapacity>
+    void pose(const BasicTreeStructure<Capacity>& tree, const std::vector<uint32_t>& anchors, float phase,
+              BasicTreeStructure<PosedCapacity>& posed) const {
+        // Copy every primitive, then move its points; assigning over the
+        // existing elements keeps the posed storage, leaf vectors included
+        assign_elements(tree.branches, posed.branches);
+        assign_elements(tree.leaf_clusters, posed.leaf_clusters);
+        posed.parameters = tree.parameters;
+        posed.generation_id = tree.generation_id;
+        
+        // Horizontal push; positive angles turn upward branches to +x (y points down)
+        const float push = tree.parameters.wind_strength.get() *
+                           Trig::sincos_degrees(tree.parameters.wind_direction.get()).cos;
+        const float depth_scale = 1.0f / static_cast<float>(std::max(1, tree.max_depth()));
+        
+        std::vector<Transform> transforms(tree.branches.size());
+        for (uint32_t index = 0; index < tree.branches.size(); ++index) {
+            const Branch& branch = tree.branches[index];
+            const Transform parent = branch.parent == Branch::npos ? Transform{} : transforms[branch.parent];
+            const float depth = static_cast<float>(branch.depth_level);
+            const float sway = Trig::sincos(phase - depth * options_.phase_lag).sin;
+            const float bend = push * options_.max_bend * depth * depth_scale * (options_.lean + sway);
+            
+            // Rotate about the branch start, then follow the parent
+            Transform& transform = transforms[index];
+            transform.angle = parent.angle + bend;
+            transform.rotation = Trig::sincos(transform.angle);
+            const Point2Df pivot = parent.apply(branch.start_point);
+            transform.offset = pivot - Point2Df{transform.rotation.cos * branch.start_point.x -
+                                                transform.rotation.sin * branch.start_point.y,
+                                                transform.rotation.sin * branch.start_point.x +
+                                                transform.rotation.cos * branch.start_point.y};
+            
+            Branch& bent = posed.branches[index];
+            bent.start_point = pivot;
+            bent.end_point = transform.apply(branch.end_point);
+        }
+        
+        for (size_t c = 0; c < tree.leaf_clusters.size(); ++c) {
+            const LeafCluster& cluster = tree.leaf_clusters[c];
+            LeafCluster& moved = posed.leaf_clusters[c];
+            const Transform transform = anchors[c] == Branch::npos ? Transform{} : transforms[anchors[c]];
+            moved.position = transform.apply(cluster.position);
+            for (size_t leaf = 0; leaf < cluster.leaf_positions.size(); ++leaf) {
+                moved.leaf_positions[leaf] = transform.apply(cluster.leaf_positions[leaf]);
+            }
+        }
+        
+        posed.calculate_bounding_box();
+    }
+    
+    template<typename Source, typename Target>
+    static void assign_elements(const Source& source, Target& target) {
+        while (target.size() > source.size()) {
+            target.pop_back();
+        }
+        for (size_t i = 0; i < target.size(); ++i) {
+            target[i] = source[i];
+        }
+        for (size_t i = target.size(); i < source.size(); ++i) {
+            target.push_back(source[i]);
+        }
+    }
+    
+    // Flag the cells covered, before or after, by a primitive that moved
+    template<size_t Capacity>
+    static void mark_moved(const BasicTreeStructure<Capacity>& before, const BasicTreeStructure<Capacity>& after,
+                           const PrimitiveBins& bins, int tile_size, std::vector<uint8_t>& dirty) {
+        dirty.assign(bins.cell_count(), 0);
+        auto mark = [&](const Rect2Di& bounds) {
+            if (bounds.max.x <= 0 || bounds.max.y <= 0) {
+                return;
+            }
+            const int col0 = std::max(0, bounds.min.x) / tile_size;
+            const int row0 = std::max(0, bounds.min.y) / tile_size;
+            const int col1 = std::min(bins.columns() - 1, (bounds.max.x - 1) / tile_size);
+            const int row1 = std::min(bins.rows() - 1, (bounds.max.y - 1) / tile_size);
+            for (int row = row0; row <= row1; ++row) {
+                for (int column = col0; column <= col1; ++column) {
+                    dirty[static_cast<size_t>(row) * static_cast<size_t>(bins.columns()) + static_cast<size_t>(column)] = 1;
+                }
+            }
+        };
+        
+        for (size_t i = 0; i < after.branches.size(); ++i) {
+            const Branch& old_branch = before.branches[i];
+            const Branch& new_branch = after.branches[i];
+            if (!same(old_branch.start_point, new_branch.start_point) || !same(old_branch.end_point, new_branch.end_point)) {
+                mark(TreeRenderer::branch_bounds(old_branch));
+                mark(TreeRenderer::branch_bounds(new_branch));
+            }
+        }
+        for (size_t i = 0; i < after.leaf_clusters.size(); ++i) {
+            const LeafCluster& old_cluster = before.leaf_clusters[i];
+            const LeafCluster& new_cluster = after.leaf_clusters[i];
+            bool moved = !same(old_cluster.position, new_cluster.position);
+            for (size_t leaf = 0; !moved && leaf < new_cluster.leaf_positions.size(); ++leaf) {
+                moved = !same(old_cluster.leaf_positions[leaf], new_cluster.leaf_positions[leaf]);
+            }
+            if (moved) {
+                mark(TreeRenderer::cluster_bounds(old_cluster));
+                mark(TreeRenderer::cluster_bounds(new_cluster));
+            }
+        }
+    }
+    
+    static bool same(Point2Df a, Point2Df b) noexcept {
+        return a.x == b.x && a.y == b.y;
+    }
+};
+
+} // namespace pixeltree
@@ -7,9 +7,23 @@
 #include "core/math_types.hpp"
 #include "core/tree_parameters.hpp"
 #include "core/tree_structure.hpp"
+#include "core/tree_soa.hpp"
+#include "core/tree_archive.hpp"
 #include "core/pixel_buffer.hpp"
+#include "core/pixel_format.hpp"
 #include "core/tree_generator.hpp"
+#include "core/generator_service.hpp"
+#include "core/tiled_renderer.hpp"
+#include "core/atlas.hpp"
+#include "core/lod.hpp"
+#include "core/wind.hpp"
+#include "core/image_export.hpp"
+#include "core/structure_cache.hpp"
+#include "core/seed_search.hpp"
+#include "core/instrumentation.hpp"
 #include "core/random.hpp"
+#include "core/trig.hpp"
+#include "core/fixed_point.hpp"
 
 // Export functionality
 namespace pixeltree {
@@ -37,12 +51,13 @@ constexpr bool has_openmp_support() noexcept {
 #endif
 }
 
-constexpr bool has_simd_support() noexcept {
-#if defined(PIXELTREE_HAS_SSE2) || defined(PIXELTREE_HAS_AVX2)
-    return true;
-#else
-    return false;
-#endif
+// SIMD kernels selected for the running CPU
+inline simd::SimdLevel simd_level() noexcept {
+    return simd::PixelOperations::active_level();
+}
+
+inline bool has_simd_support() noexcept {
+    return simd_level() != simd::SimdLevel::Scalar;
 }
 
 // Quick generation functions for ease of use
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+# scripts/compare_benchmarks.py
+#
+# Compare a Google Benchmark JSON run against a baseline recorded on the same
+# machine (see run_benchmarks.sh; baselines are not committed).
+#
+#   compare_benchmarks.py BASELINE.json CURRENT.json [--threshold 0.15] [--filter REGEX]
+#
+# Uses the median aggregate when the runs have repetitions, the plain result
+# otherwise. Exits with status 1 if any benchmark is slower than the baseline
+# by more than the threshold (a fraction, 0.15 = 15%).
+
+import argparse
+import json
+import re
+import sys
+
+
+def load_times(path):
+    with open(path) as f:
+        data = json.load(f)
+
+    plain, medians = {}, {}
+    for bench in data.get("benchmarks", []):
+        name = bench.get("run_name", bench["name"])
+        if bench.get("run_type") == "aggregate":
+            if bench.get("aggregate_name") == "median":
+                medians[name] = bench["real_time"]
+        else:
+            plain.setdefault(name, bench["real_time"])
+    return medians or plain
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare benchmark JSON against a baseline")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.15,
+                        help="allowed slowdown as a fraction (default 0.15)")
+    parser.add_argument("--filter", default="", help="only compare names matching this regex")
+    args = parser.parse_args()
+
+    baseline = load_times(args.baseline)
+    current = load_times(args.current)
+    pattern = re.compile(args.filter)
+
+    regressions = 0
+    missing = 0
+    width = max((len(name) for name in baseline), default=0)
+    for name, base_time in sorted(baseline.items()):
+        if not pattern.search(name):
+            continue
+        if name not in current:
+            print(f"{name:<{width}}  missing from current run")
+            missing += 1
+            continue
+
+        change = current[name] / base_time - 1.0 if base_time > 0 else 0.0
+        status = "REGRESSION" if change > args.threshold else ""
+        regressions += 1 if status else 0
+        print(f"{name:<{width}}  {base_time:12.1f} -> {current[name]:12.1f}  {change:+7.1%}  {status}")
+
+    print(f"\n{regressions} regression(s) over {args.threshold:.0%}, {missing} missing")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,41 @@
+#!/bin/bash
+# scripts/run_benchmarks.sh
+#
+# Run the benchmark binary and compare it with a baseline from the same machine.
+#
+#   run_benchmarks.sh BENCHMARK_BINARY [compare|update] [extra benchmark flags]
+#
+# compare (default): write build/benchmarks/current.json and fail on >15% regressions
+# update:            overwrite the baseline with this run
+#
+# Timings only compare on one machine and one release build, so baselines are
+# not committed: record one with `update` before changing the code (the
+# benchmark_generation target is built by the release preset). The baseline is
+# build/benchmarks/baseline.json unless PIXELTREE_BENCHMARK_BASELINE is set.
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(dirname "$SCRIPT_DIR")"
+BINARY="${1:?usage: run_benchmarks.sh BENCHMARK_BINARY [compare|update]}"
+MODE="${2:-compare}"
+shift $(( $# > 1 ? 2 : 1 ))
+
+OUTPUT_DIR="$PROJECT_ROOT/build/benchmarks"
+BASELINE="${PIXELTREE_BENCHMARK_BASELINE:-$OUTPUT_DIR/baseline.json}"
+mkdir -p "$OUTPUT_DIR" "$(dirname "$BASELINE")"
+
+# Medians of a few repetitions are far steadier than single runs
+FLAGS="--benchmark_repetitions=3 --benchmark_report_aggregates_only=true --benchmark_min_time=0.2"
+
+if [ "$MODE" = "update" ]; then
+    "$BINARY" $FLAGS --benchmark_out="$BASELINE" --benchmark_out_format=json "$@"
+    echo "Baseline updated: $BASELINE"
+else
+    if [ ! -f "$BASELINE" ]; then
+        echo "No baseline at $BASELINE; record one with: $0 $BINARY update" >&2
+        exit 1
+    fi
+    "$BINARY" $FLAGS --benchmark_out="$OUTPUT_DIR/current.json" --benchmark_out_format=json "$@"
+    python3 "$SCRIPT_DIR/compare_benchmarks.py" "$BASELINE" "$OUTPUT_DIR/current.json"
+fi
@@ -3,59 +3,301 @@
 
 using namespace pixeltree;
 
-// Benchmark basic tree generation
-static void BM_TreeGeneration_Oak(benchmark::State& state) {
+// Preset for a benchmark's tree-type argument (0 = oak, 1 = pine, 2 = palm, 3 = dead)
+static TreeParameters preset_for(int64_t type) {
+    switch (type) {
+        case 1: return TreePresets::pine();
+        case 2: return TreePresets::palm();
+        case 3: return TreePresets::dead();
+        default: return TreePresets::oak();
+    }
+}
+
+// Validated parameters for a stage benchmark; the seed is fixed so every run
+// measures the same tree
+static TreeParameters stage_params(int64_t type, int64_t max_depth, int64_t canvas = 128) {
+    TreeParameters params = preset_for(type);
+    params.random_seed = 12345;
+    params.branches.max_depth = static_cast<int>(max_depth);
+    params.branches.max_branches = 64;
+    params.canvas_width = static_cast<int>(canvas);
+    params.canvas_height = static_cast<int>(canvas);
+    params.overall_scale = static_cast<float>(canvas) / 128.0f;
+    params.validate();
+    return params;
+}
+
+// Tree types x max_depth
+//
+// Each type stops where the 64-branch budget (or the palm preset's depth
+// clamp) stops the tree growing, so every pair measures a different tree.
+// Branch counts for seed 12345 are noted per depth.
+static void TypeDepthArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"type", "depth"});
+    const std::vector<int64_t> depths[4] = {
+        {2, 3, 4, 5},       // Oak: 7, 13, 29, 59
+        {2, 3, 4},          // Pine: 13, 31, 64
+        {2, 3},             // Palm: 6, 11
+        {3, 5, 7},          // Dead: 9, 23, 59
+    };
+    for (int64_t type = 0; type < 4; ++type) {
+        for (int64_t depth : depths[type]) {
+            bench->Args({type, depth});
+        }
+    }
+}
+
+// Tree types x canvas size
+static void TypeCanvasArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"type", "canvas"});
+    for (int64_t type = 0; type < 4; ++type) {
+        for (int64_t canvas : {64, 128, 256, 512}) {
+            bench->Args({type, canvas});
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// L-System stages
+
+static void BM_GenerateString(benchmark::State& state) {
+    const auto params = stage_params(state.range(0), state.range(1));
+    LSystemGenerator lsystem;
+    lsystem.setup_rules(params.type);
+    
+    for (auto _ : state) {
+        Random rng(12345);
+        auto lstring = lsystem.generate_string(params, rng);
+        benchmark::DoNotOptimize(lstring);
+    }
+}
+BENCHMARK(BM_GenerateString)->Apply(TypeDepthArgs);
+
+static void BM_StringToTree(benchmark::State& state) {
+    const auto params = stage_params(state.range(0), state.range(1));
+    LSystemGenerator lsystem;
+    lsystem.setup_rules(params.type);
+    Random string_rng(12345);
+    const std::string lstring = lsystem.generate_string(params, string_rng);
+    TreeStructure tree(params);
+    
+    for (auto _ : state) {
+        Random rng(12345);
+        lsystem.string_to_tree(lstring, params, rng, tree);
+        benchmark::DoNotOptimize(tree.branches.data());
+    }
+    
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(tree.branch_count()));
+}
+BENCHMARK(BM_StringToTree)->Apply(TypeDepthArgs);
+
+// Streaming expansion (plan + turtle) as used by generate()
+static void BM_BuildTree(benchmark::State& state) {
+    const auto params = stage_params(state.range(0), state.range(1));
+    LSystemGenerator lsystem;
+    lsystem.setup_rules(params.type);
+    LSystemGenerator::ExpansionPlan plan;
+    TreeStructure tree(params);
+    
+    for (auto _ : state) {
+        Random rng(12345);
+        lsystem.build_tree(params, rng, tree, plan);
+        benchmark::DoNotOptimize(tree.branches.data());
+    }
+    
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(tree.branch_count()));
+}
+BENCHMARK(BM_BuildTree)->Apply(TypeDepthArgs);
+
+// ---------------------------------------------------------------------------
+// Structure stages
+
+static void BM_GenerateLeafClusters(benchmark::State& state) {
+    const auto params = stage_params(state.range(0), state.range(1));
     TreeGenerator32 generator(12345);
-    auto params = TreePresets::oak();
-    params.canvas_width = state.range(0);
-    params.canvas_height = state.range(0);
+    auto tree = generator.generate_structure(params);
     
     for (auto _ : state) {
-        auto [buffer, metadata] = generator.generate(params);
-        benchmark::DoNotOptimize(buffer);
+        generator.grow_leaves(*tree, params.random_seed);
+        benchmark::DoNotOptimize(tree->leaf_clusters.data());
     }
     
-    state.SetComplexityN(state.range(0) * state.range(0));
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(tree->leaf_cluster_count()));
 }
-BENCHMARK(BM_TreeGeneration_Oak)
-    ->Range(32, 256)
-    ->Complexity(benchmark::oN);
+BENCHMARK(BM_GenerateLeafClusters)->Apply(TypeDepthArgs);
 
-// Benchmark batch generation
-static void BM_BatchGeneration(benchmark::State& state) {
+static void BM_CalculateBoundingBox(benchmark::State& state) {
+    const auto params = stage_params(state.range(0), state.range(1));
     TreeGenerator32 generator(12345);
+    auto tree = generator.generate_structure(params);
     
-    std::vector<TreeParameters> params_list;
-    for (int i = 0; i < state.range(0); ++i) {
-        auto params = TreePresets::oak();
-        params.canvas_width = 64;
-        params.canvas_height = 64;
-        params_list.push_back(params);
+    for (auto _ : state) {
+        tree->calculate_bounding_box();
+        benchmark::DoNotOptimize(tree->bounding_box);
     }
+}
+BENCHMARK(BM_CalculateBoundingBox)->Apply(TypeDepthArgs);
+
+// ---------------------------------------------------------------------------
+// Rendering stages
+
+static void BM_RenderBranches(benchmark::State& state) {
+    const auto params = stage_params(state.range(0), 6, state.range(1));
+    TreeGenerator32 generator(12345);
+    auto tree = generator.generate_structure(params);
+    TreeRenderer renderer;
+    PixelBuffer32 buffer(static_cast<size_t>(params.canvas_width.get()), static_cast<size_t>(params.canvas_height.get()));
+    const auto target = RasterTarget<uint32_t>::from(buffer);
     
     for (auto _ : state) {
-        auto results = generator.generate_batch(params_list);
-        benchmark::DoNotOptimize(results);
+        renderer.render_branches(target, *tree);
+        benchmark::ClobberMemory();
     }
+}
+BENCHMARK(BM_RenderBranches)->Apply(TypeCanvasArgs);
+
+static void BM_RenderLeaves(benchmark::State& state) {
+    const auto params = stage_params(state.range(0), 6, state.range(1));
+    TreeGenerator32 generator(12345);
+    auto tree = generator.generate_structure(params);
+    TreeRenderer renderer;
+    PixelBuffer32 buffer(static_cast<size_t>(params.canvas_width.get()), static_cast<size_t>(params.canvas_height.get()));
+    const auto target = RasterTarget<uint32_t>::from(buffer);
     
-    state.SetItemsProcessed(state.iterations() * state.range(0));
+    for (auto _ : state) {
+        renderer.render_leaves(target, *tree);
+        benchmark::ClobberMemory();
+    }
 }
-BENCHMARK(BM_BatchGeneration)
-    ->Range(1, 100)
-    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RenderLeaves)->Apply(TypeCanvasArgs);
+
+// Row-band rendering of one large tree across threads
+static void BM_BandRender(benchmark::State& state) {
+    const auto params = stage_params(0, 8, 1024);
+    TreeGenerator32 generator(12345);
+    auto tree = generator.generate_structure(params);
+    const BandRenderer renderer(static_cast<size_t>(state.range(0)));
+    PixelBuffer32 buffer;
+    
+    for (auto _ : state) {
+        renderer.render_into(buffer, *tree);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+}
+BENCHMARK(BM_BandRender)
+    ->ArgName("threads")
+    ->RangeMultiplier(2)->Range(1, 8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+// ---------------------------------------------------------------------------
+// Pixel operations
+
+static void BM_BlitWithAlpha(benchmark::State& state) {
+    const auto params = stage_params(0, 6, state.range(0));
+    TreeGenerator32 generator(12345);
+    auto [sprite, metadata] = generator.generate(params);
+    PixelBuffer32 canvas(sprite.width() * 2, sprite.height() * 2);
+    canvas.clear(0x87CEEBFF);
+    
+    for (auto _ : state) {
+        canvas.blit_with_alpha(sprite, {static_cast<int>(sprite.width() / 2), static_cast<int>(sprite.height() / 2)});
+        benchmark::DoNotOptimize(canvas.data());
+    }
+    
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(sprite.size() * sizeof(uint32_t)));
+}
+BENCHMARK(BM_BlitWithAlpha)->ArgName("canvas")->RangeMultiplier(2)->Range(64, 512);
+
+// PixelConverter replaced the old convert_pixel_buffer
+static void BM_ConvertToGray(benchmark::State& state) {
+    const auto canvas = static_cast<size_t>(state.range(0));
+    PixelBuffer32 source(canvas, canvas);
+    source.clear(0x4A7A2CFF);
+    
+    for (auto _ : state) {
+        auto gray = PixelConverter::to_gray(source);
+        benchmark::DoNotOptimize(gray.data());
+    }
+    
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(source.size() * sizeof(uint32_t)));
+}
+BENCHMARK(BM_ConvertToGray)->ArgName("canvas")->RangeMultiplier(2)->Range(64, 512);
+
+static void BM_ConvertToRGB565(benchmark::State& state) {
+    const auto canvas = static_cast<size_t>(state.range(0));
+    PixelBuffer32 source(canvas, canvas);
+    source.clear(0x4A7A2CFF);
+    
+    for (auto _ : state) {
+        auto packed = PixelConverter::to_rgb565(source);
+        benchmark::DoNotOptimize(packed.data());
+    }
+    
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(source.size() * sizeof(uint32_t)));
+}
+BENCHMARK(BM_ConvertToRGB565)->ArgName("canvas")->RangeMultiplier(2)->Range(64, 512);
 
 // Benchmark pixel buffer operations
 static void BM_PixelBuffer_Clear(benchmark::State& state) {
-    PixelBuffer32 buffer(state.range(0), state.range(0));
+    const auto canvas = static_cast<size_t>(state.range(0));
+    PixelBuffer32 buffer(canvas, canvas);
     
     for (auto _ : state) {
         buffer.clear(0xFF0000FF);
         benchmark::DoNotOptimize(buffer);
     }
     
-    state.SetBytesProcessed(state.iterations() * buffer.size() * sizeof(uint32_t));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(buffer.size() * sizeof(uint32_t)));
 }
 BENCHMARK(BM_PixelBuffer_Clear)
     ->Range(64, 512);
 
-BENCHMARK_MAIN();
\ No newline at end of file
+// ---------------------------------------------------------------------------
+// End to end
+
+// Benchmark basic tree generation
+static void BM_TreeGeneration(benchmark::State& state) {
+    TreeGenerator32 generator(12345);
+    auto params = preset_for(state.range(0));
+    params.random_seed = 12345;
+    params.canvas_width = static_cast<int>(state.range(1));
+    params.canvas_height = static_cast<int>(state.range(1));
+    PixelBuffer32 buffer;
+    
+    for (auto _ : state) {
+        auto metadata = generator.generate_into(params, buffer);
+        benchmark::DoNotOptimize(metadata);
+    }
+    
+    state.SetComplexityN(state.range(1) * state.range(1));
+}
+BENCHMARK(BM_TreeGeneration)->Apply(TypeCanvasArgs);
+
+// Benchmark batch generation
+static void BM_BatchGeneration(benchmark::State& state) {
+    TreeGenerator32 generator(12345);
+    
+    std::vector<TreeParameters> params_list;
+    for (int i = 0; i < 64; ++i) {
+        auto params = TreePresets::oak();
+        params.canvas_width = 64;
+        params.canvas_height = 64;
+        params.random_seed = static_cast<uint32_t>(i + 1);
+        params_list.push_back(params);
+    }
+    
+    for (auto _ : state) {
+        auto results = generator.generate_batch(params_list, static_cast<size_t>(state.range(0)));
+        benchmark::DoNotOptimize(results);
+    }
+    
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(params_list.size()));
+}
+BENCHMARK(BM_BatchGeneration)
+    ->ArgName("threads")
+    ->RangeMultiplier(2)->Range(1, 8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
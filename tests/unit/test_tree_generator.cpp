@@ -1,5 +1,12 @@
 #include <pixeltree/pixeltree.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <random>
+#include <sstream>
 
 using namespace pixeltree;
 
@@ -77,4 +84,1936 @@ TEST_CASE("PixelBuffer operations", "[pixel_buffer]") {
         REQUIRE_FALSE(buffer.contains(5, 5));
         REQUIRE_FALSE(buffer.contains(-1, 0));
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Parallel batch generation", "[generator][batch]") {
+    std::vector<TreeParameters> params_list;
+    for (int i = 0; i < 16; ++i) {
+        auto params = TreePresets::oak();
+        params.canvas_width = 64;
+        params.canvas_height = 64;
+        params.random_seed = (i % 2 == 0) ? 0u : static_cast<uint32_t>(500 + i);
+        params_list.push_back(params);
+    }
+    
+    SECTION("Output is independent of thread count") {
+        TreeGenerator32 serial_generator(777);
+        TreeGenerator32 parallel_generator(777);
+        
+        auto serial = serial_generator.generate_batch(params_list, 1);
+        auto parallel = parallel_generator.generate_batch(params_list, 4);
+        
+        REQUIRE(serial.size() == parallel.size());
+        for (size_t i = 0; i < serial.size(); ++i) {
+            CAPTURE(i);
+            REQUIRE(serial[i].second.random_seed == parallel[i].second.random_seed);
+            REQUIRE(serial[i].second.branch_count == parallel[i].second.branch_count);
+            REQUIRE(std::equal(serial[i].first.begin(), serial[i].first.end(),
+                               parallel[i].first.begin()));
+        }
+    }
+    
+    SECTION("Explicit seeds are kept") {
+        TreeGenerator32 generator(1);
+        auto results = generator.generate_batch(params_list);
+        
+        REQUIRE(results[1].second.random_seed == 501u);
+        REQUIRE(results[3].second.random_seed == 503u);
+    }
+}
+
+TEST_CASE("Flat TreeStructure branch store", "[structure]") {
+    TreeStructure tree(TreeParameters{});
+    
+    const uint32_t root = tree.add_branch(Branch({0, 0}, {0, -10}, 2.0f));
+    const uint32_t left = tree.add_branch(Branch({0, -10}, {-5, -15}, 1.0f, 1), root);
+    const uint32_t right = tree.add_branch(Branch({0, -10}, {5, -15}, 1.0f, 1), root);
+    
+    SECTION("Children are linked in insertion order") {
+        REQUIRE(tree.branches[root].first_child == left);
+        REQUIRE(tree.branches[left].next_sibling == right);
+        REQUIRE(tree.branches[right].parent == root);
+        REQUIRE(tree.get_leaf_branches() == std::vector<uint32_t>{left, right});
+        REQUIRE(tree.max_depth() == 1);
+    }
+    
+    SECTION("Reset keeps storage for reuse") {
+        const size_t capacity = tree.branches.capacity();
+        tree.reset(TreeParameters{});
+        
+        REQUIRE(tree.branch_count() == 0);
+        REQUIRE(tree.root() == nullptr);
+        REQUIRE(tree.branches.capacity() == capacity);
+    }
+}
+
+TEST_CASE("Structure-of-arrays tree view", "[structure][simd]") {
+    TreeGenerator32 generator(4242);
+    auto params = TreePresets::oak();
+    params.random_seed = 4242;
+    
+    auto tree = generator.generate_structure(params);
+    const TreeSoA soa(*tree);
+    
+    REQUIRE(soa.branches.size() == tree->branch_count());
+    REQUIRE(soa.leaves.count() == tree->leaf_cluster_count());
+    REQUIRE(soa.max_depth() == tree->max_depth());
+    
+    const Rect2Df box = soa.bounding_box();
+    REQUIRE(box.min.x == tree->bounding_box.min.x);
+    REQUIRE(box.min.y == tree->bounding_box.min.y);
+    REQUIRE(box.max.x == tree->bounding_box.max.x);
+    REQUIRE(box.max.y == tree->bounding_box.max.y);
+}
+
+TEST_CASE("Streaming L-System expansion", "[lsystem]") {
+    LSystemGenerator lsystem;
+    auto params = TreePresets::oak();
+    params.branches.max_depth = 7;
+    
+    SECTION("Streamed symbols match the materialized string") {
+        Random string_rng(99);
+        const std::string expected = lsystem.generate_string(params, string_rng);
+        
+        Random plan_rng(99);
+        LSystemGenerator::ExpansionPlan plan;
+        lsystem.plan_expansion(params, plan_rng, plan);
+        
+        std::string streamed;
+        lsystem.stream_expansion(plan, [&streamed](char c) { streamed += c; });
+        
+        REQUIRE(streamed == expected);
+        REQUIRE(plan_rng.next_uint() == string_rng.next_uint());
+    }
+    
+    SECTION("Streaming build matches string_to_tree") {
+        Random string_rng(7);
+        const std::string lstring = lsystem.generate_string(params, string_rng);
+        const auto expected = lsystem.string_to_tree(lstring, params, string_rng);
+        
+        Random stream_rng(7);
+        TreeStructure streamed(params);
+        LSystemGenerator::ExpansionPlan plan;
+        lsystem.build_tree(params, stream_rng, streamed, plan);
+        
+        REQUIRE(streamed.branch_count() == expected->branch_count());
+        for (size_t i = 0; i < streamed.branch_count(); ++i) {
+            REQUIRE(streamed.branches[i].end_point.x == expected->branches[i].end_point.x);
+            REQUIRE(streamed.branches[i].end_point.y == expected->branches[i].end_point.y);
+        }
+    }
+}
+
+TEST_CASE("Branch budget", "[generator][budget]") {
+    auto params = TreePresets::oak();
+    params.branches.branch_probability = 1.0f;
+    params.branches.max_depth = 8;
+    
+    SECTION("max_branches caps every generated tree") {
+        params.branches.max_branches = 20;
+        TreeGenerator32 generator(3);
+        
+        for (uint32_t seed = 1; seed <= 10; ++seed) {
+            params.random_seed = seed;
+            auto [buffer, metadata] = generator.generate(params);
+            REQUIRE(metadata.branch_count <= 20);
+        }
+    }
+    
+    SECTION("MaxBranches caps below max_branches") {
+        params.branches.max_branches = 64;
+        TreeGenerator<uint32_t, 16> generator(3);
+        
+        auto tree = generator.generate_structure(params);
+        REQUIRE(tree->branch_count() <= 16);
+        REQUIRE(TreeGenerator<uint32_t, 16>::uses_fixed_storage);
+    }
+}
+
+TEST_CASE("Leaf cluster shapes", "[renderer]") {
+    auto params = TreePresets::oak();
+    params.canvas_width = 64;
+    params.canvas_height = 64;
+    
+    TreeStructure tree(params);
+    const Color green{40, 160, 40, 255};
+    TreeRenderer renderer;
+    
+    SECTION("Ellipse is wider than it is tall") {
+        LeafCluster cluster({32.0f, 32.0f}, 6.0f, green);
+        cluster.shape = LeafCluster::Shape::Ellipse;
+        tree.leaf_clusters.push_back(cluster);
+        
+        auto buffer = renderer.render(tree);
+        REQUIRE(buffer.at(40, 32) == green.to_rgba());
+        REQUIRE(buffer.at(32, 40) != green.to_rgba());
+    }
+    
+    SECTION("Scattered leaves are drawn at their positions") {
+        Random rng(11);
+        LeafCluster cluster({32.0f, 32.0f}, 6.0f, green);
+        cluster.shape = LeafCluster::Shape::Scattered;
+        cluster.generate_leaves(rng, 8);
+        tree.leaf_clusters.push_back(cluster);
+        
+        auto buffer = renderer.render(tree);
+        for (const auto& leaf : cluster.leaf_positions) {
+            const auto x = static_cast<size_t>(std::round(leaf.x));
+            const auto y = static_cast<size_t>(std::round(leaf.y));
+            REQUIRE(buffer.at(x, y) == green.to_rgba());
+            
+            const float reach = cluster.reach();
+            REQUIRE(std::abs(leaf.x - cluster.position.x) <= reach);
+            REQUIRE(std::abs(leaf.y - cluster.position.y) <= reach);
+        }
+    }
+}
+
+TEST_CASE("Alpha blending", "[simd][pixel_buffer]") {
+    SECTION("Vector kernels match the per-pixel blend") {
+        Random rng(17);
+        constexpr size_t count = 67;  // Exercise the vector body and the remainder
+        std::vector<uint32_t> src(count), dest(count), expected(count);
+        for (size_t i = 0; i < count; ++i) {
+            src[i] = rng.next_uint();
+            dest[i] = rng.next_uint();
+        }
+        // Runs of fully transparent and fully opaque source pixels
+        for (size_t i = 8; i < 16; ++i) src[i] &= 0xFFFFFF00u;
+        for (size_t i = 16; i < 24; ++i) src[i] |= 0xFFu;
+        
+        for (size_t i = 0; i < count; ++i) {
+            expected[i] = simd::PixelOperations::blend_pixel(dest[i], src[i]);
+        }
+        simd::PixelOperations::alpha_blend(dest.data(), src.data(), count);
+        REQUIRE(dest == expected);
+    }
+    
+    SECTION("Blend rounds to nearest") {
+        // 50% white over black
+        REQUIRE(simd::PixelOperations::blend_pixel(0x000000FFu, 0xFFFFFF80u) == 0x808080FFu);
+        REQUIRE(simd::PixelOperations::blend_pixel(0x12345678u, 0xFFFFFF00u) == 0x12345678u);
+        REQUIRE(simd::PixelOperations::blend_pixel(0x12345678u, 0xABCDEFFFu) == 0xABCDEFFFu);
+    }
+    
+    SECTION("Blits clip against the destination") {
+        PixelBuffer32 dest(8, 8);
+        PixelBuffer32 sprite(4, 4);
+        sprite.clear(0xFF0000FFu);
+        
+        dest.blit_with_alpha(sprite, {-2, 6});
+        REQUIRE(dest(0, 6) == 0xFF0000FFu);
+        REQUIRE(dest(1, 7) == 0xFF0000FFu);
+        REQUIRE(dest(2, 6) == 0u);
+        REQUIRE(dest(0, 5) == 0u);
+        
+        dest.blit(sprite, {6, -3});
+        REQUIRE(dest(7, 0) == 0xFF0000FFu);
+        REQUIRE(dest(5, 0) == 0u);
+        REQUIRE(dest(7, 1) == 0u);
+        
+        dest.blit(sprite, {8, 0});
+        dest.blit(sprite, {-4, 0});
+        REQUIRE(dest(0, 0) == 0u);
+    }
+}
+
+TEST_CASE("Runtime SIMD dispatch", "[simd]") {
+    using simd::GeometryKernelTable;
+    using simd::GeometryOperations;
+    using simd::KernelTable;
+    using simd::PixelOperations;
+    using simd::SimdLevel;
+    
+    REQUIRE(PixelOperations::supports(PixelOperations::active_level()));
+    REQUIRE(has_simd_support() == (simd_level() != SimdLevel::Scalar));
+    
+    Random rng(23);
+    constexpr size_t count = 77;
+    std::vector<uint32_t> src(count), background(count);
+    for (size_t i = 0; i < count; ++i) {
+        src[i] = rng.next_uint();
+        background[i] = rng.next_uint();
+    }
+    
+    const KernelTable reference = PixelOperations::table_for(SimdLevel::Scalar);
+    for (SimdLevel level : {SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON}) {
+        if (!PixelOperations::supports(level)) {
+            continue;
+        }
+        const KernelTable table = PixelOperations::table_for(level);
+        REQUIRE(table.level == level);
+        
+        std::vector<uint32_t> expected = background, actual = background;
+        reference.alpha_blend(expected.data(), src.data(), count);
+        table.alpha_blend(actual.data(), src.data(), count);
+        REQUIRE(actual == expected);
+        
+        std::vector<uint8_t> gray_expected(count), gray_actual(count);
+        reference.rgba_to_gray(gray_expected.data(), src.data(), count);
+        table.rgba_to_gray(gray_actual.data(), src.data(), count);
+        REQUIRE(gray_actual == gray_expected);
+        
+        for (size_t length : {4, 5, 8, 13, 32}) {
+            actual = background;
+            expected = background;
+            reference.fill_span(expected.data() + 1, length, 0xDEADBEEFu);
+            table.fill_span(actual.data() + 1, length, 0xDEADBEEFu);
+            REQUIRE(actual == expected);
+        }
+        
+        table.clear(actual.data(), count, 0x11223344u);
+        REQUIRE(std::all_of(actual.begin(), actual.end(), [](uint32_t p) { return p == 0x11223344u; }));
+        
+        // Runs of transparent and of opaque destinations take the vector paths
+        std::vector<uint8_t> coverage(count);
+        std::vector<uint32_t> fringe_src = src;
+        for (size_t i = 0; i < count; ++i) {
+            coverage[i] = static_cast<uint8_t>(i % 9 == 0 ? 0 : i % 11 == 0 ? 255 : src[i] >> 13);
+            if (i < 40) {
+                background[i] = (i / 8) % 2 ? background[i] | 0xFF : background[i] & 0xFFFFFF00u;
+                fringe_src[i] |= 0xFF;
+            }
+        }
+        expected = background;
+        actual = background;
+        reference.coverage_blend(expected.data(), fringe_src.data(), coverage.data(), count);
+        table.coverage_blend(actual.data(), fringe_src.data(), coverage.data(), count);
+        REQUIRE(actual == expected);
+    }
+    
+    // Geometry reductions, at lengths covering every vector width and remainder
+    const GeometryKernelTable geometry_reference = GeometryOperations::table_for(SimdLevel::Scalar);
+    std::vector<float> coords[5];
+    for (std::vector<float>& values : coords) {
+        for (size_t i = 0; i < count; ++i) {
+            values.push_back(rng.next_float(-500.0f, 500.0f));
+        }
+    }
+    std::vector<int32_t> depths(count);
+    for (size_t i = 0; i < count; ++i) {
+        depths[i] = static_cast<int32_t>(rng.next_uint() % 1000) - 500;
+    }
+    const auto same = [](const simd::Bounds& a, const simd::Bounds& b) {
+        return a.min_x == b.min_x && a.min_y == b.min_y && a.max_x == b.max_x && a.max_y == b.max_y;
+    };
+    for (SimdLevel level : {SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON}) {
+        const GeometryKernelTable table = GeometryOperations::table_for(level);
+        REQUIRE((table.level == level || table.level == SimdLevel::Scalar));
+        for (size_t length : {1, 3, 4, 7, 8, 13, 16, 77}) {
+            REQUIRE(same(table.segment_bounds(coords[0].data(), coords[1].data(), coords[2].data(),
+                                              coords[3].data(), coords[4].data(), length),
+                         geometry_reference.segment_bounds(coords[0].data(), coords[1].data(), coords[2].data(),
+                                                            coords[3].data(), coords[4].data(), length)));
+            REQUIRE(same(table.circle_bounds(coords[0].data(), coords[1].data(), coords[4].data(), length),
+                         geometry_reference.circle_bounds(coords[0].data(), coords[1].data(), coords[4].data(), length)));
+            REQUIRE(table.max_value(depths.data(), length) == geometry_reference.max_value(depths.data(), length));
+        }
+    }
+    REQUIRE(GeometryOperations::kernels().level == GeometryOperations::table_for(PixelOperations::active_level()).level);
+}
+
+TEST_CASE("Pixel format conversion", "[simd][pixel_format]") {
+    using simd::PixelOperations;
+    using simd::SimdLevel;
+    
+    SECTION("Per-pixel formats") {
+        REQUIRE(PixelOperations::rgb565_pixel(0xFF0000FFu) == 0xF800);
+        REQUIRE(PixelOperations::rgb565_pixel(0x00FF00FFu) == 0x07E0);
+        REQUIRE(PixelOperations::rgb565_pixel(0x0000FFFFu) == 0x001F);
+        REQUIRE(PixelOperations::premultiply_pixel(0xFF804080u) == 0x80402080u);
+        REQUIRE(PixelOperations::bgra_pixel(0x11223344u) == 0x44112233u);
+    }
+    
+    SECTION("Conversion kernels match the per-pixel formats") {
+        Random rng(29);
+        constexpr size_t count = 83;
+        std::vector<uint32_t> src(count);
+        for (auto& pixel : src) {
+            pixel = rng.next_uint();
+        }
+        
+        const auto reference = PixelOperations::table_for(SimdLevel::Scalar);
+        for (SimdLevel level : {SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::NEON}) {
+            if (!PixelOperations::supports(level)) {
+                continue;
+            }
+            const auto table = PixelOperations::table_for(level);
+            
+            std::vector<uint16_t> rgb565_expected(count), rgb565_actual(count);
+            reference.rgba_to_rgb565(rgb565_expected.data(), src.data(), count);
+            table.rgba_to_rgb565(rgb565_actual.data(), src.data(), count);
+            REQUIRE(rgb565_actual == rgb565_expected);
+            
+            std::vector<uint32_t> expected(count), actual(count);
+            reference.premultiply(expected.data(), src.data(), count);
+            table.premultiply(actual.data(), src.data(), count);
+            REQUIRE(actual == expected);
+            
+            reference.swizzle_bgra(expected.data(), src.data(), count);
+            table.swizzle_bgra(actual.data(), src.data(), count);
+            REQUIRE(actual == expected);
+        }
+    }
+    
+    SECTION("Direct rendering matches render-then-convert") {
+        TreeGenerator32 generator(5150);
+        auto params = TreePresets::pine();
+        params.random_seed = 5150;
+        auto tree = generator.generate_structure(params);
+        
+        TreeRenderer renderer;
+        const auto rgba = renderer.render(*tree);
+        
+        const auto gray = renderer.render<uint8_t>(*tree);
+        const auto gray_converted = PixelConverter::to_gray(rgba);
+        REQUIRE(std::equal(gray.begin(), gray.end(), gray_converted.begin()));
+        
+        const auto rgb565 = renderer.render<uint16_t>(*tree);
+        const auto rgb565_converted = PixelConverter::to_rgb565(rgba);
+        REQUIRE(std::equal(rgb565.begin(), rgb565.end(), rgb565_converted.begin()));
+    }
+}
+
+namespace {
+
+// Heap allocations made through operator new, by any thread
+std::atomic<size_t> heap_allocations{0};
+
+} // namespace
+
+void* operator new(size_t size) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+// GCC inlines these into callers and then takes the new/free pair for a mismatch
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+TEST_CASE("Reusable pixel buffers", "[pixel_buffer]") {
+    SECTION("Storage is aligned and reused by reset") {
+        PixelBuffer32 buffer(20, 10);
+        REQUIRE(reinterpret_cast<uintptr_t>(buffer.data()) % PixelBuffer32::alignment == 0);
+        REQUIRE(std::all_of(buffer.begin(), buffer.end(), [](uint32_t p) { return p == 0; }));
+        
+        const uint32_t* storage = buffer.data();
+        buffer.reset(10, 10);
+        REQUIRE(buffer.data() == storage);
+        REQUIRE(buffer.size() == 100);
+        REQUIRE(buffer.capacity() == 200);
+    }
+    
+    SECTION("Pool hands released storage back out, cleared") {
+        PixelBufferPool<uint32_t> pool;
+        auto first = pool.acquire(32, 32);
+        first.clear(0xFFFFFFFFu);
+        const uint32_t* storage = first.data();
+        pool.release(std::move(first));
+        REQUIRE(pool.pooled() == 1);
+        
+        auto second = pool.acquire(16, 16);
+        REQUIRE(second.data() == storage);
+        REQUIRE(second.width() == 16);
+        REQUIRE(std::all_of(second.begin(), second.end(), [](uint32_t p) { return p == 0; }));
+        REQUIRE(pool.pooled() == 0);
+    }
+    
+    SECTION("generate_into matches generate") {
+        auto params = TreePresets::oak();
+        params.random_seed = 8080;
+        
+        TreeGenerator32 generator(1);
+        auto [expected, expected_metadata] = generator.generate(params);
+        
+        PixelBufferPool<uint32_t> pool;
+        PixelBuffer32 buffer = pool.acquire(256, 256, 0xFFFFFFFFu);
+        const uint32_t* storage = buffer.data();
+        const auto metadata = generator.generate_into(params, buffer);
+        
+        REQUIRE(buffer.data() == storage);
+        REQUIRE(buffer.width() == expected.width());
+        REQUIRE(buffer.height() == expected.height());
+        REQUIRE(std::equal(buffer.begin(), buffer.end(), expected.begin()));
+        REQUIRE(metadata.branch_count == expected_metadata.branch_count);
+    }
+    
+    SECTION("A warmed generate_into does not allocate") {
+        // Spiky (pine) and Scattered (willow) clusters carry individual leaves
+        auto willow = TreePresets::oak();
+        willow.type = TreeType::Willow;
+        TreeGenerator32 generator(1);
+        FixedTreeGenerator32 fixed_generator(1);
+        PixelBuffer32 buffer;
+        for (auto params : {TreePresets::oak(), TreePresets::pine(), TreePresets::palm(), willow}) {
+            params.random_seed = 4242;
+            generator.generate_into(params, buffer);
+            fixed_generator.generate_into(params, buffer);
+            
+            const size_t before = heap_allocations.load();
+            generator.generate_into(params, buffer);
+            fixed_generator.generate_into(params, buffer);
+            REQUIRE(heap_allocations.load() == before);
+        }
+    }
+}
+
+TEST_CASE("Cropped rendering", "[renderer][crop]") {
+    TreeGenerator32 generator(77);
+    
+    for (auto params : {TreePresets::oak(), TreePresets::pine(), TreePresets::palm(), TreePresets::dead()}) {
+        for (uint32_t seed = 1; seed <= 10; ++seed) {
+            params.random_seed = seed;
+            auto [full, metadata] = generator.generate(params);
+            auto [sprite, cropped_metadata] = generator.generate_cropped(params);
+            
+            REQUIRE(cropped_metadata.branch_count == metadata.branch_count);
+            REQUIRE(sprite.pixels.size() <= full.size());
+            
+            // The sprite equals its region of the full canvas, and nothing was drawn outside it
+            const Rect2Di area = sprite.canvas_rect();
+            size_t mismatches = 0;
+            for (size_t y = 0; y < full.height(); ++y) {
+                for (size_t x = 0; x < full.width(); ++x) {
+                    const int cx = static_cast<int>(x), cy = static_cast<int>(y);
+                    const bool inside = cx >= area.min.x && cx < area.max.x && cy >= area.min.y && cy < area.max.y;
+                    const uint32_t expected = inside ? sprite.pixels(x - area.min.x, y - area.min.y) : 0u;
+                    mismatches += full(x, y) != expected;
+                }
+            }
+            REQUIRE(mismatches == 0);
+        }
+    }
+}
+
+TEST_CASE("Tiled rendering", "[renderer][tiled]") {
+    auto params = TreePresets::oak();
+    params.canvas_width = 1000;
+    params.canvas_height = 700;
+    params.overall_scale = 6.0f;
+    params.random_seed = 321;
+    REQUIRE(params.canvas_width.get() == 1000);
+    
+    TreeGenerator32 generator(1);
+    auto [full, metadata] = generator.generate(params);
+    
+    // Non-square remainder tiles on the right and bottom edges
+    const TiledRenderer<uint32_t> tiles(128, 4);
+    PixelBuffer32 assembled(full.width(), full.height());
+    assembled.clear(0xDEADBEEFu);
+    std::vector<int> seen(8 * 6, 0);
+    size_t non_empty = 0;
+    size_t size_mismatches = 0;
+    
+    // The sink runs on the workers; only record there and assert afterwards
+    const auto tiled_metadata = generator.generate_tiled(params, tiles,
+        [&](const TiledRenderer<uint32_t>::Tile& tile, const PixelBuffer32& pixels) {
+            size_mismatches += static_cast<int>(pixels.width()) != tile.rect.width() ||
+                               static_cast<int>(pixels.height()) != tile.rect.height();
+            ++seen[tile.index];
+            non_empty += !tile.empty;
+            assembled.blit(pixels, tile.rect.min);
+        });
+    
+    REQUIRE(size_mismatches == 0);
+    REQUIRE(tiled_metadata.branch_count == metadata.branch_count);
+    REQUIRE(std::all_of(seen.begin(), seen.end(), [](int count) { return count == 1; }));
+    REQUIRE(non_empty > 0);
+    REQUIRE(non_empty < seen.size());
+    REQUIRE(std::equal(assembled.begin(), assembled.end(), full.begin()));
+}
+
+TEST_CASE("Row-band parallel rendering", "[renderer][parallel]") {
+    auto params = TreePresets::oak();
+    params.canvas_width = 480;
+    params.canvas_height = 400;
+    params.overall_scale = 4.0f;
+    
+    TreeGenerator32 generator(2);
+    TreeRenderer serial;
+    
+    for (uint32_t seed = 1; seed <= 5; ++seed) {
+        params.random_seed = seed;
+        auto tree = generator.generate_structure(params);
+        const auto expected = serial.render(*tree);
+        
+        for (size_t threads : {2, 3, 8}) {
+            for (int band_height : {0, 1, 17}) {
+                const auto banded = BandRenderer(threads, band_height).render(*tree);
+                REQUIRE(std::equal(banded.begin(), banded.end(), expected.begin()));
+            }
+        }
+        
+        const auto gray = BandRenderer(4).render<uint8_t>(*tree);
+        const auto gray_expected = serial.render<uint8_t>(*tree);
+        REQUIRE(std::equal(gray.begin(), gray.end(), gray_expected.begin()));
+    }
+    
+    SECTION("Generator render threads do not change the output") {
+        params.random_seed = 99;
+        auto [expected, metadata] = generator.generate(params);
+        generator.set_render_threads(4);
+        auto [banded, banded_metadata] = generator.generate(params);
+        REQUIRE(std::equal(banded.begin(), banded.end(), expected.begin()));
+    }
+    
+    SECTION("Cropped and archived renders are banded too") {
+        params.random_seed = 99;
+        auto [expected_sprite, metadata] = generator.generate_cropped(params);
+        auto tree = generator.generate_structure(params);
+        TreeArchiveWriter writer;
+        writer.add(*tree);
+        const std::vector<uint8_t> bytes = writer.bytes();
+        const TreeArchiveView archive(bytes.data(), bytes.size());
+        const auto expected_view = generator.render_structure(archive[0]);
+        
+        generator.set_render_threads(3);
+        auto [sprite, banded_metadata] = generator.generate_cropped(params);
+        REQUIRE(sprite.origin.x == expected_sprite.origin.x);
+        REQUIRE(sprite.origin.y == expected_sprite.origin.y);
+        REQUIRE(sprite.pixels.width() == expected_sprite.pixels.width());
+        REQUIRE(sprite.pixels.height() == expected_sprite.pixels.height());
+        REQUIRE(std::equal(sprite.pixels.begin(), sprite.pixels.end(), expected_sprite.pixels.begin()));
+        
+        const auto banded_view = generator.render_structure(archive[0]);
+        REQUIRE(std::equal(banded_view.begin(), banded_view.end(), expected_view.begin()));
+        REQUIRE(std::equal(expected_view.begin(), expected_view.end(), serial.render(*tree).begin()));
+    }
+}
+
+TEST_CASE("PCG32 random streams", "[random]") {
+    SECTION("Matches the PCG32 reference sequence") {
+        Random rng(42, 54);
+        const uint32_t expected[] = {0xa15c02b7u, 0x7b47f409u, 0xba1d3330u,
+                                     0x83d2f293u, 0xbfa4784bu, 0xcbed606eu};
+        for (uint32_t value : expected) {
+            REQUIRE(rng.next_uint() == value);
+        }
+    }
+    
+    SECTION("Advance skips ahead exactly") {
+        Random stepped(1234, 7);
+        Random jumped(1234, 7);
+        for (int i = 0; i < 1000; ++i) {
+            stepped.next_uint();
+        }
+        jumped.advance(1000);
+        REQUIRE(stepped.next_uint() == jumped.next_uint());
+    }
+    
+    SECTION("Streams and splits are independent") {
+        Random base(99);
+        Random other = base.stream(1);
+        Random child = base.split();
+        int equal_stream = 0, equal_child = 0;
+        for (int i = 0; i < 256; ++i) {
+            const uint32_t value = base.next_uint();
+            equal_stream += value == other.next_uint();
+            equal_child += value == child.next_uint();
+        }
+        REQUIRE(equal_stream < 4);
+        REQUIRE(equal_child < 4);
+        REQUIRE(base.stream(1).next_uint() == Random(99, 1).next_uint());
+    }
+    
+    SECTION("Bounded ints and floats stay in range") {
+        Random rng(5);
+        int counts[7] = {};
+        for (int i = 0; i < 7000; ++i) {
+            const int value = rng.next_int(-3, 3);
+            REQUIRE(value >= -3);
+            REQUIRE(value <= 3);
+            ++counts[value + 3];
+        }
+        for (int count : counts) {
+            REQUIRE(count > 800);
+        }
+        REQUIRE(rng.next_int(4, 4) == 4);
+        
+        float batch[150];
+        Random filler(8), single(8);
+        filler.fill_floats(batch, 150, -2.0f, 2.0f);
+        for (float value : batch) {
+            REQUIRE(value == single.next_float(-2.0f, 2.0f));
+            REQUIRE(value >= -2.0f);
+            REQUIRE(value < 2.0f);
+        }
+    }
+}
+
+TEST_CASE("Polynomial sincos", "[math]") {
+    SECTION("Close to libm over the turtle's angle range and beyond") {
+        for (int i = -7200; i <= 7200; ++i) {
+            const float degrees = i * 0.1f;
+            const SinCos sc = Trig::sincos_degrees(degrees);
+            const double radians = degrees * 3.14159265358979323846 / 180.0;
+            REQUIRE(std::abs(sc.sin - std::sin(radians)) < 5e-7);
+            REQUIRE(std::abs(sc.cos - std::cos(radians)) < 5e-7);
+            
+            const SinCos rad = Trig::sincos(static_cast<float>(radians));
+            REQUIRE(std::abs(rad.sin - std::sin(radians)) < 2e-6);
+            REQUIRE(std::abs(rad.cos - std::cos(radians)) < 2e-6);
+        }
+    }
+    
+    SECTION("Quarter turns are exact and turns are symmetric") {
+        REQUIRE(Trig::sincos_degrees(0.0f).cos == 1.0f);
+        REQUIRE(Trig::sincos_degrees(90.0f).sin == 1.0f);
+        REQUIRE(Trig::sincos_degrees(90.0f).cos == 0.0f);
+        REQUIRE(Trig::sincos_degrees(-180.0f).cos == -1.0f);
+        for (float degrees : {0.5f, 13.7f, 44.9f, 45.0f}) {
+            REQUIRE(Trig::sincos_degrees(-degrees).sin == -Trig::sincos_degrees(degrees).sin);
+            REQUIRE(Trig::sincos_degrees(-degrees).cos == Trig::sincos_degrees(degrees).cos);
+        }
+    }
+    
+    SECTION("Batched form matches scalar calls") {
+        float degrees[33], sines[33], cosines[33];
+        for (int i = 0; i < 33; ++i) {
+            degrees[i] = -45.0f + i * 2.8f;
+        }
+        Trig::sincos_degrees(degrees, sines, cosines, 33);
+        for (int i = 0; i < 33; ++i) {
+            REQUIRE(sines[i] == Trig::sincos_degrees(degrees[i]).sin);
+            REQUIRE(cosines[i] == Trig::sincos_degrees(degrees[i]).cos);
+        }
+    }
+}
+
+TEST_CASE("L-System rule sets", "[lsystem]") {
+    static_assert(TreeRules<TreeType::Pine>::production.children == 3);
+    static_assert(TreeRules<TreeType::Palm>::production.children == 5);
+    
+    LSystemGenerator lsystem;
+    
+    SECTION("Every branch starts where its parent ends, one level deeper when nested") {
+        for (auto params : {TreePresets::oak(), TreePresets::pine(), TreePresets::palm(), TreePresets::dead()}) {
+            params.validate();
+            lsystem.setup_rules(params.type);
+            Random rng(31);
+            TreeStructure tree(params);
+            LSystemGenerator::ExpansionPlan plan;
+            lsystem.build_tree(params, rng, tree, plan);
+            
+            REQUIRE(tree.max_depth() > 0);
+            for (const auto& branch : tree.branches) {
+                if (branch.parent == Branch::npos) {
+                    continue;
+                }
+                const Branch& parent = tree.branches[branch.parent];
+                REQUIRE(branch.start_point.x == parent.end_point.x);
+                REQUIRE(branch.start_point.y == parent.end_point.y);
+                REQUIRE(branch.depth_level >= parent.depth_level);
+                REQUIRE(branch.depth_level <= parent.depth_level + 1);
+            }
+        }
+    }
+    
+    SECTION("Split rules set the number of children") {
+        auto params = TreePresets::pine();
+        params.branches.max_depth = 1;
+        lsystem.setup_rules(TreeType::Pine);
+        Random rng(3);
+        REQUIRE(lsystem.generate_string(params, rng) == "F[++F][F][--F]");
+    }
+    
+    SECTION("Custom grammars expand a runtime production") {
+        auto params = TreePresets::oak();
+        params.type = TreeType::Custom;
+        params.branches.max_depth = 4;
+        params.branches.max_branches = 64;
+        
+        RuleSet rules;
+        rules.split.angle_spread = 20.0f;
+        rules.terminate.probability = 0.3f;
+        lsystem.set_custom_grammar(CustomGrammar(rules, "F[+F]F[-F]G"));
+        lsystem.setup_rules(TreeType::Custom);
+        
+        Random string_rng(12);
+        const std::string expected = lsystem.generate_string(params, string_rng);
+        REQUIRE(expected.rfind("F[+", 0) == 0);
+        
+        Random plan_rng(12);
+        LSystemGenerator::ExpansionPlan plan;
+        lsystem.plan_expansion(params, plan_rng, plan);
+        std::string streamed;
+        lsystem.stream_expansion(plan, [&streamed](char c) { streamed += c; });
+        REQUIRE(streamed == expected);
+        REQUIRE(plan_rng.next_uint() == string_rng.next_uint());
+        
+        REQUIRE_THROWS_AS(CustomGrammar(rules, "F[+F"), std::invalid_argument);
+        REQUIRE_THROWS_AS(CustomGrammar(rules, "F[x]"), std::invalid_argument);
+        REQUIRE_THROWS_AS(CustomGrammar(rules, "G+G"), std::invalid_argument);
+    }
+    
+    SECTION("Terminated children stop growing") {
+        auto params = TreePresets::palm();
+        params.validate();
+        lsystem.setup_rules(TreeType::Palm);
+        Random rng(8);
+        const std::string lstring = lsystem.generate_string(params, rng);
+        REQUIRE(lstring.find('G') != std::string::npos);
+    }
+}
+
+TEST_CASE("Structure cache", "[generator][cache]") {
+    auto params = TreePresets::oak();
+    params.random_seed = 2024;
+    
+    auto cache = std::make_shared<StructureCache>();
+    TreeGenerator32 cached_generator(1);
+    cached_generator.set_structure_cache(cache);
+    TreeGenerator32 plain_generator(1);
+    
+    SECTION("Hits reproduce the uncached output exactly") {
+        auto [first, first_metadata] = cached_generator.generate(params);
+        REQUIRE(cache->stats().misses == 1);
+        REQUIRE(cache->stats().hits == 0);
+        
+        auto [again, again_metadata] = cached_generator.generate(params);
+        REQUIRE(cache->stats().hits == 1);
+        
+        auto [expected, expected_metadata] = plain_generator.generate(params);
+        REQUIRE(std::equal(first.begin(), first.end(), expected.begin()));
+        REQUIRE(std::equal(again.begin(), again.end(), expected.begin()));
+    }
+    
+    SECTION("Render-only changes reuse the skeleton") {
+        cached_generator.generate(params);
+        
+        auto resized = params;
+        resized.canvas_width = 200;
+        resized.canvas_height = 160;
+        auto autumn = params;
+        autumn.season = Season::Autumn;
+        
+        for (const auto& variant : {resized, autumn}) {
+            auto [buffer, metadata] = cached_generator.generate(variant);
+            auto [expected, expected_metadata] = plain_generator.generate(variant);
+            REQUIRE(buffer.width() == expected.width());
+            REQUIRE(std::equal(buffer.begin(), buffer.end(), expected.begin()));
+        }
+        REQUIRE(cache->stats().hits == 2);
+        REQUIRE(cache->stats().misses == 1);
+        
+        auto reseeded = params;
+        reseeded.random_seed = 2025;
+        auto deeper = params;
+        deeper.branches.max_depth = 7;
+        cached_generator.generate_structure(reseeded);
+        cached_generator.generate_structure(deeper);
+        REQUIRE(cache->stats().misses == 3);
+    }
+    
+    SECTION("Memory cap evicts least recently used entries") {
+        for (uint32_t seed = 1; seed <= 8; ++seed) {
+            params.random_seed = seed;
+            cached_generator.generate_structure(params);
+        }
+        const auto full = cache->stats();
+        REQUIRE(full.entries == 8);
+        
+        cache->set_memory_limit(full.memory_bytes / 2);
+        REQUIRE(cache->stats().entries < 8);
+        REQUIRE(cache->stats().evictions > 0);
+        REQUIRE(cache->stats().memory_bytes <= full.memory_bytes / 2);
+        
+        // Seed 8 was used last, so it survives
+        cached_generator.generate_structure(params);
+        REQUIRE(cache->stats().hits == 1);
+    }
+}
+
+TEST_CASE("Incremental edit session", "[generator][edit]") {
+    auto params = TreePresets::oak();
+    params.random_seed = 77;
+    params.canvas_width = 256;
+    params.canvas_height = 256;
+    params.overall_scale = 2.0f;
+    
+    TreeGenerator32 generator(1);
+    auto session = generator.edit_session();
+    TreeGenerator32 reference(1);
+    
+    auto matches_full_generation = [&](const TreeParameters& edited) {
+        auto [expected, metadata] = reference.generate(edited);
+        const auto& pixels = session.pixels();
+        return pixels.width() == expected.width() && pixels.height() == expected.height() &&
+               std::equal(pixels.begin(), pixels.end(), expected.begin());
+    };
+    
+    REQUIRE(session.update(params) == DirtyFlags::All);
+    REQUIRE(matches_full_generation(params));
+    REQUIRE(session.update(params) == DirtyFlags::None);
+    
+    SECTION("Palette edits recolor without regrowing") {
+        params.leaves.base_colors[1] = Color{200, 40, 40};
+        REQUIRE(session.update(params) == (DirtyFlags::LeafColors | DirtyFlags::Raster));
+        REQUIRE(matches_full_generation(params));
+        
+        params.trunk.base_color = Color{60, 60, 60};
+        REQUIRE(session.update(params) == (DirtyFlags::BranchColors | DirtyFlags::Raster));
+        REQUIRE(matches_full_generation(params));
+        
+        params.season = Season::Autumn;
+        REQUIRE(session.update(params) == (DirtyFlags::LeafColors | DirtyFlags::Raster));
+        REQUIRE(matches_full_generation(params));
+    }
+    
+    SECTION("Leaf and canvas edits keep the skeleton") {
+        params.leaves.size_base = 6.0f;
+        REQUIRE(session.update(params) == (DirtyFlags::Leaves | DirtyFlags::Raster));
+        REQUIRE(matches_full_generation(params));
+        
+        params.season = Season::Winter;
+        REQUIRE(!has(session.update(params), DirtyFlags::Skeleton));
+        REQUIRE(matches_full_generation(params));
+        
+        params.canvas_width = 300;
+        REQUIRE(session.update(params) == (DirtyFlags::Placement | DirtyFlags::Raster));
+        REQUIRE(matches_full_generation(params));
+    }
+    
+    SECTION("Style and bark edits only redraw") {
+        params.render_style = RenderStyle::Smooth;
+        REQUIRE(session.update(params) == DirtyFlags::Raster);
+        REQUIRE(matches_full_generation(params));
+        
+        params.trunk.bark_detail = 0.8f;
+        REQUIRE(session.update(params) == DirtyFlags::Raster);
+        REQUIRE(matches_full_generation(params));
+        
+        params.trunk.texture_noise = 0.5f;
+        REQUIRE(session.update(params) == DirtyFlags::Raster);
+        REQUIRE(matches_full_generation(params));
+        
+        params.render_style = RenderStyle::Pixel;
+        REQUIRE(session.update(params) == DirtyFlags::Raster);
+        REQUIRE(matches_full_generation(params));
+    }
+    
+    SECTION("Branch edits rebuild everything") {
+        params.branches.branch_probability = 0.4f;
+        REQUIRE(has(session.update(params), DirtyFlags::Skeleton));
+        REQUIRE(matches_full_generation(params));
+        
+        params.random_seed = 78;
+        REQUIRE(has(session.update(params), DirtyFlags::Skeleton));
+        REQUIRE(matches_full_generation(params));
+    }
+}
+
+TEST_CASE("Generation instrumentation", "[generator][instrumentation]") {
+    auto params = TreePresets::pine();
+    params.random_seed = 31;
+    params.canvas_width = 96;
+    params.canvas_height = 96;
+    
+    TreeGenerator32 generator(1);
+    auto accumulator = std::make_shared<StatsAccumulator>();
+    generator.set_stats_sink(accumulator);
+    
+    SECTION("Counters describe the generated tree") {
+        auto [pixels, metadata] = generator.generate(params);
+        const GenerationStats& stats = metadata.stats;
+        
+        if constexpr (instrumentation_enabled) {
+            REQUIRE(stats.trees == 1);
+            REQUIRE(stats.lstring_length >= metadata.branch_count);
+            REQUIRE(stats.pixels_written >= stats.pixels_covered);
+            REQUIRE(stats.pixels_covered > 0);
+            REQUIRE(stats.pixels_covered <= pixels.size());
+            REQUIRE(stats.rng_draws > 0);
+            REQUIRE(stats.total_time_ns() > 0);
+            REQUIRE(accumulator->total().trees == 1);
+            
+            // The arenas are warm now, so the same tree needs fewer allocations
+            auto [again, repeat] = generator.generate(params);
+            REQUIRE(repeat.stats.allocations < stats.allocations);
+            REQUIRE(repeat.stats.rng_draws == stats.rng_draws);
+            REQUIRE(repeat.stats.pixels_written == stats.pixels_written);
+            
+            // Bands count the same writes as the serial painter
+            generator.set_render_threads(4);
+            auto [banded, band_metadata] = generator.generate(params);
+            REQUIRE(band_metadata.stats.pixels_written == stats.pixels_written);
+            REQUIRE(band_metadata.stats.pixels_covered == stats.pixels_covered);
+        } else {
+            REQUIRE(stats.trees == 0);
+            REQUIRE(stats.total_time_ns() == 0);
+            REQUIRE(accumulator->total().trees == 0);
+        }
+    }
+    
+    SECTION("Batch runs aggregate into one sink") {
+        std::vector<TreeParameters> batch(6, params);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            batch[i].random_seed = static_cast<uint32_t>(100 + i);
+        }
+        const auto results = generator.generate_batch(batch, 3);
+        
+        GenerationStats expected;
+        for (const auto& [pixels, metadata] : results) {
+            expected += metadata.stats;
+        }
+        const GenerationStats total = accumulator->total();
+        REQUIRE(total.trees == expected.trees);
+        REQUIRE(total.rng_draws == expected.rng_draws);
+        REQUIRE(total.pixels_written == expected.pixels_written);
+        REQUIRE(total.trees == (instrumentation_enabled ? batch.size() : 0));
+    }
+    
+    SECTION("Random draw counting") {
+        Random rng(9, 4);
+        const Random start = rng;
+        REQUIRE(rng.draws_since(start) == 0);
+        rng.next_uint64();
+        rng.advance(1000);
+        REQUIRE(rng.draws_since(start) == 1002);
+    }
+}
+
+TEST_CASE("Sprite atlas", "[generator][atlas]") {
+    std::vector<TreeParameters> forest;
+    const TreeParameters presets[] = {TreePresets::oak(), TreePresets::pine(), TreePresets::palm(), TreePresets::dead()};
+    for (uint32_t i = 0; i < 12; ++i) {
+        TreeParameters params = presets[i % 4];
+        params.random_seed = 500 + i;
+        params.canvas_width = 64 + 16 * static_cast<int>(i % 3);
+        params.canvas_height = 64 + 16 * static_cast<int>(i % 3);
+        forest.push_back(params);
+    }
+    const AtlasLayout layout{256, 256, 2};
+    
+    TreeGenerator32 generator(3);
+    auto [atlas, metadata] = generator.generate_atlas(forest, layout, 3);
+    REQUIRE(atlas.entries.size() == forest.size());
+    REQUIRE(metadata.size() == forest.size());
+    REQUIRE(!atlas.pages.empty());
+    
+    SECTION("Regions hold the cropped sprites") {
+        TreeGenerator32 reference(3);
+        for (size_t i = 0; i < forest.size(); ++i) {
+            auto [sprite, sprite_metadata] = reference.generate_cropped(forest[i]);
+            const AtlasEntry& entry = atlas.entries[i];
+            REQUIRE(metadata[i].branch_count == sprite_metadata.branch_count);
+            REQUIRE(entry.canvas_origin.x == sprite.origin.x);
+            REQUIRE(entry.canvas_origin.y == sprite.origin.y);
+            REQUIRE(entry.rect.width() == static_cast<int>(sprite.pixels.width()));
+            REQUIRE(entry.rect.height() == static_cast<int>(sprite.pixels.height()));
+            REQUIRE(entry.u1 == entry.rect.max.x / 256.0f);
+            
+            const auto& page = atlas.pages[entry.page];
+            bool same = true;
+            for (size_t y = 0; y < sprite.pixels.height(); ++y) {
+                for (size_t x = 0; x < sprite.pixels.width(); ++x) {
+                    same = same && page(entry.rect.min.x + x, entry.rect.min.y + y) == sprite.pixels(x, y);
+                }
+            }
+            REQUIRE(same);
+        }
+    }
+    
+    SECTION("Regions are padded apart") {
+        for (size_t a = 0; a < forest.size(); ++a) {
+            for (size_t b = a + 1; b < forest.size(); ++b) {
+                const Rect2Di& ra = atlas.entries[a].rect;
+                const Rect2Di& rb = atlas.entries[b].rect;
+                const bool apart = atlas.entries[a].page != atlas.entries[b].page ||
+                                   ra.max.x + 2 <= rb.min.x || rb.max.x + 2 <= ra.min.x ||
+                                   ra.max.y + 2 <= rb.min.y || rb.max.y + 2 <= ra.min.y;
+                REQUIRE(apart);
+            }
+        }
+    }
+    
+    SECTION("Packing batch output gives the same pages") {
+        TreeGenerator32 batch_generator(3);
+        const auto batch = batch_generator.generate_batch(forest, 2);
+        const auto packed = SpriteAtlas32::pack(batch, layout);
+        REQUIRE(packed.pages.size() == atlas.pages.size());
+        for (size_t page = 0; page < atlas.pages.size(); ++page) {
+            REQUIRE(std::equal(packed.pages[page].begin(), packed.pages[page].end(), atlas.pages[page].begin()));
+        }
+        
+        std::ostringstream out;
+        packed.write_uv_table(out);
+        const std::string table = out.str();
+        REQUIRE(std::count(table.begin(), table.end(), '\n') == static_cast<long>(forest.size() + 1));
+    }
+    
+    SECTION("Oversized sprites are rejected") {
+        REQUIRE_THROWS_AS(generator.generate_atlas(forest, AtlasLayout{32, 32, 0}), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Image export", "[export]") {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "pixeltree_export_test";
+    std::filesystem::create_directories(dir);
+    
+    TreeGenerator32 generator(404);
+    auto params = TreePresets::oak();
+    params.canvas_width = 48;
+    params.canvas_height = 40;
+    const auto [tree, metadata] = generator.generate(params);
+    
+    SECTION("QOI roundtrip is lossless") {
+        const auto encoded = ImageWriter::encode_qoi(tree);
+        REQUIRE(encoded.size() < tree.size() * 4);
+        const auto decoded = ImageWriter::decode_qoi(encoded.data(), encoded.size());
+        REQUIRE(decoded.width() == tree.width());
+        REQUIRE(decoded.height() == tree.height());
+        REQUIRE(std::equal(tree.begin(), tree.end(), decoded.begin()));
+        
+        // Every op kind: runs, index hits, small and luma diffs, alpha changes
+        PixelBuffer32 mixed(37, 5);
+        for (size_t i = 0; i < mixed.size(); ++i) {
+            const uint32_t step = static_cast<uint32_t>(i);
+            mixed.data()[i] = i % 7 == 0 ? 0x102030FF : (0x80808000 + step * 0x01030100) | (i % 11 < 3 ? 0x80 : 0xFF);
+        }
+        const std::string path = (dir / "mixed.qoi").string();
+        ImageWriter::write_qoi(path, mixed);
+        const auto loaded = ImageWriter::read_qoi(path);
+        REQUIRE(std::equal(mixed.begin(), mixed.end(), loaded.begin()));
+        
+        const uint8_t garbage[20] = {};
+        REQUIRE_THROWS_AS(ImageWriter::decode_qoi(garbage, sizeof(garbage)), std::runtime_error);
+    }
+    
+    SECTION("Raw roundtrip keeps the pixel type") {
+        const std::string path = (dir / "tree.raw").string();
+        ImageWriter::write(path, tree, ImageFormat::Raw);
+        const auto loaded = ImageWriter::read_raw<uint32_t>(path);
+        REQUIRE(loaded.width() == tree.width());
+        REQUIRE(std::equal(tree.begin(), tree.end(), loaded.begin()));
+        REQUIRE_THROWS_AS(ImageWriter::read_raw<uint8_t>(path), std::runtime_error);
+    }
+    
+    SECTION("PNG export") {
+        const std::string path = (dir / "tree.png").string();
+#ifdef PIXELTREE_HAS_PNG
+        for (bool adaptive_filters : {true, false}) {
+            ImageWriter::write_png(path, tree, PngOptions{6, adaptive_filters});
+            const auto decoded = ImageWriter::read_png(path);
+            REQUIRE(decoded.width() == tree.width());
+            REQUIRE(decoded.height() == tree.height());
+            REQUIRE(std::equal(tree.begin(), tree.end(), decoded.begin()));
+        }
+        
+        // Gray buffers come back with the gray level in R, G and B
+        PixelBuffer<uint8_t> gray(19, 7);
+        for (size_t i = 0; i < gray.size(); ++i) {
+            gray.data()[i] = static_cast<uint8_t>(i * 13);
+        }
+        ImageWriter::write_png(path, gray);
+        const auto expanded = ImageWriter::read_png(path);
+        REQUIRE(expanded.width() == gray.width());
+        for (size_t i = 0; i < gray.size(); ++i) {
+            const uint32_t level = gray.data()[i];
+            REQUIRE(expanded.data()[i] == (level << 24 | level << 16 | level << 8 | 0xFF));
+        }
+        
+        REQUIRE_THROWS_AS(ImageWriter::read_png((dir / "missing.png").string()), std::runtime_error);
+#else
+        REQUIRE_THROWS_AS(ImageWriter::write_png(path, tree), std::runtime_error);
+        REQUIRE_THROWS_AS(ImageWriter::read_png(path), std::runtime_error);
+#endif
+    }
+    
+    SECTION("Background exporter writes every tree and recycles buffers") {
+        ImageExporter<uint32_t> exporter(2, 1);
+        std::vector<TreeParameters> forest(5, params);
+        for (size_t i = 0; i < forest.size(); ++i) {
+            forest[i].random_seed = 900 + static_cast<uint32_t>(i);
+        }
+        
+        const auto path_for = [&dir](size_t index, const TreeMetadata&) {
+            return (dir / ("forest_" + std::to_string(index) + ".qoi")).string();
+        };
+        const auto exported = exporter.generate_and_export(generator, forest, path_for, ImageFormat::Qoi);
+        REQUIRE(exported.size() == forest.size());
+        REQUIRE(exporter.pool().pooled() > 0);
+        
+        for (size_t i = 0; i < forest.size(); ++i) {
+            const auto [expected, info] = generator.generate(forest[i]);
+            const auto loaded = ImageWriter::read_qoi(path_for(i, info));
+            REQUIRE(std::equal(expected.begin(), expected.end(), loaded.begin()));
+        }
+        
+        auto failed = exporter.submit((dir / "missing" / "tree.raw").string(), tree.clone(), ImageFormat::Raw);
+        REQUIRE_THROWS_AS(failed.get(), std::runtime_error);
+        exporter.wait();
+    }
+    
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Tree archive", "[archive]") {
+    TreeGenerator32 generator(2024);
+    std::vector<std::unique_ptr<TreeStructure>> forest;
+    TreeArchiveWriter writer;
+    for (const auto& preset : {TreePresets::oak(), TreePresets::pine(), TreePresets::palm(), TreePresets::dead()}) {
+        auto params = preset;
+        params.canvas_width = 56;
+        params.canvas_height = 64;
+        forest.push_back(generator.generate_structure(params));
+        writer.add(*forest.back());
+    }
+    
+    // Unique name, so concurrent test runs do not share the file
+    const std::filesystem::path path = std::filesystem::temp_directory_path() /
+        ("pixeltree_forest_" + std::to_string(std::random_device{}()) + ".ptsa");
+    writer.save(path.string());
+    
+    SECTION("Mapped trees render like the originals") {
+        const MappedTreeArchive archive(path.string());
+        REQUIRE(archive.size() == forest.size());
+        for (size_t i = 0; i < forest.size(); ++i) {
+            const TreeView view = archive[i];
+            REQUIRE(view.branch_count() == forest[i]->branch_count());
+            REQUIRE(view.leaf_cluster_count() == forest[i]->leaf_cluster_count());
+            
+            const auto expected = generator.render_structure(*forest[i]);
+            const auto rendered = generator.render_structure(view);
+            REQUIRE(std::equal(expected.begin(), expected.end(), rendered.begin()));
+            
+            const TreeStructure copy = view.to_structure();
+            const auto copied = generator.render_structure(copy);
+            REQUIRE(std::equal(expected.begin(), expected.end(), copied.begin()));
+            REQUIRE(copy.branches[0].first_child == forest[i]->branches[0].first_child);
+        }
+    }
+    
+    SECTION("Malformed archives are rejected") {
+        std::vector<uint8_t> bytes = writer.bytes();
+        REQUIRE(TreeArchiveView(bytes.data(), bytes.size()).size() == forest.size());
+        REQUIRE_THROWS_AS(TreeArchiveView(bytes.data(), bytes.size() - 1), std::runtime_error);
+        
+        bytes[4] ^= 0xFF;       // Version
+        REQUIRE_THROWS_AS(TreeArchiveView(bytes.data(), bytes.size()), std::runtime_error);
+        REQUIRE_THROWS_AS(TreeArchiveView(bytes.data(), 8), std::runtime_error);
+    }
+    
+    SECTION("Broken branch links, shapes and parameters are rejected") {
+        const std::vector<uint8_t> good = writer.bytes();
+        TreeArchiveHeader header;
+        std::memcpy(&header, good.data(), sizeof(header));
+        
+        const auto rejected = [&](auto&& corrupt) {
+            std::vector<uint8_t> bytes = good;
+            corrupt(reinterpret_cast<TreeArchiveRecord*>(bytes.data() + sizeof(header)),
+                    reinterpret_cast<Branch*>(bytes.data() + header.branch_offset),
+                    reinterpret_cast<LeafClusterRecord*>(bytes.data() + header.cluster_offset));
+            try {
+                TreeArchiveView view(bytes.data(), bytes.size());
+                return false;
+            } catch (const std::runtime_error&) {
+                return true;
+            }
+        };
+        
+        REQUIRE(!rejected([](auto*, auto*, auto*) {}));
+        REQUIRE(rejected([](auto*, Branch* branches, auto*) { branches[1].parent = 1; }));
+        REQUIRE(rejected([](auto*, Branch* branches, auto*) { branches[2].parent = 5; }));
+        REQUIRE(rejected([&](auto*, Branch* branches, auto*) {
+            branches[0].first_child = static_cast<uint32_t>(forest[0]->branch_count());    // Into the next tree
+        }));
+        REQUIRE(rejected([](auto*, Branch* branches, auto*) { branches[3].next_sibling = 1u << 30; }));
+        REQUIRE(rejected([](auto*, auto*, LeafClusterRecord* clusters) { clusters[0].shape = 9; }));
+        REQUIRE(rejected([](auto*, auto*, LeafClusterRecord* clusters) {
+            clusters[0].first_leaf = 0;
+            clusters[0].leaf_count = LeafCluster::max_leaves + 1;
+        }));
+        
+        REQUIRE(rejected([](TreeArchiveRecord* records, auto*, auto*) {
+            const int too_wide = 1 << 20;
+            std::memcpy(static_cast<void*>(&records[1].parameters.canvas_width), &too_wide, sizeof(too_wide));
+        }));
+        REQUIRE(rejected([](TreeArchiveRecord* records, auto*, auto*) {
+            const float nan = std::numeric_limits<float>::quiet_NaN();
+            std::memcpy(static_cast<void*>(&records[2].parameters.wind_strength), &nan, sizeof(nan));
+        }));
+        REQUIRE(rejected([](TreeArchiveRecord* records, auto*, auto*) {
+            const uint8_t unknown_type = 200;
+            std::memcpy(static_cast<void*>(&records[0].parameters.type), &unknown_type, sizeof(unknown_type));
+        }));
+    }
+    
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("LOD chain", "[generator][lod]") {
+    TreeGenerator32 generator(31);
+    auto params = TreePresets::oak();
+    params.canvas_width = 128;
+    params.canvas_height = 128;
+    params.random_seed = 5150;
+    
+    const auto chain = generator.generate_lods(params);
+    REQUIRE(chain.size() == 4);
+    
+    SECTION("Level 0 is the full render") {
+        const auto [full, metadata] = generator.generate(params);
+        REQUIRE(std::equal(full.begin(), full.end(), chain[0].first.begin()));
+        REQUIRE(chain[0].second.branch_count == metadata.branch_count);
+        REQUIRE(chain[0].second.random_seed == metadata.random_seed);
+    }
+    
+    SECTION("Levels halve the canvas and shed detail") {
+        for (size_t level = 1; level < chain.size(); ++level) {
+            const auto& [pixels, metadata] = chain[level];
+            REQUIRE(pixels.width() == 128u >> level);
+            REQUIRE(pixels.height() == 128u >> level);
+            REQUIRE(metadata.branch_count <= chain[level - 1].second.branch_count);
+            REQUIRE(metadata.leaf_count <= chain[level - 1].second.leaf_count);
+            REQUIRE(metadata.branch_count >= 1);
+            REQUIRE(std::any_of(pixels.begin(), pixels.end(), [](uint32_t pixel) { return pixel != 0; }));
+        }
+        REQUIRE(chain.back().second.branch_count < chain[0].second.branch_count);
+        REQUIRE(chain.back().second.leaf_count < chain[0].second.leaf_count);
+    }
+    
+    SECTION("Chains stop at the minimum canvas") {
+        params.canvas_width = 48;
+        REQUIRE(generator.generate_lods(params, LodOptions{8}).size() == 2);
+    }
+}
+
+TEST_CASE("Wind animation", "[generator][wind]") {
+    TreeGenerator32 generator(77);
+    auto params = TreePresets::pine();
+    params.canvas_width = 64;
+    params.canvas_height = 80;
+    params.random_seed = 1234;
+    params.wind_strength = 0.8f;
+    
+    WindOptions options;
+    options.frame_count = 6;
+    const auto [strip, metadata] = generator.generate_wind_frames(params, options);
+    REQUIRE(strip.frame_count == 6);
+    REQUIRE(strip.pixels.width() == 64u * 6);
+    REQUIRE(strip.pixels.height() == 80);
+    
+    SECTION("Every frame matches a full render of its pose") {
+        auto tree = generator.generate_structure(params);
+        const WindAnimator<uint32_t> animator(options);
+        TreeRenderer renderer;
+        TreeStructure posed{tree->parameters};
+        bool any_motion = false;
+        
+        for (size_t frame = 0; frame < strip.frame_count; ++frame) {
+            animator.pose(*tree, animator.frame_phase(frame), posed);
+            const auto expected = renderer.render(posed);
+            const Rect2Di rect = strip.frame_rect(frame);
+            for (int y = 0; y < rect.height(); ++y) {
+                REQUIRE(std::equal(&expected(0, y), &expected(0, y) + rect.width(),
+                                   &strip.pixels(static_cast<size_t>(rect.min.x), static_cast<size_t>(y))));
+            }
+            if (frame > 0) {
+                any_motion |= !std::equal(&strip.pixels(0, 0), &strip.pixels(0, 0) + strip.pixels.size() / 6,
+                                          &strip.pixels(static_cast<size_t>(rect.min.x), 0));
+            }
+        }
+        REQUIRE(any_motion);
+    }
+    
+    SECTION("A reused pose takes every attribute of the new tree") {
+        // Same branch and cluster counts, but other attributes and more leaves
+        Random rng(5);
+        TreeStructure first{params}, second{params};
+        first.add_branch(Branch({32.0f, 78.0f}, {32.0f, 50.0f}, 6.0f));
+        first.add_branch(Branch({32.0f, 50.0f}, {20.0f, 30.0f}, 3.0f, 1), 0);
+        first.leaf_clusters.push_back(LeafCluster({20.0f, 30.0f}, 6.0f, Color(0, 128, 0)));
+        first.leaf_clusters[0].generate_leaves(rng, 3);
+        second.add_branch(Branch({30.0f, 78.0f}, {34.0f, 48.0f}, 8.0f));
+        second.add_branch(Branch({34.0f, 48.0f}, {44.0f, 28.0f}, 2.0f, 1), 0);
+        second.branches[1].color = Color(200, 10, 10);
+        second.leaf_clusters.push_back(LeafCluster({44.0f, 28.0f}, 9.0f, Color(50, 200, 50)));
+        second.leaf_clusters[0].shape = LeafCluster::Shape::Scattered;
+        second.leaf_clusters[0].generate_leaves(rng, 12);
+        first.calculate_bounding_box();
+        second.calculate_bounding_box();
+        
+        const WindAnimator<uint32_t> animator(options);
+        const float phase = animator.frame_phase(2);
+        TreeStructure fresh{params}, reused{params};
+        animator.pose(second, phase, fresh);
+        animator.pose(first, phase, reused);
+        animator.pose(second, phase, reused);
+        
+        REQUIRE(reused.leaf_clusters[0].leaf_positions.size() == 12);
+        REQUIRE(reused.leaf_clusters[0].shape == LeafCluster::Shape::Scattered);
+        REQUIRE(reused.branches[0].thickness == 8.0f);
+        TreeRenderer renderer;
+        const auto expected = renderer.render(fresh);
+        const auto actual = renderer.render(reused);
+        REQUIRE(std::equal(expected.data(), expected.data() + expected.size(), actual.data()));
+    }
+    
+    SECTION("Only moving regions are redrawn") {
+        const size_t tiles = strip.tiles_redrawn[0];
+        REQUIRE(tiles == 4u * 5u);
+        for (size_t frame = 1; frame < strip.frame_count; ++frame) {
+            REQUIRE(strip.tiles_redrawn[frame] < tiles);   // The trunk base never moves
+        }
+        
+        params.wind_strength = 0.0f;
+        const auto [still, still_metadata] = generator.generate_wind_frames(params, options);
+        const auto [single, single_metadata] = generator.generate(params);
+        for (size_t frame = 0; frame < still.frame_count; ++frame) {
+            REQUIRE(still.tiles_redrawn[frame] == (frame == 0 ? tiles : 0));
+            for (int y = 0; y < 80; ++y) {
+                REQUIRE(std::equal(&single(0, y), &single(0, y) + 64, &still.pixels(frame * 64, y)));
+            }
+        }
+    }
+}
+
+namespace {
+
+// Fire-and-forget coroutine for awaiting service requests
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+DetachedTask await_tree(GeneratorService32& service, TreeParameters params,
+                        std::promise<GenerationOutcome<>>& done) {
+    done.set_value(co_await service.generate(params));
+}
+
+} // namespace
+
+TEST_CASE("Generator service", "[generator][service]") {
+    auto params = TreePresets::oak();
+    params.canvas_width = 48;
+    params.canvas_height = 48;
+    
+    std::mutex mutex;
+    std::vector<GenerationOutcome<>> outcomes;
+    auto collect = [&](GenerationOutcome<>&& outcome) {
+        std::lock_guard<std::mutex> lock(mutex);
+        outcomes.push_back(std::move(outcome));
+    };
+    
+    SECTION("Results match generate() with seeds in submission order") {
+        const TreeGenerator32 prototype(99);
+        GeneratorService32 service(prototype, 2, 4);
+        std::vector<RequestHandle> handles;
+        for (int i = 0; i < 6; ++i) {
+            handles.push_back(service.submit(params, collect));
+        }
+        service.wait_idle();
+        REQUIRE(outcomes.size() == 6);
+        
+        TreeGenerator32 reference = prototype;
+        std::sort(outcomes.begin(), outcomes.end(),
+                  [](const auto& a, const auto& b) { return a.request_id < b.request_id; });
+        for (size_t i = 0; i < outcomes.size(); ++i) {
+            REQUIRE(outcomes[i].request_id == handles[i].id());
+            REQUIRE(outcomes[i].status == RequestStatus::Completed);
+            REQUIRE(handles[i].finished());
+            const auto [expected, metadata] = reference.generate(params);
+            REQUIRE(outcomes[i].metadata.random_seed == metadata.random_seed);
+            REQUIRE(std::equal(expected.begin(), expected.end(), outcomes[i].pixels.begin()));
+            service.recycle(std::move(outcomes[i].pixels));
+        }
+    }
+    
+    SECTION("Priorities, cancellation and backpressure") {
+        GeneratorService32 service(TreeGenerator32(5), 1, 3);
+        
+        // Hold the only worker inside the first callback
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        service.submit(params, [&, opened](GenerationOutcome<>&& outcome) {
+            opened.wait();
+            collect(std::move(outcome));
+        });
+        while (service.pending() != 0) {
+            std::this_thread::yield();
+        }
+        
+        const RequestHandle low = service.submit(params, collect, 0);
+        RequestHandle dropped = service.submit(params, collect, 5);
+        const RequestHandle high = service.submit(params, collect, 10);
+        REQUIRE_FALSE(service.try_submit(params, collect).has_value());
+        
+        dropped.cancel();
+        const auto late = service.try_submit(params, collect, -1);     // Takes the cancelled one's slot
+        REQUIRE(late.has_value());
+        
+        gate.set_value();
+        service.wait_idle();
+        REQUIRE(outcomes.size() == 5);
+        REQUIRE(outcomes[0].request_id == dropped.id());                  // Reported when purged
+        REQUIRE(outcomes[0].status == RequestStatus::Cancelled);
+        REQUIRE(outcomes[0].pixels.empty());
+        REQUIRE(outcomes[1].status == RequestStatus::Completed);
+        REQUIRE(outcomes[2].request_id == high.id());
+        REQUIRE(outcomes[3].request_id == low.id());
+        REQUIRE(outcomes[4].request_id == late->id());
+        
+        service.shutdown();
+        REQUIRE_THROWS_AS(service.submit(params, collect), std::runtime_error);
+    }
+    
+    SECTION("Requests can be awaited") {
+        GeneratorService32 service(TreeGenerator32(8), 2);
+        params.random_seed = 4321;
+        std::promise<GenerationOutcome<>> done;
+        auto result = done.get_future();
+        await_tree(service, params, done);
+        
+        const GenerationOutcome<> outcome = result.get();
+        REQUIRE(outcome.status == RequestStatus::Completed);
+        REQUIRE(outcome.metadata.random_seed == 4321);
+        REQUIRE(outcome.pixels.width() == 48);
+    }
+}
+
+TEST_CASE("Smooth rendering", "[renderer][antialias]") {
+    using simd::PixelOperations;
+    
+    SECTION("Coverage mixing") {
+        REQUIRE(PixelOperations::coverage_pixel(0x10203040u, 0xAABBCCFFu, 0) == 0x10203040u);
+        REQUIRE(PixelOperations::coverage_pixel(0x10203040u, 0xAABBCCFFu, 255) == 0xAABBCCFFu);
+        REQUIRE(PixelOperations::coverage_pixel(0x00000000u, 0x336699FFu, 128) == 0x33669980u);
+        REQUIRE(PixelOperations::coverage_pixel(0x000000FFu, 0xFF0000FFu, 51) == 0x330000FFu);
+        REQUIRE(PixelOperations::coverage_pixel(0xFF000080u, 0x0000FF80u, 128) == 0x7F008080u);
+    }
+    
+    SECTION("Disc coverage adds up to its area") {
+        PixelBuffer32 buffer(24, 24);
+        buffer.clear(0);
+        SpanRasterizer::blend_disc(RasterTarget<uint32_t>::from(buffer), Point2Df{11.3f, 10.6f}, 5.5f, 0x40A040FFu);
+        
+        double covered = 0.0;
+        for (uint32_t pixel : buffer) {
+            covered += (pixel & 0xFF) / 255.0;
+            REQUIRE(((pixel & 0xFF) == 0 || (pixel & 0xFFFFFF00u) == 0x40A04000u));
+        }
+        REQUIRE(std::abs(covered - 3.14159265 * 5.5 * 5.5) < 0.01 * covered);
+        REQUIRE(buffer(11, 11) == 0x40A040FFu);
+        REQUIRE(buffer(0, 0) == 0u);
+    }
+    
+    auto params = TreePresets::oak();
+    params.canvas_width = 320;
+    params.canvas_height = 240;
+    params.overall_scale = 3.0f;
+    params.random_seed = 808;
+    params.trunk.bark_detail = 0.6f;
+    params.render_style = RenderStyle::Smooth;
+    
+    TreeGenerator32 generator(3);
+    auto tree = generator.generate_structure(params);
+    TreeRenderer renderer;
+    const auto smooth = renderer.render(*tree);
+    
+    SECTION("Edges are anti-aliased and the trunk is textured") {
+        tree->parameters.render_style = RenderStyle::Pixel;
+        const auto hard = renderer.render(*tree);
+        REQUIRE_FALSE(std::equal(smooth.begin(), smooth.end(), hard.begin()));
+        
+        auto partial = [](const PixelBuffer32& buffer) {
+            return std::count_if(buffer.begin(), buffer.end(), [](uint32_t p) { return (p & 0xFF) != 0 && (p & 0xFF) != 255; });
+        };
+        REQUIRE(partial(smooth) > partial(hard));
+        
+        // Pixels along the trunk axis vary in color under bark texture
+        const Branch& trunk = tree->branches[0];
+        std::vector<uint32_t> axis;
+        for (float t = 0.2f; t <= 0.8f; t += 0.05f) {
+            const Point2Df p = trunk.start_point + (trunk.end_point - trunk.start_point) * t;
+            axis.push_back(smooth(static_cast<size_t>(std::lround(p.x)), static_cast<size_t>(std::lround(p.y))));
+        }
+        std::sort(axis.begin(), axis.end());
+        REQUIRE(std::unique(axis.begin(), axis.end()) - axis.begin() > 1);
+    }
+    
+    SECTION("Bands, tiles and archive views draw the same pixels") {
+        for (size_t threads : {2, 5}) {
+            const auto banded = BandRenderer(threads, 7).render(*tree);
+            REQUIRE(std::equal(banded.begin(), banded.end(), smooth.begin()));
+        }
+        
+        PixelBuffer32 assembled(smooth.width(), smooth.height());
+        TiledRenderer<uint32_t>(64, 3).render(*tree, [&](const auto& tile, const PixelBuffer32& pixels) {
+            assembled.blit(pixels, tile.rect.min);
+        });
+        REQUIRE(std::equal(assembled.begin(), assembled.end(), smooth.begin()));
+        
+        TreeArchiveWriter writer;
+        writer.add(*tree);
+        const auto bytes = writer.bytes();
+        const TreeArchiveView archive(bytes.data(), bytes.size());
+        PixelBuffer32 from_view;
+        renderer.render_into(from_view, archive[0]);
+        REQUIRE(std::equal(from_view.begin(), from_view.end(), smooth.begin()));
+    }
+}
+
+TEST_CASE("Fixed-point geometry", "[math][fixed]") {
+    SECTION("Integer sincos and square root") {
+        constexpr double unit = 1 << FixedPoint::unit_bits;
+        for (int i = -7200; i <= 7200; ++i) {
+            const FixedSinCos sc = FixedPoint::sincos_degrees(int64_t{i} * 65536 / 10);
+            const double radians = (int64_t{i} * 65536 / 10) / 65536.0 * 3.14159265358979323846 / 180.0;
+            REQUIRE(std::abs(sc.sin / unit - std::sin(radians)) < 1e-8);
+            REQUIRE(std::abs(sc.cos / unit - std::cos(radians)) < 1e-8);
+        }
+        REQUIRE(FixedPoint::sincos_degrees(int64_t{90} << 16).sin == 1 << FixedPoint::unit_bits);
+        REQUIRE(FixedPoint::sincos_degrees(int64_t{90} << 16).cos == 0);
+        REQUIRE(FixedPoint::sincos_degrees(int64_t{-180} << 16).cos == -(1 << FixedPoint::unit_bits));
+        
+        for (uint64_t root : {0ull, 1ull, 255ull, 65536ull, 3037000499ull}) {
+            REQUIRE(FixedPoint::isqrt(root * root) == root);
+            if (root > 0) {
+                REQUIRE(FixedPoint::isqrt(root * root - 1) == root - 1);
+            }
+        }
+        REQUIRE(FixedPoint::floor_div(-7, 2) == -4);
+        REQUIRE(FixedPoint::ceil_div(-7, 2) == -3);
+        REQUIRE(FixedPoint::ceil_div(7, -2) == -3);
+    }
+    
+    SECTION("Integer fills match the float ones on whole pixels") {
+        PixelBuffer32 fixed(40, 40), spans(40, 40);
+        fixed.clear(0);
+        spans.clear(0);
+        const auto a = RasterTarget<uint32_t>::from(fixed);
+        const auto b = RasterTarget<uint32_t>::from(spans);
+        FixedRasterizer::fill_disc(a, Point2Df{12.0f, 15.0f}, 9.0f, 0xFFu);
+        SpanRasterizer::fill_disc(b, Point2Df{12.0f, 15.0f}, 9.0f, 0xFFu);
+        FixedRasterizer::fill_ellipse(a, Point2Df{30.0f, 8.0f}, 6.0f, 4.0f, 0xFF00FFu);
+        SpanRasterizer::fill_ellipse(b, Point2Df{30.0f, 8.0f}, 6.0f, 4.0f, 0xFF00FFu);
+        FixedRasterizer::fill_capsule(a, Point2Df{5.0f, 35.0f}, Point2Df{35.0f, 35.0f}, 2.0f, 0xFF0000FFu);
+        SpanRasterizer::fill_capsule(b, Point2Df{5.0f, 35.0f}, Point2Df{35.0f, 35.0f}, 2.0f, 0xFF0000FFu);
+        REQUIRE(std::equal(fixed.begin(), fixed.end(), spans.begin()));
+        
+        // Slanted capsules never reach past the float shape
+        fixed.clear(0);
+        spans.clear(0);
+        FixedRasterizer::fill_capsule(a, Point2Df{3.3f, 4.7f}, Point2Df{31.1f, 27.9f}, 2.5f, 0xFFu);
+        SpanRasterizer::fill_capsule(b, Point2Df{3.3f, 4.7f}, Point2Df{31.1f, 27.9f}, 2.5f, 0xFFu);
+        size_t outside = 0, missing = 0;
+        for (size_t i = 0; i < fixed.size(); ++i) {
+            outside += fixed.data()[i] != 0 && spans.data()[i] == 0;
+            missing += fixed.data()[i] == 0 && spans.data()[i] != 0;
+        }
+        REQUIRE(outside == 0);
+        REQUIRE(missing <= 2);
+    }
+    
+    auto params = TreePresets::pine();
+    params.canvas_width = 160;
+    params.canvas_height = 160;
+    params.random_seed = 4242;
+    
+    FixedTreeGenerator32 generator(5);
+    auto tree = generator.generate_structure(params);
+    auto on_grid = [](float value) { return value * 256.0f == std::round(value * 256.0f); };
+    
+    SECTION("Trees sit on the 24.8 grid and stay close to the float ones") {
+        const auto float_tree = TreeGenerator32(5).generate_structure(params);
+        REQUIRE(tree->branch_count() == float_tree->branch_count());
+        REQUIRE(tree->leaf_cluster_count() == float_tree->leaf_cluster_count());
+        for (size_t i = 0; i < tree->branches.size(); ++i) {
+            const Branch& branch = tree->branches[i];
+            REQUIRE((on_grid(branch.start_point.x) && on_grid(branch.start_point.y) &&
+                     on_grid(branch.end_point.x) && on_grid(branch.end_point.y) && on_grid(branch.thickness)));
+            REQUIRE(std::abs(branch.end_point.x - float_tree->branches[i].end_point.x) < 0.05f);
+            REQUIRE(std::abs(branch.end_point.y - float_tree->branches[i].end_point.y) < 0.05f);
+        }
+        for (const LeafCluster& cluster : tree->leaf_clusters) {
+            REQUIRE(on_grid(cluster.size));
+            REQUIRE_FALSE(cluster.leaf_positions.empty());
+            for (const Point2Df& leaf : cluster.leaf_positions) {
+                REQUIRE((on_grid(leaf.x) && on_grid(leaf.y)));
+            }
+        }
+    }
+    
+    SECTION("Pixels are pinned and every render path agrees") {
+        const auto [pixels, metadata] = generator.generate(params);
+        uint64_t hash = 1469598103934665603ull;
+        for (uint32_t pixel : pixels) {
+            hash = (hash ^ pixel) * 1099511628211ull;
+        }
+        // Integer-only output: the same value on every platform and compiler
+        REQUIRE(hash == 0xdb5a6d63b061447full);
+        
+        const auto banded = BasicBandRenderer<FixedGeometry>(3, 9).render(*tree);
+        REQUIRE(std::equal(banded.begin(), banded.end(), pixels.begin()));
+        
+        PixelBuffer32 assembled(pixels.width(), pixels.height());
+        TiledRenderer<uint32_t, FixedGeometry>(32, 2).render(*tree, [&](const auto& tile, const PixelBuffer32& tile_pixels) {
+            assembled.blit(tile_pixels, tile.rect.min);
+        });
+        REQUIRE(std::equal(assembled.begin(), assembled.end(), pixels.begin()));
+        
+        // Cached skeletons are kept apart from the float ones
+        auto cache = std::make_shared<StructureCache>();
+        TreeGenerator32 float_generator(5);
+        float_generator.set_structure_cache(cache);
+        generator.set_structure_cache(cache);
+        float_generator.generate(params);
+        const auto cached = generator.generate(params).first;
+        REQUIRE(std::equal(cached.begin(), cached.end(), pixels.begin()));
+        
+        FixedTreeGenerator32::EditSession session(generator);
+        session.update(params);
+        REQUIRE(std::equal(session.pixels().begin(), session.pixels().end(), pixels.begin()));
+        params.leaves.color_variation = 0.3f;
+        session.update(params);
+        const auto recolored = generator.generate(params).first;
+        REQUIRE(std::equal(session.pixels().begin(), session.pixels().end(), recolored.begin()));
+    }
+}
+
+TEST_CASE("Seed search", "[generator][search]") {
+    auto params = TreePresets::oak();
+    params.branches.branch_probability = 0.5f;
+    
+    SearchConstraints constraints;
+    constraints.min_branches = 12;
+    constraints.min_aspect = 0.6f;
+    constraints.max_aspect = 1.6f;
+    constraints.min_leaf_coverage = 0.1f;
+    
+    TreeGenerator32 generator(21);
+    const auto result = generator.search_seeds(params, 1000, 300, constraints, 1000, 4);
+    
+    SECTION("Accepted trees match the constraints and generate()") {
+        REQUIRE(result.examined == 300);
+        REQUIRE(result.rejected_skeleton > 0);
+        REQUIRE(result.accepted > 0);
+        REQUIRE(result.accepted == result.trees.size());
+        REQUIRE(result.rejected_skeleton + result.rejected_structure + result.accepted == result.examined);
+        
+        uint32_t previous_seed = 0;
+        for (const auto& [pixels, metadata] : result.trees) {
+            REQUIRE(metadata.random_seed > previous_seed);
+            previous_seed = metadata.random_seed;
+            
+            TreeParameters seeded = params;
+            seeded.random_seed = metadata.random_seed;
+            const auto tree = TreeGenerator32(21).generate_structure(seeded);
+            REQUIRE(constraints.accepts(StructureMetrics::of(*tree)));
+            
+            const auto expected = TreeGenerator32(21).generate(seeded).first;
+            REQUIRE(std::equal(pixels.begin(), pixels.end(), expected.begin()));
+        }
+    }
+    
+    SECTION("The result does not depend on the worker count") {
+        const auto serial = TreeGenerator32(21).search_seeds(params, 1000, 300, constraints, 1000, 1);
+        REQUIRE(serial.accepted == result.accepted);
+        REQUIRE(serial.rejected_skeleton == result.rejected_skeleton);
+        for (size_t i = 0; i < serial.trees.size(); ++i) {
+            REQUIRE(serial.trees[i].second.random_seed == result.trees[i].second.random_seed);
+        }
+    }
+    
+    SECTION("Searches stop after the block that meets max_results") {
+        SearchConstraints any;
+        const auto first = generator.search_seeds(params, 0, 10000, any, 3);
+        REQUIRE(first.examined == TreeGenerator32::search_block - 1);   // Seed 0 is skipped
+        REQUIRE(first.trees.size() == 3);
+        REQUIRE(first.trees[0].second.random_seed == 1);
+        REQUIRE(first.trees[2].second.random_seed == 3);
+        
+        any.accept = [](const StructureMetrics& metrics) { return metrics.leaf_cluster_count == 0; };
+        const auto none = generator.search_seeds(params, 1, 40, any);
+        REQUIRE(none.trees.empty());
+        REQUIRE(none.rejected_structure == 40);
+    }
+    
+    SECTION("Screening leaves the structure cache alone") {
+        auto cache = std::make_shared<StructureCache>();
+        TreeGenerator32 cached_generator(21);
+        cached_generator.set_structure_cache(cache);
+        
+        TreeParameters working = params;
+        working.random_seed = 7;
+        cached_generator.generate(working);
+        const auto before = cache->stats();
+        
+        const auto cached = cached_generator.search_seeds(params, 1000, 300, constraints, 1000, 4);
+        const auto after = cache->stats();
+        REQUIRE(after.hits == before.hits);
+        REQUIRE(after.misses == before.misses);
+        REQUIRE(after.entries == 1);
+        REQUIRE(cached.accepted == result.accepted);
+        REQUIRE(std::equal(cached.trees.front().first.begin(), cached.trees.front().first.end(),
+                           result.trees.front().first.begin()));
+        
+        cached_generator.generate(working);
+        REQUIRE(cache->stats().hits == before.hits + 1);
+    }
+}
+
+namespace {
+
+// Pixels of a capsule drawn into `pixels` (canvas position `origin`) that
+// disagree with a double-precision distance test of their centers. Centers
+// within 1e-3 of the outline may go either way.
+size_t capsule_mismatches(const PixelBuffer32& pixels, Point2Di origin, Point2Df a, Point2Df b, float radius,
+                          uint32_t ink) {
+    const double dx = static_cast<double>(b.x) - a.x;
+    const double dy = static_cast<double>(b.y) - a.y;
+    const double length_sq = dx * dx + dy * dy;
+    size_t mismatches = 0;
+    for (size_t y = 0; y < pixels.height(); ++y) {
+        for (size_t x = 0; x < pixels.width(); ++x) {
+            const double px = static_cast<double>(origin.x) + static_cast<double>(x) - a.x;
+            const double py = static_cast<double>(origin.y) + static_cast<double>(y) - a.y;
+            const double t = length_sq > 0.0 ? std::clamp((px * dx + py * dy) / length_sq, 0.0, 1.0) : 0.0;
+            const double distance = std::hypot(px - t * dx, py - t * dy);
+            const bool inside = distance <= radius;
+            if ((pixels(x, y) == ink) != inside && std::abs(distance - radius) > 1e-3) {
+                ++mismatches;
+            }
+        }
+    }
+    return mismatches;
+}
+
+} // namespace
+
+TEST_CASE("Capsule rasterization", "[renderer][rasterizer]") {
+    constexpr uint32_t ink = 0xFF0000FFu;
+    PixelBuffer32 canvas(64, 48);
+    canvas.clear(0);
+    const auto target = RasterTarget<uint32_t>::from(canvas);
+    
+    SECTION("Covers exactly the pixel centers within the radius") {
+        const struct { Point2Df a, b; float radius; } capsules[] = {
+            {{10.0f, 10.0f}, {50.0f, 10.0f}, 3.0f},         // Horizontal, integer geometry
+            {{20.3f, 4.6f}, {20.3f, 40.2f}, 2.7f},          // Vertical
+            {{5.5f, 40.1f}, {58.7f, 6.9f}, 4.2f},           // Shallow diagonal
+            {{50.2f, 44.8f}, {47.9f, 3.3f}, 1.3f},          // Steep, drawn bottom to top
+            {{31.7f, 22.2f}, {34.1f, 25.9f}, 9.6f},         // Short and fat: mostly end caps
+        };
+        for (const auto& capsule : capsules) {
+            canvas.clear(0);
+            SpanRasterizer::fill_capsule(target, capsule.a, capsule.b, capsule.radius, ink);
+            REQUIRE(capsule_mismatches(canvas, {}, capsule.a, capsule.b, capsule.radius, ink) == 0);
+            
+            // Either direction draws the same pixels
+            PixelBuffer32 reversed(canvas.width(), canvas.height());
+            reversed.clear(0);
+            SpanRasterizer::fill_capsule(RasterTarget<uint32_t>::from(reversed), capsule.b, capsule.a,
+                                         capsule.radius, ink);
+            REQUIRE(capsule_mismatches(reversed, {}, capsule.a, capsule.b, capsule.radius, ink) == 0);
+        }
+    }
+    
+    SECTION("Diagonal capsules are symmetric about their axis") {
+        // 45 degrees through pixel centers: transposing the picture maps the capsule onto itself
+        SpanRasterizer::fill_capsule(target, Point2Df{6.0f, 6.0f}, Point2Df{40.0f, 40.0f}, 3.5f, ink);
+        REQUIRE(capsule_mismatches(canvas, {}, {6.0f, 6.0f}, {40.0f, 40.0f}, 3.5f, ink) == 0);
+        size_t asymmetric = 0;
+        for (size_t y = 0; y < 48; ++y) {
+            for (size_t x = 0; x < 48; ++x) {
+                asymmetric += canvas(x, y) != canvas(y, x);
+            }
+        }
+        REQUIRE(asymmetric == 0);
+        REQUIRE(canvas(23, 23) == ink);
+        REQUIRE(canvas(25, 21) == ink);         // 2.83 from the axis
+        REQUIRE(canvas(27, 19) == 0);           // 5.66 from the axis
+    }
+    
+    SECTION("Zero-length capsules are discs") {
+        SpanRasterizer::fill_capsule(target, Point2Df{20.4f, 18.7f}, Point2Df{20.4f, 18.7f}, 6.3f, ink);
+        PixelBuffer32 disc(canvas.width(), canvas.height());
+        disc.clear(0);
+        SpanRasterizer::fill_disc(RasterTarget<uint32_t>::from(disc), Point2Df{20.4f, 18.7f}, 6.3f, ink);
+        REQUIRE(std::equal(canvas.begin(), canvas.end(), disc.begin()));
+        REQUIRE(capsule_mismatches(canvas, {}, {20.4f, 18.7f}, {20.4f, 18.7f}, 6.3f, ink) == 0);
+        
+        // A point of radius zero on a pixel center is that pixel
+        canvas.clear(0);
+        SpanRasterizer::fill_capsule(target, Point2Df{9.0f, 7.0f}, Point2Df{9.0f, 7.0f}, 0.0f, ink);
+        REQUIRE(std::count(canvas.begin(), canvas.end(), ink) == 1);
+        REQUIRE(canvas(9, 7) == ink);
+    }
+    
+    SECTION("Hairlines cover only the centers they pass within reach of") {
+        // On a row of centers: exactly that row, end to end
+        SpanRasterizer::fill_capsule(target, Point2Df{4.0f, 12.0f}, Point2Df{30.0f, 12.0f}, 0.0f, ink);
+        REQUIRE(std::count(canvas.begin(), canvas.end(), ink) == 27);
+        REQUIRE(std::all_of(&canvas(4, 12), &canvas(4, 12) + 27, [](uint32_t pixel) { return pixel == ink; }));
+        
+        // Between two rows with less than half a pixel of reach: nothing
+        canvas.clear(0);
+        SpanRasterizer::fill_capsule(target, Point2Df{4.0f, 20.5f}, Point2Df{30.0f, 20.5f}, 0.4f, ink);
+        REQUIRE(std::count(canvas.begin(), canvas.end(), ink) == 0);
+        
+        // Thin diagonal: one or two pixels per row, never a gap
+        canvas.clear(0);
+        SpanRasterizer::fill_capsule(target, Point2Df{3.2f, 2.1f}, Point2Df{41.7f, 37.4f}, 0.6f, ink);
+        REQUIRE(capsule_mismatches(canvas, {}, {3.2f, 2.1f}, {41.7f, 37.4f}, 0.6f, ink) == 0);
+        for (size_t y = 3; y <= 36; ++y) {
+            const auto row = std::count(&canvas(0, y), &canvas(0, y) + canvas.width(), ink);
+            REQUIRE(row >= 1);
+            REQUIRE(row <= 2);
+        }
+    }
+    
+    SECTION("Clipped at every edge of the target") {
+        // Crosses all four edges of the canvas
+        const Point2Df a{-9.5f, 30.2f}, b{71.3f, 14.8f};
+        const float radius = 32.0f;
+        SpanRasterizer::fill_capsule(target, a, b, radius, ink);
+        REQUIRE(capsule_mismatches(canvas, {}, a, b, radius, ink) == 0);
+        REQUIRE(canvas(0, 0) == ink);
+        REQUIRE(canvas(63, 47) == ink);
+        
+        // A window into a larger buffer: nothing outside the clip is touched
+        PixelBuffer32 framed(40, 30);
+        framed.clear(0x12345678u);
+        const auto window = RasterTarget<uint32_t>::from(framed, Point2Di{8, 6}).clipped(Rect2Di{{13, 9}, {41, 31}});
+        SpanRasterizer::fill_capsule(window, a, b, radius, ink);
+        for (size_t y = 0; y < framed.height(); ++y) {
+            for (size_t x = 0; x < framed.width(); ++x) {
+                const bool clipped_in = x >= 5 && x < 33 && y >= 3 && y < 25;
+                const uint32_t expected = clipped_in ? canvas(x + 8, y + 6) : 0x12345678u;
+                REQUIRE(framed(x, y) == expected);
+            }
+        }
+        
+        // Entirely outside: no pixel written
+        canvas.clear(0);
+        SpanRasterizer::fill_capsule(target, Point2Df{-30.0f, -5.0f}, Point2Df{-6.0f, 70.0f}, 5.5f, ink);
+        SpanRasterizer::fill_capsule(target, Point2Df{10.0f, 60.0f}, Point2Df{50.0f, 53.0f}, 4.0f, ink);
+        REQUIRE(std::count(canvas.begin(), canvas.end(), ink) == 0);
+    }
+}